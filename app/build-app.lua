@@ -35,4 +35,7 @@ project "App"
        defines { "RELEASE" }
        runtime "Release"
        optimize "On"
-       symbols "On"
\ No newline at end of file
+       symbols "On"
+
+   filter "options:engine-stats"
+       defines { "GAME_ENABLE_STATS" }
@@ -1,6 +1,8 @@
 #include "App.h"
 
+#include <fstream>
 #include <iostream>
+#include <iterator>
 #include <sstream>
 
 COMMAND_TYPE CHAR_TO_CMD_TYPE(const char c)
@@ -12,8 +14,10 @@ COMMAND_TYPE CHAR_TO_CMD_TYPE(const char c)
 	case 'm': return COMMAND_TYPE::MOVE;
 	case 'f': return COMMAND_TYPE::FIND;
 	case 's': return COMMAND_TYPE::SAVE;
+	case 'l': return COMMAND_TYPE::LOAD;
 	case 'u': return COMMAND_TYPE::UNDO;
 	case 'r': return COMMAND_TYPE::RESIZE;
+	case 't': return COMMAND_TYPE::STATS;
 	default: return COMMAND_TYPE::UNKNOWN;
 	}
 }
@@ -28,6 +32,7 @@ App::App() :
         m_quit = true;
         return;
     }
+    m_game->add_observer(this);
     // Init widgets
     m_board = std::make_unique<CharBoard>(1, 1, m_size, "../res", false, true, true);
 	m_board_border = std::make_unique<CharBorder>(0,0,m_board->get_width()+2, m_board->get_height()+2);
@@ -48,6 +53,21 @@ App::App() :
     m_display->render();
 }
 
+App::~App()
+{
+    if (m_game) m_game->remove_observer(this);
+}
+
+void App::on_board_event(const BoardEvent& event)
+{
+	if (event.type == BoardEventType::RESET) return;
+	std::array<TileP, GAME_MAX_CHANGED_TILES> tiles;
+	for (int i = 0; i < event.tile_count; i++) {
+		tiles[i] = TileP{ bindex_to_position(event.tiles[i].index), event.tiles[i].piece, event.tiles[i].color };
+	}
+	m_board->draw_delta(m_display.get(), std::span<const TileP>(tiles.data(), event.tile_count));
+}
+
 void App::run()
 {
     std::string cmd;
@@ -66,6 +86,7 @@ void App::run()
 void App::exec_cmd(const std::string& line)
 {
 	m_iobox->push(line);
+	push_save_results();
 	Command cmd = parse_command(line);
 	switch (cmd.type) {
 
@@ -93,6 +114,11 @@ void App::exec_cmd(const std::string& line)
 	case COMMAND_TYPE::SAVE:
 		exec_cmd_save(cmd.arg);
 		break;
+
+	case COMMAND_TYPE::LOAD:
+		exec_cmd_load(cmd.arg);
+		break;
+
 	case COMMAND_TYPE::UNDO:
 		exec_cmd_undo();
 		break;
@@ -105,6 +131,10 @@ void App::exec_cmd(const std::string& line)
 		exec_cmd_resize(cmd.arg);
 		break;
 
+	case COMMAND_TYPE::STATS:
+		exec_cmd_stats(cmd.arg);
+		break;
+
 	default:
 		m_iobox->push("Invalid Command");
 		m_iobox->draw(m_display.get());
@@ -128,12 +158,10 @@ void App::exec_cmd_move(const std::string& arg)
 		break;
 
 	case GameState::VALID_MOVE:
-		m_board->draw_delta(m_display.get(), m_game->get_new_tiles_pos());
 		m_active_mlist->draw_push(m_display.get(), m_game->get_last_move_str());
 		break;
 
 	case GameState::GAME_HAS_ENDED:
-		m_board->draw_delta(m_display.get(), m_game->get_new_tiles_pos());
 		m_active_mlist->draw_push(m_display.get(), m_game->get_last_move_str());
 		push_game_end_message(m_game->get_ending_game_state());
 		break;
@@ -153,7 +181,8 @@ void App::exec_cmd_new_game(const std::string& arg)
 		m_board->draw(m_display.get(),m_game->get_all_tiles_pos());
 	}
 	else {
-		m_iobox->push("Creating new game failed!");
+		const FenResult result = m_game->get_fen_result();
+		m_iobox->push("Creating new game failed! " + std::string(fen_error_to_string(result.error)) + " at " + std::to_string(result.offset));
 	}
 	if (m_game->get_active_color().IsBlack()) {
 		m_active_mlist->push("");
@@ -165,14 +194,12 @@ void App::exec_cmd_new_game(const std::string& arg)
 
 void App::exec_cmd_undo()
 {
-	const std::vector<TileP> v = m_game->get_reverse_new_tiles_pos();
-	if (v.empty()) {
+	if (m_game->get_ply() == 0) {
 		m_iobox->push("Undo not available!");
 		m_iobox->draw(m_display.get());
 		return;
 	}
 	m_game->undo();
-	m_board->draw_delta(m_display.get(), v);
 	m_active_mlist->draw_pop(m_display.get());
 	m_iobox->push("undo successful!");
 	m_iobox->draw(m_display.get());
@@ -218,25 +245,76 @@ void App::exec_cmd_find(const std::string& arg)
 	return;
 }
 
+/// <summary>
+/// saves as pgn if fname ends with .pgn, else in the binary format.
+/// The file is written in the background, the result is reported with the next command.
+/// </summary>
 void App::exec_cmd_save(const std::string& fname)
 {
-	std::ofstream file(fname);
+	if (fname.empty()) {
+		m_iobox->push("Missing file name!");
+		m_iobox->draw(m_display.get());
+		return;
+	}
+	const bool is_pgn = fname.size() >= 4 && fname.compare(fname.size() - 4, 4, ".pgn") == 0;
+	std::string data;
+	if (is_pgn) data = write_game_pgn(*m_game);
+	else if (!write_game_binary(*m_game, {}, data)) {
+		m_iobox->push("Game does not fit the binary format, save as .pgn");
+		m_iobox->draw(m_display.get());
+		return;
+	}
+	m_save_writer.save(fname, std::move(data));
+	m_iobox->push("Saving game to " + fname);
+	m_iobox->draw(m_display.get());
+	return;
+}
+
+void App::exec_cmd_load(const std::string& fname)
+{
+	std::ifstream file(fname, std::ios::binary);
 	if (!file.is_open()) {
 		m_iobox->push("Could not open file " + fname);
 		m_iobox->draw(m_display.get());
 		return;
 	}
-	//TODO
-	m_iobox->push("Not implemented!");
+	const std::string data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
 	file.close();
+
+	bool ok = false;
+	GameRecord record;
+	if (read_game_binary(data, record)) ok = load_game_record(record, *m_game);
+	else ok = load_game_pgn(data, *m_game);
+	if (!ok) {
+		m_iobox->push("Loading " + fname + " failed! Started a new game.");
+		m_game->new_game();
+	}
+	else m_iobox->push("Loaded " + fname);
+
+	m_active_mlist->clear();
+	char fen[GAME_FEN_LEN_MAX];
+	m_game->get_start_fen(fen, GAME_FEN_LEN_MAX);
+	if (std::string_view(fen).find(" b ") != std::string_view::npos) m_active_mlist->push("");
+	for (const std::string& move : m_game->get_all_moves_str()) m_active_mlist->push(move);
+	if (m_game->get_game_has_ended()) push_game_end_message(m_game->get_ending_game_state());
+
+	m_board->draw(m_display.get(), m_game->get_all_tiles_pos());
+	m_active_mlist->draw(m_display.get());
 	m_iobox->draw(m_display.get());
 	return;
 }
 
+void App::push_save_results()
+{
+	for (const GameSaveResult& result : m_save_writer.take_results()) {
+		m_iobox->push((result.ok ? "Saved game to " : "Could not save game to ") + result.path);
+	}
+}
+
 void App::exec_cmd_help(const std::string& arg)
 {
 	if (arg.size() == 0) {
-		m_iobox->push("Commands: -m move,-u undo, -f find, -n new game, -s save, -q quit");
+		m_iobox->push("Commands: -m move,-u undo, -f find, -n new game, -s save, -l load, -t stats, -q quit");
 		m_iobox->push("-h <Command> for detailed help");
 		m_iobox->draw(m_display.get());
 	}
@@ -265,7 +343,11 @@ void App::exec_cmd_help(const std::string& arg)
 			break;
 
 		case COMMAND_TYPE::SAVE:
-			m_iobox->push("-s <fname>: saves game to file");
+			m_iobox->push("-s <fname>: saves game to file (.pgn or binary)");
+			break;
+
+		case COMMAND_TYPE::LOAD:
+			m_iobox->push("-l <fname>: loads game from a binary or pgn file");
 			break;
 
 		case COMMAND_TYPE::HELP:
@@ -274,6 +356,9 @@ void App::exec_cmd_help(const std::string& arg)
 		case COMMAND_TYPE::RESIZE:
 			m_iobox->push("-r <size>: resizes the game. size={s,m,l}");
 			break;
+		case COMMAND_TYPE::STATS:
+			m_iobox->push("-t [r]: shows engine statistics, r resets them");
+			break;
 		default:
 			m_iobox->push("Invalid Command");
 			break;
@@ -350,6 +435,28 @@ void App::exec_cmd_resize(const std::string& arg)
 	m_display->render();
 }
 
+void App::exec_cmd_stats(const std::string& arg)
+{
+	if (!game_stats_enabled()) {
+		m_iobox->push("Engine was built without GAME_ENABLE_STATS");
+	}
+	else if (arg == "r") {
+		reset_game_stats();
+		m_iobox->push("Engine statistics reset");
+	}
+	else {
+		const GameStats stats = get_game_stats();
+		for (int i = 0; i < static_cast<int>(GameStatId::COUNT); i++) {
+			const GameStatCounter& counter = stats.counters[i];
+			const uint64_t avg = counter.calls ? counter.cycles / counter.calls : 0;
+			m_iobox->push(std::string(game_stat_name(static_cast<GameStatId>(i))) + ": " + std::to_string(counter.calls) + "x " + std::to_string(avg) + "cyc");
+		}
+		m_iobox->push("coverage ids recomputed: " + std::to_string(stats.coverage_ids_recomputed));
+		m_iobox->push("coverage rays recomputed: " + std::to_string(stats.coverage_rays_recomputed));
+	}
+	m_iobox->draw(m_display.get());
+}
+
 void App::push_game_end_message(GameEndState ges)
 {
 	switch (ges)
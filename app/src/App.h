@@ -1,6 +1,8 @@
 #pragma once
 
 #include "engine/Game.h"
+#include "engine/GameSave.h"
+#include "engine/GameStats.h"
 
 #include "ui/CharDisplay.h"
 #include "ui/CharBoard.h"
@@ -18,7 +20,9 @@ enum class COMMAND_TYPE {
     UNDO,
     FIND,
     SAVE,
+    LOAD,
     RESIZE,
+    STATS,
     HELP
 };
 
@@ -29,12 +33,16 @@ struct Command {
 
 Command parse_command(const std::string& str);
 
-class App
+class App : public IBoardObserver
 {
 public:
 	App();
+	~App() override;
 	void run();
 
+	// draws the changed tiles of moves and undos
+	void on_board_event(const BoardEvent& event) override;
+
 private:
     void exec_cmd(const std::string& cmd);
     
@@ -43,10 +51,13 @@ private:
     void exec_cmd_undo();
     void exec_cmd_find(const std::string& arg);
     void exec_cmd_save(const std::string& arg);
+    void exec_cmd_load(const std::string& arg);
     void exec_cmd_help(const std::string& arg);
     void exec_cmd_resize(const std::string& arg);
+    void exec_cmd_stats(const std::string& arg);
 
     void push_game_end_message(GameEndState state);
+    void push_save_results();
 private:
     std::unique_ptr<IGame> m_game;
     std::unique_ptr<CharDisplay> m_display;
@@ -55,6 +66,7 @@ private:
     std::unique_ptr<ICharMoveList> m_movelist_h;
     std::unique_ptr<ICharMoveList> m_movelist_v;
     std::unique_ptr<CharMessageBox> m_iobox;
+    GameSaveWriter m_save_writer;
     ICharMoveList* m_active_mlist;
     BoardSize m_size;
     bool m_quit;
@@ -10,6 +10,16 @@ workspace "ConsoleChess"
 
 OutputDir = "%{cfg.system}-%{cfg.architecture}/%{cfg.buildcfg}"
 
+newoption {
+   trigger = "engine-stats",
+   description = "Count calls and cycles of the engine hot paths (GAME_ENABLE_STATS)"
+}
+
+newoption {
+   trigger = "engine-avx2",
+   description = "Build the engine SIMD kernels for AVX2 instead of SSE2"
+}
+
 group "Vendor"
 	include "vendor/gtest/build-gtest.lua"
 group ""
@@ -28,6 +28,12 @@ project "ChessEngine"
        runtime "Release"
        optimize "On"
 
+   filter "options:engine-stats"
+       defines { "GAME_ENABLE_STATS" }
+
+   filter "options:engine-avx2"
+       vectorextensions "AVX2"
+
 project "ChessEngineTest"
    kind "ConsoleApp"
    language "C++"
@@ -63,4 +69,85 @@ project "ChessEngineTest"
        defines { "RELEASE" }
        runtime "Release"
        optimize "On"
-       symbols "off"
\ No newline at end of file
+       symbols "off"
+
+   filter "options:engine-stats"
+       defines { "GAME_ENABLE_STATS" }
+
+project "ChessEnginePerft"
+   kind "ConsoleApp"
+   language "C++"
+   cppdialect "C++20"
+   staticruntime "off"
+
+   files { "perft/*.cpp", "perft/*.csv" }
+
+   links
+   {
+      "ChessEngine",
+      "GTest"
+   }
+   includedirs
+   {
+      "include/engine",
+      "%{wks.location}/vendor/gtest/include"
+   }
+
+   targetdir ("bin/%{cfg.system}-%{cfg.architecture}/%{cfg.buildcfg}")
+   objdir ("obj/%{cfg.system}-%{cfg.architecture}/%{cfg.buildcfg}")
+
+   filter "system:windows"
+       systemversion "latest"
+       defines { }
+
+   filter "configurations:Debug"
+       defines { "DEBUG" }
+       runtime "Debug"
+       symbols "On"
+
+   filter "configurations:Release"
+       defines { "RELEASE" }
+       runtime "Release"
+       optimize "On"
+       symbols "off"
+
+   filter "options:engine-stats"
+       defines { "GAME_ENABLE_STATS" }
+
+project "ChessTournament"
+   kind "ConsoleApp"
+   language "C++"
+   cppdialect "C++20"
+   staticruntime "off"
+
+   files { "tournament/*.cpp" }
+
+   links
+   {
+      "ChessEngine"
+   }
+   includedirs
+   {
+      "include/engine"
+   }
+
+   targetdir ("bin/%{cfg.system}-%{cfg.architecture}/%{cfg.buildcfg}")
+   objdir ("obj/%{cfg.system}-%{cfg.architecture}/%{cfg.buildcfg}")
+
+   filter "system:windows"
+       systemversion "latest"
+       defines { }
+
+   filter "configurations:Debug"
+       defines { "DEBUG" }
+       runtime "Debug"
+       symbols "On"
+
+   filter "configurations:Release"
+       defines { "RELEASE" }
+       runtime "Release"
+       optimize "On"
+       symbols "off"
+
+   filter "options:engine-stats"
+       defines { "GAME_ENABLE_STATS" }
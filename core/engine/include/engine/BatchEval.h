@@ -0,0 +1,54 @@
+#pragma once
+#include "GameUtils.h"
+
+#include <array>
+#include <cstdint>
+#include <span>
+#include <string_view>
+#include <vector>
+
+// positions evaluated together by one SIMD pass
+#define BATCH_LANES 16
+
+/// <summary>
+/// Positions stored structure-of-arrays in blocks of BATCH_LANES: for every square the piece codes of all
+/// positions of the block are contiguous, so one vector instruction handles the square in every position.
+/// Piece codes are the PositionSnapshot nibbles (Piece, | 8 for black, 0 empty).
+/// </summary>
+class PositionBatch
+{
+public:
+	struct alignas(32) Block {
+		std::array<std::array<int16_t, BATCH_LANES>, GAME_BOARD_SIZE> squares;
+		// -1 if black is to move, 0 otherwise
+		std::array<int16_t, BATCH_LANES> black_to_move;
+		// GAME_CASTLE_* flags and PositionSnapshot::p2_index (-1 if none)
+		std::array<int16_t, BATCH_LANES> castles;
+		std::array<int16_t, BATCH_LANES> p2_index;
+	};
+
+public:
+	PositionBatch();
+
+	void clear();
+	void reserve(int positions);
+	// returns false (and adds nothing) if fen is invalid
+	bool add(std::string_view fen);
+	void add(const PositionSnapshot& snapshot);
+	int size() const;
+
+	const std::vector<Block>& get_blocks() const;
+private:
+	void set_lane(const PositionSnapshot& snapshot);
+private:
+	std::vector<Block> m_blocks;
+	int m_size;
+};
+
+// static evaluation of one position in centipawns for the side to move: material, piece square tables and
+// mobility (attacked squares not occupied by own pieces) of knights, bishops, rooks and queens
+int evaluate_static(const PositionSnapshot& snapshot);
+
+// evaluate_static for every position of batch, written to out (at least batch.size() values).
+// Blocks are split over threads (0: one per core)
+void evaluate_batch(const PositionBatch& batch, std::span<int> out, int threads = 0);
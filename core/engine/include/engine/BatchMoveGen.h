@@ -0,0 +1,33 @@
+#pragma once
+#include "BatchEval.h"
+#include "GameUtils.h"
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+/// <summary>
+/// Legal move generation for all positions of a PositionBatch. The squares attacked by the side not to move
+/// are computed for the BATCH_LANES positions of a block at once (one Lanes16 per square). Check and pin masks
+/// and the moves are then derived per position from the block, without building a Game.
+/// The moves are the same as Game::get_possible_moves lists (in another order).
+/// </summary>
+class BatchMoveGen
+{
+public:
+	BatchMoveGen();
+
+	// moves of every position of batch. list_moves false only counts them.
+	// Blocks are split over threads (0: one per core)
+	void generate(const PositionBatch& batch, bool list_moves = true, int threads = 0);
+
+	int size() const;
+	int get_count(int position) const;
+	uint64_t get_total_count() const;
+	// empty if the last generate did not list the moves
+	std::span<const GameMoveInt> get_moves(int position) const;
+private:
+	std::vector<int> m_counts;
+	// GAME_MAX_MOVES slots per position
+	std::vector<GameMoveInt> m_moves;
+};
@@ -3,6 +3,7 @@
 #include "GameInterface.h"
 
 #include <string>
+#include <string_view>
 
 
 /// <summary>
@@ -14,6 +15,9 @@
 /// If a legal move is used as input int the move method, the board is changed and a new game-delta is pushed.
 /// A undo call pops a game-delta and reverses to board to the previous state.
 /// After both cases the legal moves for the next player are reevaluated.
+/// Before a move the legal moves are also pushed to a stack, so undo restores them instead of reevaluating them.
+/// Undone game-deltas are kept for redo, and every GAME_CHECKPOINT_INTERVAL plies a compact checkpoint is stored,
+/// so seeking to any ply replays at most GAME_CHECKPOINT_INTERVAL deltas and generates legal moves once.
 /// 
 /// Why precalculate legal moves?
 /// Legal moves are moves that are possible by the moving rules of the piece (called pseudo leagal) and do not result in your own king being checked.
@@ -27,37 +31,75 @@ class Game : public IGame
 {
 public:
 	// default constructor using standard fen
-	Game(const std::string& fen = "", GameMoveStrFmt fmt = GameMoveStrFmt::UCI, uint8_t MAX_HALF_TURNS = 100);
+	Game(std::string_view fen = {}, GameMoveStrFmt fmt = GameMoveStrFmt::UCI, uint8_t MAX_HALF_TURNS = 100);
+	// position without history, check get_init_ok
+	explicit Game(const PositionSnapshot& snapshot, GameMoveStrFmt fmt = GameMoveStrFmt::UCI, uint8_t MAX_HALF_TURNS = 100);
+	explicit Game(const PackedBoard& board, GameMoveStrFmt fmt = GameMoveStrFmt::UCI, uint8_t MAX_HALF_TURNS = 100);
 	Game(const Game& other);
 	std::unique_ptr<IGame> clone() const override;
 	~Game() override;
 	
 	bool get_init_ok() const override;
+	FenResult get_fen_result() const override;
+	int to_fen(char* buffer, int buffer_size) const override;
+	int get_start_fen(char* buffer, int buffer_size) const override;
+	// zobrist key of the position: pieces, active color, castle rights and a capturable en passant file
+	uint64_t get_hash() const;
+	// trivially copyable copy of the current position (no history) for other threads
+	PositionSnapshot get_snapshot() const;
+	// 32 byte form of the current position for tables, sets and datasets
+	PackedBoard get_packed() const;
+	// keeps accumulator in sync with every move, undo and reset of this game (nullptr to detach). Copies are not attached
+	void set_accumulator(NnueAccumulator* accumulator);
+	// INCREMENTAL (default) pays for the coverage on every move, ON_DEMAND on every attack query. Copies keep the mode
+	void set_coverage_mode(CoverageMode mode);
+	CoverageMode get_coverage_mode() const;
 	ChessColor get_active_color() const override;
 	int get_turn_number() const override;
-	std::vector<GameMove> get_possible_moves() const override;
+	int get_possible_moves(std::span<GameMove> out) const override;
 	std::vector<std::string> get_possible_moves_str() const override;
-	std::vector<GameMove> get_possible_moves(int from_ind) const override;
-	std::vector<int> get_possible_moves_ind(int from_ind) const override;
+	int get_possible_moves(int from_ind, std::span<GameMove> out) const override;
+	int get_possible_moves_ind(int from_ind, std::span<int> out) const override;
 	std::vector<std::string> get_possible_moves_str(const std::string& from_str) const override;
-	std::vector<TileI> get_all_tiles_ind() const override;
-	std::vector<TileI> get_new_tiles_ind() const override;
-	std::vector<TileI> get_reverse_new_tiles_ind() const override;
+	int get_possible_moves_str(std::span<MoveStr> out, GameMoveStrFmt fmt = GameMoveStrFmt::DEFAULT) const override;
+	int get_all_tiles_ind(std::span<TileI> out) const override;
+	int get_new_tiles_ind(std::span<TileI> out) const override;
+	int get_reverse_new_tiles_ind(std::span<TileI> out) const override;
 	GameMove get_last_move() const override;
 	std::string get_last_move_str(GameMoveStrFmt fmt = GameMoveStrFmt::DEFAULT) const override;
-	std::vector<GameMove> get_all_moves() const override;
+	int get_all_moves(std::span<GameMove> out) const override;
 	std::vector<std::string> get_all_moves_str(GameMoveStrFmt fmt = GameMoveStrFmt::DEFAULT) const override;
+	int get_last_move_str(MoveStr& out, GameMoveStrFmt fmt = GameMoveStrFmt::DEFAULT) const override;
+	int get_all_moves_str(std::span<MoveStr> out, GameMoveStrFmt fmt = GameMoveStrFmt::DEFAULT) const override;
+	int to_movetext(char* buffer, int buffer_size, GameMoveStrFmt fmt = GameMoveStrFmt::DEFAULT) const override;
 	bool get_is_check() const override;
 	bool get_game_has_ended() const override;
 	GameEndState get_ending_game_state() const override;
+	int see(const GameMove& move) const override;
+	bool see_ge(const GameMove& move, int threshold) const override;
 	GameMoveStrFmt get_move_str_fmt() const override;
+	// vector and Position overloads of IGame
+	using IGame::get_possible_moves;
+	using IGame::get_possible_moves_ind;
+	using IGame::get_all_tiles_ind;
+	using IGame::get_new_tiles_ind;
+	using IGame::get_reverse_new_tiles_ind;
+	using IGame::get_all_moves;
 
-	GameState move(const std::string& move, GameMoveStrFmt fmt = GameMoveStrFmt::DEFAULT) override;
+	GameState move(std::string_view move, GameMoveStrFmt fmt = GameMoveStrFmt::DEFAULT) override;
 	GameState move(const GameMove& move) override;
 	void undo() override;
-	void new_game(const std::string& fen = "") override;
+	GameState redo() override;
+	bool seek(int ply) override;
+	int get_ply() const override;
+	int get_ply_count() const override;
+	void new_game(std::string_view fen = {}) override;
+	void new_game(const PositionSnapshot& snapshot);
+	void new_game(const PackedBoard& board);
 	void set_ending_game_state(GameEndState ges) override;
 	void set_move_str_fmt(GameMoveStrFmt fmt) override;
+	void add_observer(IBoardObserver* observer) override;
+	void remove_observer(IBoardObserver* observer) override;
 
 public:
 	// use for testing
@@ -65,56 +107,69 @@ public:
 	void perft_divide(int);
 	void save_board_DEBUG();
 	friend bool operator==(const Game& lhs, const Game& rhs);
+	friend class GameTree;
+	friend class MctsSearch;
+	friend class GamePool;
 private:
-	bool is_en_passant(const GameMove& m);
-	bool is_en_passant(const GameMoveInt& m);
+	Game(GameMoveStrFmt fmt, uint8_t MAX_HALF_TURNS);
+	// drops all observers, for games handed to another user
+	void detach_all();
 
-	bool init_fen(const std::string& fen);
-	bool init_fen_castles(const std::string& fen_castles_section);
-	bool init_fen_p2_index(const std::string& fen_ep_section);
+	bool is_en_passant(const GameMove& m) const;
+	bool is_en_passant(const GameMoveInt& m) const;
+
+	FenResult init_fen(std::string_view fen);
+	FenResult init_snapshot(const PositionSnapshot& snapshot);
+	FenResult init_packed(const PackedBoard& board);
+	bool init_position_state(uint8_t castles, int8_t p2_index, uint8_t half_turns, uint16_t turn_number, bool black_to_move);
+	uint8_t get_castle_flags() const;
+	void init_derived_state();
+	bool init_fen_castles(std::string_view fen_castles_section);
+	bool init_fen_p2_index(std::string_view fen_ep_section);
 
 	void find_legal_moves();
-	void find_pseudo_moves();
 	void find_pinned_pieces();
 	void find_pinned_direction(const Direction dir, const int king_bindex, const Piece dirp);
 	void clear_pinned();
 
 	void piece_moves(int id);
-	void king_moves(int id);
-	void queen_moves(int id);
-	void bishop_moves(int id);
-	void knight_moves(int id);
-	void rook_moves(int id);
-	void pawn_moves(int id);
-	void move_and_append(const Direction dir, const int from_bindex);
+	void king_moves(int from_bindex);
+	void queen_moves(int from_bindex, uint64_t target);
+	void bishop_moves(int from_bindex, uint64_t target);
+	void knight_moves(int from_bindex, uint64_t target);
+	void rook_moves(int from_bindex, uint64_t target);
+	void pawn_moves(int from_bindex, uint64_t target);
+	void move_and_append(const Direction dir, const int from_bindex, const uint64_t target);
 	void ksc_append(int king_bindex);
 	void qsc_append(int king_bindex);
 
 	bool en_passant_is_self_check(int from_x, int from_y, int ep_x);
-	
-	void filter_pinned_moves();
-	void filter_block_moves();
-	void find_block_indices(int king_bindex, int check_bindex);
-	void append_and_clear();
-	void append_en_passant_if_resolves_check(int active_king_index, int check_id);
+	void find_check_mask(int king_bindex, int check_bindex);
+
+	void reset_to_start();
+	static const Game& start_position();
 
 	bool move_is_legal(const GameMove& m) const;
-	GameDelta legal_to_gd(const GameMove& move);
+	GameDelta legal_to_gd(const GameMove& move) const;
 
-	GameMove string_to_gamemove(const std::string& s) const;
-	GameMove uci_to_gamemove(const std::string& uci) const;
-	GameMove san_to_gamemove(const std::string& san) const;
-	GameMove lan_to_gamemove(const std::string& lan) const;
+	GameMove string_to_gamemove(std::string_view s) const;
+	GameMove string_to_gamemove(std::string_view s, GameMoveStrFmt fmt) const;
+	GameMove uci_to_gamemove(std::string_view uci) const;
+	GameMove san_to_gamemove(std::string_view san) const;
+	GameMove lan_to_gamemove(std::string_view lan) const;
+	GameMove castles_to_gamemove(std::string_view castles) const;
+	void build_legal_index() const;
 
-	std::string legal_to_string(const GameMoveInt& move) const;
-	std::string legal_to_uci(const GameMoveInt& move) const;
-	std::string legal_to_san(const GameMoveInt& move) const;
-	std::string legal_to_lan(const GameMoveInt& move) const;
+	int new_tiles(const GameDelta& gd, std::array<TileI, GAME_MAX_CHANGED_TILES>& tiles) const;
+	int reverse_new_tiles(const GameDelta& gd, std::array<TileI, GAME_MAX_CHANGED_TILES>& tiles) const;
+	void publish(BoardEvent& event, const GameDelta* gd);
 
-	std::string gd_to_string(const GameDelta& gd) const;
-	std::string gd_to_uci(const GameDelta& gd) const;
-	std::string gd_to_san(const GameDelta& gd) const;
-	std::string gd_to_lan(const GameDelta& gd) const;
+	int write_legal(char* buffer, int legal_index, GameMoveStrFmt fmt) const;
+	int write_gd(char* buffer, const GameDelta& gd, GameMoveStrFmt fmt, bool mate) const;
+	bool move_gives_check(const GameMoveInt& move) const;
+	// values of the captured piece (with the promotion gain) and of the piece on the target square after move
+	void see_start(const GameMove& move, int& captured_value, int& moved_value) const;
+	bool is_last_move_mate() const;
 
 	void update_p2_index(const GameDelta& gd);
 	void update_castles(const GameDelta& gd);
@@ -123,26 +178,59 @@ private:
 	void undo_update_p2_index(int p2_last);
 	void undo_update_castles(PlayerCastles white_last, PlayerCastles black_last);
 
+	// notify false keeps the observers out, for moves searched in place
+	void apply_delta(const GameDelta& gd, bool notify = true);
+	void revert_delta(const GameDelta& gd, bool notify = true);
+	void push_delta(const GameDelta& gd);
+	void pop_delta();
+	void discard_redo();
+	void update_legal_moves();
+	void push_checkpoint_if_due();
+	GameCheckpoint make_checkpoint() const;
+	void restore_checkpoint(const GameCheckpoint& checkpoint);
+	void push_legal_state();
+	bool restore_legal_state();
+	void discard_legal_states();
+
 private:
+	// fast path for searches: no redo list, checkpoints, cached legal moves or events. Legal moves are stale after search_undo
+	GameState search_move(const GameMoveInt& m);
+	void search_undo();
 	GameState perft_move(const GameMoveInt& m);
 	void perft_undo();
 	char bindex_to_pinned_dir_char_DEBUG(int bindex);
 private:
-	const std::string M_DEFAULT_FEN;
 	ChessBoard m_board;
 	SwapVars m_swap_vars;
 	std::vector<GameDelta> m_gamedelta_list;
+	// undone deltas of the current line, the next one to redo at the back
+	std::vector<GameDelta> m_redo_list;
+	// m_checkpoints[i] is the state after i * GAME_CHECKPOINT_INTERVAL plies of the current line
+	std::vector<GameCheckpoint> m_checkpoints;
+	// pins of earlier plies of m_gamedelta_list (ascending ply, at most up to the current one), their legal moves
+	// stacked in m_legal_state_moves. Not copied
+	std::vector<LegalState> m_legal_states;
+	std::vector<GameMoveInt> m_legal_state_moves;
+	std::vector<IBoardObserver*> m_observers;
 	std::vector<GameMoveInt> m_legal_moves;
-	std::vector<GameMoveInt> m_pseudo_moves;
-	std::vector<int> m_block_check_indices;
-	
-	std::array<Direction, GAME_MAX_ID> m_pinned_direction;
+	// per id the squares a pinned piece may move to (the ray from its king to the pinning piece), all squares if not pinned
+	std::array<uint64_t, GAME_MAX_ID> m_pin_mask;
+	// squares that resolve a single check, all squares without check and none in double check
+	uint64_t m_check_mask;
 	GameEndState m_ending_gamestate;
 	GameMoveStrFmt m_string_fmt;
 	int  m_p2_index;
-	bool m_fen_valid;
+	FenResult m_fen_result;
+	std::array<char, GAME_FEN_LEN_MAX> m_start_fen;
 	bool m_game_has_ended;
-	uint8_t m_turn_number;
+	uint16_t m_turn_number;
 	const uint8_t M_MAX_HALF_TURNS;
 	uint8_t m_half_turn_number;
+
+	// indices of m_legal_moves bucketed by destination square and the SAN disambiguation per legal move.
+	// built lazily once per legal move list for SAN in- and output
+	mutable std::array<uint16_t, GAME_BOARD_SIZE + 1> m_legal_to_begin;
+	mutable std::array<uint8_t, GAME_MAX_MOVES> m_legal_by_to;
+	mutable std::array<uint8_t, GAME_MAX_MOVES> m_legal_disambiguation;
+	mutable bool m_legal_index_valid;
 };
\ No newline at end of file
@@ -3,10 +3,23 @@
 #include "GameInterfaceUtil.h"
 
 #include <vector>
+#include <span>
 #include <string>
+#include <string_view>
 #include <memory>
 
 
+/// <summary>
+/// Receives board changes of a game. Called synchronously from the mutating call of the game,
+/// while the game is still updating (legal moves and history may not be current). Only use the event.
+/// </summary>
+class IBoardObserver
+{
+public:
+	virtual ~IBoardObserver() {}
+	virtual void on_board_event(const BoardEvent& event) = 0;
+};
+
 /// <summary>
 /// Interface of the game class.
 /// Defines core functionality of game class and adds additional type support
@@ -32,56 +45,108 @@ public:
 	
 	// call after constructor/new_game
 	virtual bool get_init_ok() const = 0;
+	// reason and offset if the last fen was rejected
+	virtual FenResult get_fen_result() const = 0;
+	// writes the current position as '\0' terminated fen. returns length without '\0', 0 if buffer_size is too small.
+	// GAME_FEN_LEN_MAX is always sufficient
+	virtual int to_fen(char* buffer, int buffer_size) const = 0;
+	// same as to_fen for the position the current game started from
+	virtual int get_start_fen(char* buffer, int buffer_size) const = 0;
 
 	virtual ChessColor get_active_color() const = 0;
 	virtual int get_turn_number() const = 0;
 	virtual GameMoveStrFmt get_move_str_fmt() const = 0;
 	
-	// returns all legal moves for current active player
-	virtual std::vector<GameMove> get_possible_moves() const = 0;
+	// The span accessors write into caller provided buffers and return the number of elements written.
+	// Buffers of GAME_MAX_MOVES, GAME_MAX_PIECES, GAME_MAX_CHANGED_TILES and get_ply() elements are always sufficient.
+
+	// writes all legal moves for current active player
+	virtual int get_possible_moves(std::span<GameMove> out) const = 0;
 	virtual std::vector<std::string> get_possible_moves_str() const = 0;
-	// returns all legal moves for piece at from_id
-	virtual std::vector<GameMove> get_possible_moves(int from_ind) const = 0;
-	// returns all legal to_ind for piece at from_id
-	virtual std::vector<int> get_possible_moves_ind(int from_ind) const = 0;
+	// writes all legal moves for piece at from_ind
+	virtual int get_possible_moves(int from_ind, std::span<GameMove> out) const = 0;
+	// writes all legal to_ind for piece at from_ind (promotions once)
+	virtual int get_possible_moves_ind(int from_ind, std::span<int> out) const = 0;
 	// returns all legal moves for piece at from_str
 	virtual std::vector<std::string> get_possible_moves_str(const std::string& from_str) const = 0;
+	// writes legal moves into out (same order as get_possible_moves). returns number of moves written
+	virtual int get_possible_moves_str(std::span<MoveStr> out, GameMoveStrFmt fmt = GameMoveStrFmt::DEFAULT) const = 0;
 
-	// returns each occupied tile on the chessboard
-	virtual std::vector<TileI> get_all_tiles_ind() const = 0;
-	// returns all tiles that changed after last move including empty ones
-	virtual std::vector<TileI> get_new_tiles_ind() const = 0;
-	// can be called before undo.
-	virtual std::vector<TileI> get_reverse_new_tiles_ind() const  = 0;
+	// writes each occupied tile on the chessboard
+	virtual int get_all_tiles_ind(std::span<TileI> out) const = 0;
+	// writes all tiles that changed after last move including empty ones
+	virtual int get_new_tiles_ind(std::span<TileI> out) const = 0;
+	// tiles as they will be after undo. can be called before undo.
+	virtual int get_reverse_new_tiles_ind(std::span<TileI> out) const = 0;
 
 	virtual GameMove get_last_move() const = 0;
 	virtual std::string get_last_move_str(GameMoveStrFmt fmt = GameMoveStrFmt::DEFAULT) const = 0;
-	// order: last move at back
-	virtual std::vector<GameMove> get_all_moves() const = 0;
+	// writes past moves (first move at front)
+	virtual int get_all_moves(std::span<GameMove> out) const = 0;
 	virtual std::vector<std::string> get_all_moves_str(GameMoveStrFmt fmt = GameMoveStrFmt::DEFAULT) const = 0;
+	// returns length of the move string, 0 if there is no last move
+	virtual int get_last_move_str(MoveStr& out, GameMoveStrFmt fmt = GameMoveStrFmt::DEFAULT) const = 0;
+	// writes past moves into out (first move at front). returns number of moves written
+	virtual int get_all_moves_str(std::span<MoveStr> out, GameMoveStrFmt fmt = GameMoveStrFmt::DEFAULT) const = 0;
+	// writes all past moves as '\0' terminated movetext ("1. e4 e5 2. Nf3"). returns length without '\0', 0 if buffer_size is too small
+	virtual int to_movetext(char* buffer, int buffer_size, GameMoveStrFmt fmt = GameMoveStrFmt::DEFAULT) const = 0;
 	
 
 	virtual bool get_is_check() const = 0;
 	virtual bool get_game_has_ended() const = 0;
 	virtual GameEndState get_ending_game_state() const = 0;
+	// static exchange evaluation of a legal move in centipawns for the moving side: material won when both sides
+	// keep capturing on the target square with their least valuable piece as long as it pays off. 0 if move is not legal
+	virtual int see(const GameMove& move) const = 0;
+	// same as see(move) >= threshold, stops as soon as the outcome is known
+	virtual bool see_ge(const GameMove& move, int threshold) const = 0;
 
 	// try a move; returns {valid, invalid, game_ended}
 	virtual GameState move(const GameMove& move) = 0;
-	virtual GameState move(const std::string& move, GameMoveStrFmt fmt = GameMoveStrFmt::DEFAULT) = 0;
+	virtual GameState move(std::string_view move, GameMoveStrFmt fmt = GameMoveStrFmt::DEFAULT) = 0;
 	
 	virtual void undo() = 0;
+	// reapplies the last undone move. Undone moves are kept until a different move is played
+	virtual GameState redo() = 0;
+	// jumps to ply (0 = start position) of the current line including undone moves. returns false if out of range
+	virtual bool seek(int ply) = 0;
+	// number of plies played since the start position
+	virtual int get_ply() const = 0;
+	// number of plies of the current line including undone moves
+	virtual int get_ply_count() const = 0;
 	// old game will be overwritten. Make sure to save before.
-	virtual void new_game(const std::string& fen = "") = 0;
+	virtual void new_game(std::string_view fen = {}) = 0;
 	
 	virtual void set_move_str_fmt(GameMoveStrFmt fmt) = 0;
 
 	// can be used for forfeit and time implementations
 	virtual void set_ending_game_state(GameEndState ges) = 0;
+
+	// observers are not owned and not copied by clone. Remove them before they are destroyed
+	virtual void add_observer(IBoardObserver* observer) = 0;
+	virtual void remove_observer(IBoardObserver* observer) = 0;
 	
+	std::string get_fen() const;
+
+	// allocating convenience wrappers of the span accessors
+	std::vector<GameMove> get_possible_moves() const;
+	std::vector<GameMove> get_possible_moves(int from_ind) const;
+	std::vector<int> get_possible_moves_ind(int from_ind) const;
+	std::vector<TileI> get_all_tiles_ind() const;
+	std::vector<TileI> get_new_tiles_ind() const;
+	std::vector<TileI> get_reverse_new_tiles_ind() const;
+	// order: last move at back
+	std::vector<GameMove> get_all_moves() const;
+
 	// Function overloading to support position in-/outputs
+	int get_possible_moves(Position from_pos, std::span<GameMove> out) const;
+	int get_possible_moves_pos(Position from_pos, std::span<Position> out) const;
+	int get_all_tiles_pos(std::span<TileP> out) const;
+	int get_new_tiles_pos(std::span<TileP> out) const;
+	int get_reverse_new_tiles_pos(std::span<TileP> out) const;
 	std::vector<GameMove> get_possible_moves(Position from_pos) const;
 	std::vector<Position> get_possible_moves_pos(Position from_pos) const;
 	std::vector<TileP> get_all_tiles_pos() const;
 	std::vector<TileP> get_new_tiles_pos() const;
-	virtual std::vector<TileP> get_reverse_new_tiles_pos() const;
+	std::vector<TileP> get_reverse_new_tiles_pos() const;
 };
\ No newline at end of file
@@ -1,10 +1,26 @@
 #pragma once
 
+#include <array>
+
 // changeing this might break alot
 #define GAME_WIDTH 8
 #define GAME_HEIGHT 8
 #define GAME_BOARD_SIZE GAME_WIDTH*GAME_HEIGHT
 
+// longest fen: full board section, all castles, ep square, max half turns/turn number and '\0'
+#define GAME_FEN_LEN_MAX 92
+#define GAME_DEFAULT_FEN "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1"
+
+// upper bound for the number of (pseudo) legal moves in a position (max known is 218)
+#define GAME_MAX_MOVES 256
+// upper bound for the number of pieces on the board
+#define GAME_MAX_PIECES 32
+// upper bound for the number of tiles changed by one move (castles)
+#define GAME_MAX_CHANGED_TILES 4
+
+// longest move string without '\0' (LAN pawn capture into promotion with mate: e7xd8=Q#)
+#define GAME_MOVE_STR_LEN_MAX 8
+
 struct Position {
 	int x; // [0, GAMGE_WIDTH - 1]
 	int y; // [0, GAMGE_HEIGHT - 1]
@@ -40,6 +56,34 @@ enum class GameEndState {
 	END_DRAW_MAX_HALF_TURNS = 24,
 };
 
+/// <summary>
+/// Reason why a fen string was rejected. FenResult::offset points at the offending character.
+/// </summary>
+enum class FenError {
+	NONE = 0,
+	MISSING_SECTION,
+	TRAILING_CHARACTERS,
+	BOARD_INVALID_CHAR,
+	BOARD_RANK_SIZE,
+	BOARD_RANK_COUNT,
+	BOARD_PIECE_COUNT,
+	BOARD_KING_COUNT,
+	ACTIVE_COLOR,
+	CASTLES,
+	EN_PASSANT,
+	HALF_TURNS,
+	TURN_NUMBER,
+	KINGS_ADJACENT
+};
+
+struct FenResult {
+	FenError error = FenError::NONE;
+	int offset = 0; // index of the first character that was not consumed
+	bool ok() const { return error == FenError::NONE; }
+};
+
+const char* fen_error_to_string(FenError error);
+
 enum class GameMoveStrFmt {
 	DEFAULT,
 	UCI,
@@ -47,6 +91,9 @@ enum class GameMoveStrFmt {
 	LAN
 };
 
+// '\0' terminated move string of any GameMoveStrFmt
+typedef std::array<char, GAME_MOVE_STR_LEN_MAX + 1> MoveStr;
+
 enum class Piece {
 	EMPTY = 0,
 	KING,
@@ -86,5 +133,27 @@ public:
 	friend bool operator==(const GameMove& lhs, const GameMove& rhs);
 };
 
+enum class BoardEventType {
+	MOVE,	// a move was applied
+	UNDO,	// a move was taken back
+	RESET	// the whole position was replaced (new game, seek to a checkpoint). No tiles are listed
+};
+
+/// <summary>
+/// Board change published to observers of a game at the moment the board changes.
+/// tiles are the changed squares with their new content, emptied squares included.
+/// </summary>
+struct BoardEvent {
+	BoardEventType type = BoardEventType::RESET;
+	GameMove move;
+	// moving piece before a promotion and captured piece (EMPTY if none)
+	Piece piece = Piece::EMPTY;
+	Piece captured = Piece::EMPTY;
+	std::array<TileI, GAME_MAX_CHANGED_TILES> tiles{};
+	int tile_count = 0;
+	// side to move is in check after the change
+	bool check = false;
+};
+
 int position_to_bindex(Position pos);
 Position bindex_to_position(int bindex);
\ No newline at end of file
@@ -0,0 +1,80 @@
+#pragma once
+#include "Game.h"
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <string>
+#include <string_view>
+
+
+/// <summary>
+/// Budget of a single move decision. 0 means unlimited.
+/// </summary>
+struct PlayerLimits {
+	uint64_t nodes = 0;
+	int move_time_ms = 0;
+};
+
+/// <summary>
+/// Engine configuration that picks moves for one side. Players are used by one thread at a time,
+/// concurrent games use clones.
+/// </summary>
+class IGamePlayer
+{
+public:
+	virtual ~IGamePlayer() {}
+
+	virtual std::unique_ptr<IGamePlayer> clone() const = 0;
+	virtual std::string get_name() const = 0;
+	// called before every game, seed makes the game reproducible
+	virtual void new_game(uint64_t /*seed*/) {}
+	// returns a legal move of game (game has not ended). The game is restored before returning.
+	virtual GameMove choose_move(Game& game, const PlayerLimits& limits) = 0;
+};
+
+/// <summary>
+/// Plays a uniformly random legal move.
+/// </summary>
+class RandomPlayer : public IGamePlayer
+{
+public:
+	std::unique_ptr<IGamePlayer> clone() const override;
+	std::string get_name() const override;
+	void new_game(uint64_t seed) override;
+	GameMove choose_move(Game& game, const PlayerLimits& limits) override;
+private:
+	std::mt19937_64 m_rng;
+};
+
+/// <summary>
+/// Fixed depth negamax with alpha-beta pruning over material only.
+/// Stops early when the node or time limit is hit and plays the best move of the last completed depth.
+/// Equal moves are chosen at random so that games from the same opening differ.
+/// </summary>
+class MaterialPlayer : public IGamePlayer
+{
+public:
+	MaterialPlayer(int depth = 2);
+	std::unique_ptr<IGamePlayer> clone() const override;
+	std::string get_name() const override;
+	void new_game(uint64_t seed) override;
+	GameMove choose_move(Game& game, const PlayerLimits& limits) override;
+
+	// material of the side to move minus material of the opponent in centipawns
+	static int evaluate(const Game& game);
+private:
+	int negamax(Game& game, int depth, int alpha, int beta);
+	bool out_of_budget();
+private:
+	int m_depth;
+	std::mt19937_64 m_rng;
+	PlayerLimits m_limits;
+	uint64_t m_nodes;
+	std::chrono::steady_clock::time_point m_deadline;
+	bool m_stopped;
+};
+
+// creates a player from a name as used on the command line: "random", "material[:depth]" or "mcts". nullptr if unknown
+std::unique_ptr<IGamePlayer> make_player(std::string_view name);
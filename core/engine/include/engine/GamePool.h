@@ -0,0 +1,60 @@
+#pragma once
+#include "Game.h"
+
+#include <memory>
+#include <string_view>
+#include <vector>
+
+
+/// <summary>
+/// Pool of reusable Game instances for bulk position analysis.
+/// 
+/// Creating a Game reserves its move and history buffers. A pooled game keeps those buffers,
+/// so acquiring a game only resets it via new_game, which does not touch the heap
+/// (the start position is copied from a cached pre-parsed game, other positions are parsed in place).
+/// Released games are detached from their accumulator and observers and set back to incremental coverage.
+/// The idle list has room for every game the pool created, so releasing a handle never allocates.
+/// 
+/// Pools are not synchronized. Use GamePool::local() to get the pool of the calling thread,
+/// so that many workers can acquire games without allocator or lock contention.
+/// A handle has to be released on the thread (and before the pool) it was acquired from.
+/// </summary>
+class GamePool
+{
+public:
+	class Releaser {
+	public:
+		Releaser(GamePool* pool = nullptr) : m_pool(pool) {}
+		void operator()(Game* game) const;
+	private:
+		GamePool* m_pool;
+	};
+	// returns the game to its pool when it goes out of scope
+	typedef std::unique_ptr<Game, Releaser> Handle;
+
+public:
+	// creates initial_size games up front
+	GamePool(int initial_size = 0);
+	GamePool(const GamePool& other) = delete;
+	GamePool& operator=(const GamePool& other) = delete;
+
+	// returns a game reset to fen (empty for the start position). Check get_init_ok for custom fens.
+	Handle acquire(std::string_view fen = {});
+	// returns a game reset to the snapshot position. Check get_init_ok for snapshots from untrusted sources.
+	Handle acquire(const PositionSnapshot& snapshot);
+	// makes sure that at least n games are idle
+	void reserve(int n);
+	// number of idle games
+	int size() const;
+
+	// pool of the calling thread
+	static GamePool& local();
+private:
+	void release(Game* game);
+	// makes room in m_idle for one more game, called before the pool creates it
+	void add_game_slot();
+private:
+	std::vector<std::unique_ptr<Game>> m_idle;
+	// games created by this pool, idle or acquired
+	size_t m_games;
+};
@@ -0,0 +1,101 @@
+#pragma once
+#include "GameInterface.h"
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+// first bytes of a binary game save
+#define GAME_SAVE_MAGIC "CGS1"
+#define GAME_SAVE_VERSION 1
+// result byte of a game that has not ended
+#define GAME_SAVE_NO_RESULT 0xFF
+
+
+struct GameTag {
+	std::string name;
+	std::string value;
+};
+
+/// <summary>
+/// Decoded content of a binary save. An empty start_fen is the standard start position.
+/// </summary>
+struct GameRecord {
+	std::string start_fen;
+	bool has_result = false;
+	GameEndState result = GameEndState::END_DRAW_OFFER;
+	std::vector<GameTag> tags;
+	std::vector<GameMove> moves;
+};
+
+/// <summary>
+/// Binary layout (little endian):
+/// magic[4], u8 version, u8 flags (bit 0: custom start fen), u8 result (GameEndState or GAME_SAVE_NO_RESULT),
+/// u8 tag count, u16 ply count, [u8 fen length, fen], tags as (u8 length, name, u16 length, value),
+/// then one u16 GameMoveInt per ply.
+/// Appends the encoded game to out. Returns false and leaves out unchanged if the game has more than 65535 plies,
+/// more than 255 tags or a tag does not fit its length field.
+/// </summary>
+bool write_game_binary(const IGame& game, const std::vector<GameTag>& tags, std::string& out);
+
+// decodes one game from the front of data. consumed is set to the size of the game in bytes. returns false if data is corrupt
+bool read_game_binary(std::string_view data, GameRecord& record, size_t* consumed = nullptr);
+
+// starts a new game from record and replays its moves. returns false if the fen or a move is rejected
+bool load_game_record(const GameRecord& record, IGame& game);
+
+// writes the game as pgn with the seven tag roster (missing tags are "?") and tags
+std::string write_game_pgn(const IGame& game, const std::vector<GameTag>& tags = {});
+
+// replays the first game of a pgn database into game. returns false if the fen or a move is rejected
+bool load_game_pgn(std::string_view pgn, IGame& game);
+
+// "1-0", "0-1", "1/2-1/2" or "*" if the game has not ended
+const char* game_result_to_string(const IGame& game);
+
+
+struct GameSaveResult {
+	std::string path;
+	bool ok;
+};
+
+/// <summary>
+/// Writes files on a background thread so that callers never wait for the disk.
+/// Results are collected and can be polled with take_results from the owning thread.
+/// Pending saves are written before the destructor returns.
+/// </summary>
+class GameSaveWriter
+{
+public:
+	GameSaveWriter();
+	GameSaveWriter(const GameSaveWriter& other) = delete;
+	GameSaveWriter& operator=(const GameSaveWriter& other) = delete;
+	~GameSaveWriter();
+
+	// queues data to be written to path (replacing the file)
+	void save(std::string path, std::string data);
+	// blocks until all queued saves are written
+	void flush();
+	// returns and clears the results of finished saves
+	std::vector<GameSaveResult> take_results();
+private:
+	struct Job {
+		std::string path;
+		std::string data;
+	};
+	void run();
+private:
+	std::mutex m_mutex;
+	std::condition_variable m_job_cv;
+	std::condition_variable m_idle_cv;
+	std::deque<Job> m_jobs;
+	std::vector<GameSaveResult> m_results;
+	bool m_busy;
+	bool m_stop;
+	std::thread m_thread;
+};
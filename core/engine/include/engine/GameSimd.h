@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstdint>
+
+// instruction set of the engine kernels, chosen by the compiler target (premake option engine-avx2)
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define GAME_SIMD_AVX2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define GAME_SIMD_SSE2
+#endif
+
+
+/// <summary>
+/// 16 int16 lanes with the same operations for AVX2, SSE2 and plain C++.
+/// Comparisons return masks (all bits set for true), any() is true if any bit of any lane is set.
+/// load/store need 32 byte aligned memory.
+/// </summary>
+struct Lanes16 {
+#if defined(GAME_SIMD_AVX2)
+	__m256i v;
+
+	static Lanes16 zero() { return { _mm256_setzero_si256() }; }
+	static Lanes16 set1(int16_t x) { return { _mm256_set1_epi16(x) }; }
+	static Lanes16 load(const int16_t* p) { return { _mm256_load_si256(reinterpret_cast<const __m256i*>(p)) }; }
+	void store(int16_t* p) const { _mm256_store_si256(reinterpret_cast<__m256i*>(p), v); }
+	friend Lanes16 operator+(Lanes16 a, Lanes16 b) { return { _mm256_add_epi16(a.v, b.v) }; }
+	friend Lanes16 operator-(Lanes16 a, Lanes16 b) { return { _mm256_sub_epi16(a.v, b.v) }; }
+	friend Lanes16 operator&(Lanes16 a, Lanes16 b) { return { _mm256_and_si256(a.v, b.v) }; }
+	friend Lanes16 operator|(Lanes16 a, Lanes16 b) { return { _mm256_or_si256(a.v, b.v) }; }
+	friend Lanes16 operator^(Lanes16 a, Lanes16 b) { return { _mm256_xor_si256(a.v, b.v) }; }
+	// ~a & b
+	static Lanes16 andnot(Lanes16 a, Lanes16 b) { return { _mm256_andnot_si256(a.v, b.v) }; }
+	static Lanes16 eq(Lanes16 a, Lanes16 b) { return { _mm256_cmpeq_epi16(a.v, b.v) }; }
+	static Lanes16 gt(Lanes16 a, Lanes16 b) { return { _mm256_cmpgt_epi16(a.v, b.v) }; }
+	bool any() const { return !_mm256_testz_si256(v, v); }
+#elif defined(GAME_SIMD_SSE2)
+	__m128i lo;
+	__m128i hi;
+
+	static Lanes16 zero() { return { _mm_setzero_si128(), _mm_setzero_si128() }; }
+	static Lanes16 set1(int16_t x) { return { _mm_set1_epi16(x), _mm_set1_epi16(x) }; }
+	static Lanes16 load(const int16_t* p) { return { _mm_load_si128(reinterpret_cast<const __m128i*>(p)), _mm_load_si128(reinterpret_cast<const __m128i*>(p + 8)) }; }
+	void store(int16_t* p) const { _mm_store_si128(reinterpret_cast<__m128i*>(p), lo); _mm_store_si128(reinterpret_cast<__m128i*>(p + 8), hi); }
+	friend Lanes16 operator+(Lanes16 a, Lanes16 b) { return { _mm_add_epi16(a.lo, b.lo), _mm_add_epi16(a.hi, b.hi) }; }
+	friend Lanes16 operator-(Lanes16 a, Lanes16 b) { return { _mm_sub_epi16(a.lo, b.lo), _mm_sub_epi16(a.hi, b.hi) }; }
+	friend Lanes16 operator&(Lanes16 a, Lanes16 b) { return { _mm_and_si128(a.lo, b.lo), _mm_and_si128(a.hi, b.hi) }; }
+	friend Lanes16 operator|(Lanes16 a, Lanes16 b) { return { _mm_or_si128(a.lo, b.lo), _mm_or_si128(a.hi, b.hi) }; }
+	friend Lanes16 operator^(Lanes16 a, Lanes16 b) { return { _mm_xor_si128(a.lo, b.lo), _mm_xor_si128(a.hi, b.hi) }; }
+	static Lanes16 andnot(Lanes16 a, Lanes16 b) { return { _mm_andnot_si128(a.lo, b.lo), _mm_andnot_si128(a.hi, b.hi) }; }
+	static Lanes16 eq(Lanes16 a, Lanes16 b) { return { _mm_cmpeq_epi16(a.lo, b.lo), _mm_cmpeq_epi16(a.hi, b.hi) }; }
+	static Lanes16 gt(Lanes16 a, Lanes16 b) { return { _mm_cmpgt_epi16(a.lo, b.lo), _mm_cmpgt_epi16(a.hi, b.hi) }; }
+	bool any() const { return _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_or_si128(lo, hi), _mm_setzero_si128())) != 0xFFFF; }
+#else
+	int16_t v[16];
+
+	template <typename F>
+	static Lanes16 map(Lanes16 a, Lanes16 b, F f) { Lanes16 r; for (int i = 0; i < 16; i++) r.v[i] = static_cast<int16_t>(f(a.v[i], b.v[i])); return r; }
+	static Lanes16 zero() { return set1(0); }
+	static Lanes16 set1(int16_t x) { Lanes16 r; for (int16_t& l : r.v) l = x; return r; }
+	static Lanes16 load(const int16_t* p) { Lanes16 r; for (int i = 0; i < 16; i++) r.v[i] = p[i]; return r; }
+	void store(int16_t* p) const { for (int i = 0; i < 16; i++) p[i] = v[i]; }
+	friend Lanes16 operator+(Lanes16 a, Lanes16 b) { return map(a, b, [](int x, int y) { return x + y; }); }
+	friend Lanes16 operator-(Lanes16 a, Lanes16 b) { return map(a, b, [](int x, int y) { return x - y; }); }
+	friend Lanes16 operator&(Lanes16 a, Lanes16 b) { return map(a, b, [](int x, int y) { return x & y; }); }
+	friend Lanes16 operator|(Lanes16 a, Lanes16 b) { return map(a, b, [](int x, int y) { return x | y; }); }
+	friend Lanes16 operator^(Lanes16 a, Lanes16 b) { return map(a, b, [](int x, int y) { return x ^ y; }); }
+	static Lanes16 andnot(Lanes16 a, Lanes16 b) { return map(a, b, [](int x, int y) { return ~x & y; }); }
+	static Lanes16 eq(Lanes16 a, Lanes16 b) { return map(a, b, [](int x, int y) { return x == y ? -1 : 0; }); }
+	static Lanes16 gt(Lanes16 a, Lanes16 b) { return map(a, b, [](int x, int y) { return x > y ? -1 : 0; }); }
+	bool any() const { for (const int16_t l : v) if (l) return true; return false; }
+#endif
+};
+
+
+/// <summary>
+/// Bit i set if bytes[i] == value, for 64 bytes (32 byte aligned)
+/// </summary>
+inline uint64_t equal_mask64(const uint8_t* bytes, uint8_t value)
+{
+#if defined(GAME_SIMD_AVX2)
+	const __m256i v = _mm256_set1_epi8(static_cast<char>(value));
+	const uint32_t lo = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_load_si256(reinterpret_cast<const __m256i*>(bytes)), v)));
+	const uint32_t hi = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_load_si256(reinterpret_cast<const __m256i*>(bytes + 32)), v)));
+	return lo | (uint64_t(hi) << 32);
+#elif defined(GAME_SIMD_SSE2)
+	const __m128i v = _mm_set1_epi8(static_cast<char>(value));
+	uint64_t mask = 0;
+	for (int i = 0; i < 4; i++) {
+		const __m128i chunk = _mm_load_si128(reinterpret_cast<const __m128i*>(bytes + 16 * i));
+		mask |= uint64_t(static_cast<uint16_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, v)))) << (16 * i);
+	}
+	return mask;
+#else
+	uint64_t mask = 0;
+	for (int i = 0; i < 64; i++) mask |= uint64_t(bytes[i] == value) << i;
+	return mask;
+#endif
+}
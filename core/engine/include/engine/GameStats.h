@@ -0,0 +1,79 @@
+#pragma once
+#include <array>
+#include <cstdint>
+
+
+// Instrumentation of the engine hot paths. Build with GAME_ENABLE_STATS defined (premake --engine-stats)
+// to count calls and cycles. Without it the GAME_STAT_* macros expand to nothing.
+
+enum class GameStatId {
+	FIND_LEGAL_MOVES = 0,
+	FIND_PINNED_PIECES,
+	UPDATE_COVERAGE,
+	APPLY_GAMEDELTA,
+	UNDO_GAMEDELTA,
+	COUNT
+};
+
+struct GameStatCounter {
+	uint64_t calls = 0;
+	// cycles of the time stamp counter (nanoseconds on platforms without one), including nested counters
+	uint64_t cycles = 0;
+};
+
+struct GameStats {
+	std::array<GameStatCounter, static_cast<int>(GameStatId::COUNT)> counters{};
+	// ids whose coverage update_coverage recomputed completely, summed over all calls
+	uint64_t coverage_ids_recomputed = 0;
+	// single slider rays update_coverage recomputed, summed over all calls
+	uint64_t coverage_rays_recomputed = 0;
+	// undos that restored the cached legal moves instead of generating them
+	uint64_t legal_states_restored = 0;
+
+	const GameStatCounter& operator[](GameStatId id) const { return counters[static_cast<int>(id)]; }
+	GameStatCounter& operator[](GameStatId id) { return counters[static_cast<int>(id)]; }
+};
+
+const char* game_stat_name(GameStatId id);
+constexpr bool game_stats_enabled()
+{
+#ifdef GAME_ENABLE_STATS
+	return true;
+#else
+	return false;
+#endif
+}
+
+// counters are thread local, so that games on different threads do not share cache lines.
+// snapshot and reset of the counters of the calling thread
+GameStats get_game_stats();
+void reset_game_stats();
+
+#ifdef GAME_ENABLE_STATS
+GameStats& game_stats_local();
+uint64_t game_stat_timestamp();
+
+/// <summary>
+/// adds one call and the cycles until the end of the scope to a counter
+/// </summary>
+class GameStatScope
+{
+public:
+	GameStatScope(GameStatId id) : m_id(id), m_start(game_stat_timestamp()) {}
+	~GameStatScope()
+	{
+		GameStatCounter& counter = game_stats_local()[m_id];
+		counter.calls++;
+		counter.cycles += game_stat_timestamp() - m_start;
+	}
+private:
+	GameStatId m_id;
+	uint64_t m_start;
+};
+
+#define GAME_STAT_SCOPE(id) GameStatScope game_stat_scope_(id)
+#define GAME_STAT_ADD(field, n) (game_stats_local().field += (n))
+#else
+#define GAME_STAT_SCOPE(id)
+#define GAME_STAT_ADD(field, n)
+#endif
@@ -0,0 +1,72 @@
+#pragma once
+#include "Game.h"
+
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+
+#define GAME_TREE_NO_NODE 0xFFFFFFFFu
+
+/// <summary>
+/// Node of a GameTree. Children form a singly linked list, the first child is the main line.
+/// </summary>
+struct GameTreeNode {
+	// move leading to this node (unused for the root)
+	GameDelta delta = GameDelta(GameMove());
+	uint32_t parent = GAME_TREE_NO_NODE;
+	uint32_t first_child = GAME_TREE_NO_NODE;
+	uint32_t next_sibling = GAME_TREE_NO_NODE;
+	// plies since the root
+	uint32_t depth = 0;
+};
+
+/// <summary>
+/// Variation tree on top of a Game.
+/// 
+/// All lines share their common prefix: a node only stores the game-delta leading to it and links to
+/// parent, first child and next sibling in one arena (node ids are indices into it and stay valid).
+/// Switching to another node walks both nodes up to their common ancestor, pops the deltas of the old line
+/// and pushes the deltas of the new one. Legal moves are only generated for the target position.
+/// 
+/// The root is the position of the game when the tree is created or reset.
+/// While attached, the game should only be moved through the tree.
+/// </summary>
+class GameTree
+{
+public:
+	GameTree(Game& game);
+	GameTree(const GameTree& other) = delete;
+	GameTree& operator=(const GameTree& other) = delete;
+
+	// clears all variations, the current position of the game becomes the root
+	void reset();
+
+	// plays move at the current node. Follows an existing child or adds a new variation.
+	// returns the node id of the new position or GAME_TREE_NO_NODE if the move is invalid
+	uint32_t play(const GameMove& move);
+	uint32_t play(std::string_view move, GameMoveStrFmt fmt = GameMoveStrFmt::DEFAULT);
+
+	// sets the game to the position of node
+	bool go_to(uint32_t node);
+	// moves node to the front of its siblings, which makes it the main line of its parent
+	void promote(uint32_t node);
+
+	uint32_t get_root() const;
+	uint32_t get_current() const;
+	const GameTreeNode& get_node(uint32_t node) const;
+	GameMove get_move(uint32_t node) const;
+	// child of node that plays move or GAME_TREE_NO_NODE
+	uint32_t find_child(uint32_t node, const GameMove& move) const;
+	// number of nodes including the root
+	int size() const;
+private:
+	uint32_t add_child(uint32_t parent, const GameDelta& gd);
+	uint32_t common_ancestor(uint32_t a, uint32_t b) const;
+private:
+	Game& m_game;
+	std::vector<GameTreeNode> m_nodes;
+	// nodes between common ancestor and target of the last go_to, reused
+	std::vector<uint32_t> m_path;
+	uint32_t m_current;
+};
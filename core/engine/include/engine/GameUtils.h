@@ -6,6 +6,8 @@
 #include <iostream>
 #include <unordered_map>
 #include <bitset>
+#include <string_view>
+#include <type_traits>
 
 
 #include "GameInterfaceUtil.h"
@@ -13,6 +15,11 @@
 #define GAME_MAX_COLOR_ID 16
 #define GAME_MAX_ID 2*GAME_MAX_COLOR_ID
 #define GAME_BLACK_ID_OFFSET GAME_MAX_COLOR_ID
+// SAN disambiguation flags
+#define GAME_SAN_FILE 1
+#define GAME_SAN_RANK 2
+// plies between two history checkpoints of a game (seek replays at most this many deltas)
+#define GAME_CHECKPOINT_INTERVAL 16
 
 
 enum Direction {
@@ -84,6 +91,9 @@ public:
     GameMoveInt() : m_data(0) {}
     GameMoveInt(int from, int to);
     GameMoveInt(int from, int to, Piece promotion);
+    // raw 16 bit encoding as described above (used for serialization)
+    explicit GameMoveInt(uint16_t data) : m_data(data) {}
+    uint16_t get_data() const { return m_data; }
 
     int get_from() const;
     int get_to() const;
@@ -94,7 +104,6 @@ public:
     void set_from(int from);
     void set_to(int to);
     void set_promotion(Piece promotion);
-    void set_null();
 
     //debug
     friend inline bool operator==(const GameMoveInt& lhs, const GameMoveInt& rhs) { return lhs.m_data == rhs.m_data; }
@@ -148,18 +157,109 @@ public:
     bool qsc = false;
     bool ep = false;
     bool check = false;
+    // moved piece before promotion and SAN disambiguation (GAME_SAN_FILE | GAME_SAN_RANK), set by Game::move
+    Piece piece = Piece::EMPTY;
+    uint8_t disambiguation = 0;
+};
+
+/// <summary>
+/// Compact, id preserving copy of the piece placement (64 bytes).
+/// Captured and unused ids are stored as Piece::EMPTY. Coverage and hash are recomputed on restore.
+/// </summary>
+struct BoardPlacement {
+    std::array<uint8_t, GAME_MAX_ID> id_to_bindex;
+    std::array<uint8_t, GAME_MAX_ID> id_to_piece;
+};
+
+// castle flags of PositionSnapshot
+#define GAME_CASTLE_WHITE_KS 1
+#define GAME_CASTLE_WHITE_QS 2
+#define GAME_CASTLE_BLACK_KS 4
+#define GAME_CASTLE_BLACK_QS 8
+
+/// <summary>
+/// Trivially copyable position (38 bytes) to hand work to other threads without copying a Game.
+/// board: one nibble per square, even squares in the low nibble. 0 is empty, otherwise Piece | 8 for black pieces.
+/// Piece ids are not kept, a Game built from a snapshot numbers the pieces like a fen.
+/// </summary>
+struct PositionSnapshot {
+    std::array<uint8_t, GAME_BOARD_SIZE / 2> board;
+    uint8_t castles;        // GAME_CASTLE_* flags
+    int8_t p2_index;        // pawn that just advanced two squares, -1 if none
+    uint8_t half_turns;
+    uint8_t black_to_move;
+    uint16_t turn_number;
+};
+static_assert(sizeof(PositionSnapshot) <= 64 && std::is_trivially_copyable_v<PositionSnapshot>);
+
+/// <summary>
+/// Packed position (32 bytes) for transposition tables, position sets and datasets.
+/// occupancy has a bit per occupied bindex, pieces the PositionSnapshot codes of the occupied squares in bindex
+/// order, two per byte with the first in the low nibble. Unused nibbles and reserved are 0, so every position
+/// has exactly one packed form and equality and hash work on the packed bytes.
+/// Loading a game from a packed board validates pieces and en passant pawn, check get_init_ok for untrusted data.
+/// </summary>
+struct PackedBoard {
+    uint64_t occupancy;
+    std::array<uint8_t, GAME_MAX_COLOR_ID> pieces;
+    uint8_t castles;        // GAME_CASTLE_* flags
+    int8_t p2_index;        // pawn that just advanced two squares, -1 if none
+    uint8_t half_turns;
+    uint8_t black_to_move;
+    uint16_t turn_number;
+    uint16_t reserved;
+
+    friend bool operator==(const PackedBoard& lhs, const PackedBoard& rhs) = default;
+};
+static_assert(sizeof(PackedBoard) == 32 && std::is_trivially_copyable_v<PackedBoard>);
+
+// hash of all fields of board (clocks included)
+uint64_t packed_hash(const PackedBoard& board);
+struct PackedBoardHash {
+    size_t operator()(const PackedBoard& board) const { return static_cast<size_t>(packed_hash(board)); }
+};
+// conversions without a ChessBoard. Snapshots with more than GAME_MAX_ID pieces are not valid positions
+PackedBoard pack_snapshot(const PositionSnapshot& snapshot);
+PositionSnapshot unpack_snapshot(const PackedBoard& board);
+
+class NnueAccumulator;
+
+// how a ChessBoard answers is_covered, get_cover_count and get_first_cover_id
+enum class CoverageMode : uint8_t {
+    // coverage of every piece is kept up to date on each board change, queries are a lookup
+    INCREMENTAL,
+    // no coverage is kept, every query looks for the attackers of the square
+    ON_DEMAND,
 };
 
 class ChessBoard 
 {
 public:
     ChessBoard();
-
-    bool new_board(const std::string& fen_board_section);
+    // copies do not share the accumulator of other
+    ChessBoard(const ChessBoard& other);
+    // keeps and refreshes the own accumulator
+    ChessBoard& operator=(const ChessBoard& other);
+
+    // parses the board section of a fen string up to the first space
+    FenResult new_board(std::string_view fen);
+    // piece placement of a snapshot. offset of an error is the square
+    FenResult new_board(const PositionSnapshot& snapshot);
+    // writes the piece placement into snapshot.board
+    void to_snapshot_board(PositionSnapshot& snapshot) const;
+    // piece placement of a packed board. offset of an error is the square
+    FenResult new_board(const PackedBoard& board);
+    // writes the piece placement into board.occupancy and board.pieces
+    void to_packed_board(PackedBoard& board) const;
+    // writes the board section of a fen string (without '\0'). returns number of chars written (max 71)
+    int to_fen_board(char* buffer) const;
 
     void apply_gamedelta(const GameDelta& gd);
     void undo_gamedelta(const GameDelta& gd);
 
+    BoardPlacement get_placement() const;
+    void set_placement(const BoardPlacement& placement);
+
     int get_bindex(int id) const;
     int get_id(int bindex) const;
     Piece get_piece_from_bindex(int bindex) const;
@@ -176,14 +276,27 @@ public:
     int get_first_cover_id(int index) const;
     // returns id of first piece with same color as color_off that covers
     int get_first_cover_id_color(int index, int color_off) const;
+    // bit per id of the pieces that cover index
+    uint32_t get_cover_ids(int index) const;
+    // switching to INCREMENTAL rebuilds the coverage of the current placement
+    void set_coverage_mode(CoverageMode mode);
+    CoverageMode get_coverage_mode() const;
+    // zobrist key of the piece placement, updated incrementally
+    uint64_t get_hash() const;
+    // accumulator that follows every board change (nullptr to detach). It is refreshed on attach
+    void set_accumulator(NnueAccumulator* accumulator);
+    NnueAccumulator* get_accumulator() const;
     friend bool operator==(const ChessBoard& lhs, const ChessBoard& rhs);
 private:
-    bool init_from_fen(const std::string& fen);
+    FenResult init_from_fen(std::string_view fen);
     void init_coverage();
+    // coverage, hash and accumulator of a newly placed board
+    void init_incremental();
     
     void clear();
 
     void register_up(int bindex, int id, Piece p);
+    FenError register_next(int bindex, Piece p, bool is_white, int& white_id, int& black_id);
 
     void reset_coverage(int id);
     void set_coverage_single(int id, int index, bool value);
@@ -199,6 +312,14 @@ private:
     void cover_and_append(const Direction, const int, const int);
 
     void update_coverage();
+    // recomputes the coverage of the slider id along one ray
+    void update_ray_coverage(int id, Direction dir);
+    // bit per id of the pieces with color color_off that cover index (CoverageMode::ON_DEMAND)
+    uint32_t find_attackers_color(int index, int color_off) const;
+
+    void init_hash();
+    void toggle_hash(int bindex);
+    void toggle_hash_delta(const GameDelta& gd);
 private:
     std::vector<int> m_coverage_delta_indices;
     std::array<int, GAME_BOARD_SIZE> m_bindex_to_id;
@@ -206,6 +327,36 @@ private:
     std::array<int, GAME_MAX_ID> m_id_to_bindex;
     std::array<Piece, GAME_MAX_ID> m_id_to_piece;
     std::array<std::array<bool, GAME_BOARD_SIZE>, GAME_MAX_ID> m_coverage;
+    uint64_t m_hash;
+    NnueAccumulator* m_accumulator;
+    CoverageMode m_coverage_mode;
+};
+
+/// <summary>
+/// Game state after a number of plies that can not be derived from the game-deltas alone.
+/// Legal moves are not part of it, they are generated after a checkpoint is restored.
+/// </summary>
+struct GameCheckpoint {
+    BoardPlacement placement;
+    PlayerCastles white_castle;
+    PlayerCastles black_castle;
+    int8_t p2_index;
+    uint8_t half_turns;
+    uint16_t turn_number;
+    bool black_to_move;
+};
+
+/// <summary>
+/// Pin state of the position at ply, pushed before a move is played from it. Its legal moves are
+/// [move_begin, move_begin + move_count) of a shared move stack.
+/// Taking the move back restores them instead of generating the legal moves again.
+/// </summary>
+struct LegalState {
+    std::array<uint64_t, GAME_MAX_ID> pin_mask;
+    uint64_t check_mask;
+    int ply;
+    uint32_t move_begin;
+    uint16_t move_count;
 };
 
 
@@ -242,4 +393,14 @@ bool operator==(const SwapVars& lhs, const SwapVars& rhs);
 Piece char_to_piece(char c);
 char piece_to_char(const Piece p);
 
-std::string PositionToString(Position pos);
\ No newline at end of file
+std::string PositionToString(Position pos);
+
+// writes value in decimal without '\0'. returns number of chars written
+int write_uint(char* buffer, unsigned int value);
+
+// zobrist keys from a fixed seed, so that stored hashes stay valid across builds
+uint64_t zobrist_piece_key(bool white, Piece p, int bindex);
+uint64_t zobrist_black_to_move_key();
+// castle: 0 white ks, 1 white qs, 2 black ks, 3 black qs
+uint64_t zobrist_castle_key(int castle);
+uint64_t zobrist_en_passant_key(int file);
\ No newline at end of file
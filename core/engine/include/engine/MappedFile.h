@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+
+/// <summary>
+/// Read-only memory mapping of a whole file.
+/// The mapping stays valid until close is called or the object is destroyed,
+/// so string_views into view() can be handed around without copying the file.
+/// </summary>
+class MappedFile
+{
+public:
+	MappedFile();
+	MappedFile(const std::string& path);
+	MappedFile(MappedFile&& other) noexcept;
+	MappedFile& operator=(MappedFile&& other) noexcept;
+	MappedFile(const MappedFile& other) = delete;
+	MappedFile& operator=(const MappedFile& other) = delete;
+	~MappedFile();
+
+	// returns false if the file could not be opened or mapped. Empty files map to an empty view.
+	bool open(const std::string& path);
+	void close();
+
+	bool is_open() const;
+	std::string_view view() const;
+	const unsigned char* data() const;
+	size_t size() const;
+private:
+	const char* m_data;
+	size_t m_size;
+	bool m_open;
+#ifdef _WIN32
+	void* m_file_handle;
+	void* m_mapping_handle;
+#else
+	int m_fd;
+#endif
+};
@@ -0,0 +1,122 @@
+#pragma once
+#include "GamePlayer.h"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+
+#define MCTS_NO_NODE 0xFFFFFFFFu
+// longest path from the root through the tree
+#define MCTS_MAX_TREE_DEPTH 128
+
+/// <summary>
+/// Node of the search tree. The children of a node are stored next to each other in the arena.
+/// Statistics are updated by all search threads concurrently.
+/// </summary>
+struct MctsNode {
+	enum : uint8_t { LEAF = 0, EXPANDING = 1, EXPANDED = 2 };
+
+	// move leading to this node (null for the root)
+	GameMoveInt move;
+	uint16_t child_count = 0;
+	uint32_t first_child = MCTS_NO_NODE;
+	std::atomic<uint8_t> state = LEAF;
+	std::atomic<uint32_t> visits = 0;
+	// searches currently passing through this node, counted as lost until they are backed up
+	std::atomic<uint32_t> virtual_loss = 0;
+	// playout results for the side that played move in half points (win 2, draw 1, loss 0)
+	std::atomic<uint64_t> score = 0;
+};
+
+struct MctsConfig {
+	// UCT exploration constant
+	double exploration = 1.4;
+	// playouts longer than this count as draw
+	int max_playout_plies = 200;
+	// playouts prefer captures and promotions: of two random moves the capturing one is played
+	bool capture_bias = true;
+	// arena size, leaves are not expanded once it is full
+	uint32_t max_nodes = 1 << 20;
+	// 0: one thread per core
+	int threads = 1;
+	uint64_t seed = 1;
+};
+
+struct MctsRootChild {
+	GameMove move;
+	uint32_t visits;
+	// mean result for the side to move at the root, 0 (loss) to 1 (win)
+	double score;
+};
+
+struct MctsResult {
+	// most visited root move (default GameMove if the game has ended)
+	GameMove best_move;
+	uint64_t playouts = 0;
+	uint32_t nodes = 0;
+	double seconds = 0.0;
+	// root moves, most visited first
+	std::vector<MctsRootChild> children;
+
+	double playouts_per_sec() const { return seconds > 0.0 ? playouts / seconds : 0.0; }
+};
+
+/// <summary>
+/// Monte-Carlo tree search with UCT selection and random playouts.
+///
+/// Every iteration descends the tree by UCT, expands the reached leaf with all legal moves, plays random moves
+/// to the end of the game (or max_playout_plies) and backs the result up the path. Moves are made with the
+/// Game search fast path on a private copy per thread, so iterations do not allocate and the game is not touched.
+/// Game ends are the ones of Game (mate, stalemate, half turn limit).
+///
+/// With several threads all threads share one tree (tree parallel). A thread passing through a node adds a
+/// virtual loss to it, so that concurrent threads spread over different lines until the result is backed up.
+/// </summary>
+class MctsSearch
+{
+public:
+	MctsSearch(const MctsConfig& config = MctsConfig());
+	MctsSearch(const MctsSearch& other) = delete;
+	MctsSearch& operator=(const MctsSearch& other) = delete;
+
+	// searches the current position of game. limits.nodes is the number of playouts (10000 if no limit is set)
+	MctsResult search(const Game& game, const PlayerLimits& limits);
+
+	// seed of the playouts of the next search
+	void set_seed(uint64_t seed);
+	const MctsConfig& get_config() const;
+	const MctsNode& get_node(uint32_t id) const;
+	uint32_t size() const;
+private:
+	void run(Game& game, uint64_t seed, const PlayerLimits& limits, std::chrono::steady_clock::time_point deadline);
+	bool expand(Game& game, uint32_t id);
+	uint32_t select(uint32_t id) const;
+	// result in half points for white
+	int playout(Game& game, uint64_t& rng) const;
+private:
+	MctsConfig m_config;
+	std::unique_ptr<MctsNode[]> m_nodes;
+	std::atomic<uint32_t> m_size;
+	// started and finished playouts of the current search
+	std::atomic<uint64_t> m_started;
+	std::atomic<uint64_t> m_playouts;
+	std::atomic<bool> m_stop;
+};
+
+/// <summary>
+/// Tournament player searching with MctsSearch.
+/// </summary>
+class MctsPlayer : public IGamePlayer
+{
+public:
+	MctsPlayer(const MctsConfig& config = MctsConfig());
+	std::unique_ptr<IGamePlayer> clone() const override;
+	std::string get_name() const override;
+	void new_game(uint64_t seed) override;
+	GameMove choose_move(Game& game, const PlayerLimits& limits) override;
+private:
+	MctsConfig m_config;
+	std::unique_ptr<MctsSearch> m_search;
+};
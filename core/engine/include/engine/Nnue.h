@@ -0,0 +1,95 @@
+#pragma once
+#include "GameUtils.h"
+#include "MappedFile.h"
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// HalfKP: own king square x (5 piece types x 2 colors) x piece square, kings are not features
+#define NNUE_FEATURES (GAME_BOARD_SIZE * 10 * GAME_BOARD_SIZE)
+// accumulator size per perspective and hidden layer size
+#define NNUE_L1 256
+#define NNUE_L2 32
+// first bytes of a network file
+#define NNUE_MAGIC "CNN1"
+#define NNUE_VERSION 1
+// hidden activations are shifted right by NNUE_HIDDEN_SHIFT, the output is divided by NNUE_OUTPUT_SCALE
+#define NNUE_HIDDEN_SHIFT 6
+#define NNUE_OUTPUT_SCALE 16
+
+/// <summary>
+/// Quantized HalfKP network, mapped read-only from a file so that several engines share the weights.
+///
+/// File layout (little endian):
+/// magic[4], u32 version, u32 NNUE_FEATURES, u16 NNUE_L1, u16 NNUE_L2,
+/// i16 feature bias[L1], i16 feature weights[NNUE_FEATURES][L1],
+/// i32 hidden bias[L2], i8 hidden weights[L2][2 * L1], i32 output bias, i8 output weights[L2].
+///
+/// Evaluation: both accumulators (side to move first) are clipped to [0, 127], the hidden layer is
+/// clipped to [0, 127] after the shift, the output is linear. Kernels use AVX2 or SSE2 if the compiler
+/// targets them and a scalar fallback otherwise, all of them compute the same result.
+/// </summary>
+class NnueNetwork
+{
+public:
+	NnueNetwork();
+	NnueNetwork(const NnueNetwork& other) = delete;
+	NnueNetwork& operator=(const NnueNetwork& other) = delete;
+
+	// returns false if the file can not be mapped or does not match the layout
+	bool load(const std::string& path);
+	bool is_loaded() const;
+
+	// feature index of piece p of color piece_white on bindex, seen from the king of perspective_white on king_bindex
+	static int feature(bool perspective_white, int king_bindex, Piece p, bool piece_white, int bindex);
+	// centipawns for the side to move
+	int evaluate(const NnueAccumulator& accumulator, bool white_to_move) const;
+
+	const int16_t* get_feature_bias() const;
+	const int16_t* get_feature_weights(int feature) const;
+private:
+	MappedFile m_file;
+	const int16_t* m_feature_bias;
+	const int16_t* m_feature_weights;
+	const int8_t* m_hidden_weights;
+	const int8_t* m_output_weights;
+	std::array<int32_t, NNUE_L2> m_hidden_bias;
+	int32_t m_output_bias;
+};
+
+/// <summary>
+/// First layer of a network for both perspectives, kept in sync with a ChessBoard (ChessBoard::set_accumulator).
+///
+/// Every applied game-delta pushes a copy of the top frame and adds/removes the few changed feature columns.
+/// A king move refreshes the perspective of that king from the board. Undoing pops the frame, so takebacks
+/// cost nothing. Frames are reused, the stack only allocates when it gets deeper than before.
+/// </summary>
+class NnueAccumulator
+{
+public:
+	struct alignas(32) Frame {
+		// [0] white perspective, [1] black perspective
+		std::array<std::array<int16_t, NNUE_L1>, 2> values;
+	};
+
+public:
+	NnueAccumulator(const NnueNetwork& network);
+
+	// recomputes both perspectives of board and clears the stack
+	void refresh(const ChessBoard& board);
+	// board has just applied gd
+	void push(const ChessBoard& board, const GameDelta& gd);
+	// board has just undone the last pushed delta. Refreshes if there is nothing to pop
+	void pop(const ChessBoard& board);
+
+	const std::array<int16_t, NNUE_L1>& get_values(bool white_perspective) const;
+	int get_depth() const;
+private:
+	void refresh_perspective(const ChessBoard& board, bool white_perspective, Frame& frame) const;
+private:
+	const NnueNetwork& m_network;
+	std::vector<Frame> m_frames;
+	int m_top;
+};
@@ -0,0 +1,117 @@
+#pragma once
+#include "Game.h"
+
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#define PGN_MAX_TAGS 32
+
+
+/// <summary>
+/// Tag pair of a pgn game. The value is the raw text between the quotes (escapes are not resolved).
+/// </summary>
+struct PgnTag {
+	std::string_view name;
+	std::string_view value;
+};
+
+/// <summary>
+/// One game of a pgn database. All views point into the text given to the PgnReader,
+/// so nothing is copied or allocated per game. Tags beyond PGN_MAX_TAGS are skipped.
+/// </summary>
+struct PgnGame {
+	std::string_view text;
+	std::string_view movetext;
+	std::array<PgnTag, PGN_MAX_TAGS> tags{};
+	int tag_count = 0;
+	// position of the game in the database (0 based)
+	uint64_t index = 0;
+
+	// returns an empty view if the tag does not exist
+	std::string_view get_tag(std::string_view name) const;
+};
+
+/// <summary>
+/// Result of replaying the movetext of a game through the engine
+/// </summary>
+struct PgnReplay {
+	int plies = 0;
+	bool ok = true;
+	// first move that was rejected by the engine
+	std::string_view failed_move;
+	// game termination marker (1-0, 0-1, 1/2-1/2, *). Empty if the movetext has none
+	std::string_view result;
+};
+
+struct PgnStats {
+	uint64_t games = 0;
+	uint64_t plies = 0;
+	uint64_t errors = 0;
+	double seconds = 0.0;
+	double get_games_per_second() const;
+};
+
+/// <summary>
+/// Iterates the SAN tokens of a movetext section.
+/// Skips move numbers, comments ({...} and ;...), recursive variations and numeric annotation glyphs.
+/// Stops at the game termination marker.
+/// </summary>
+class PgnMoveTokenizer
+{
+public:
+	PgnMoveTokenizer(std::string_view movetext);
+	// returns false if there are no more moves
+	bool next(std::string_view& san);
+	std::string_view get_result() const;
+private:
+	std::string_view m_text;
+	size_t m_pos;
+	std::string_view m_result;
+};
+
+/// <summary>
+/// Splits a pgn database into games. Only tags and game boundaries are parsed here,
+/// the movetext is tokenized on replay. Games are separated by the start of a new tag section.
+/// </summary>
+class PgnReader
+{
+public:
+	// first_index is the index of the first game in text (used when reading chunks of a database)
+	PgnReader(std::string_view text, uint64_t first_index = 0);
+	// returns false if there are no more games
+	bool next(PgnGame& game);
+	size_t get_offset() const;
+private:
+	void skip_whitespace();
+	void parse_tag(PgnGame& game);
+	void skip_movetext();
+private:
+	std::string_view m_text;
+	size_t m_pos;
+	uint64_t m_index;
+};
+
+// called for every game after the replay. In parallel mode it is called from several threads at once.
+typedef std::function<void(const PgnGame& pgn, const Game& game, const PgnReplay& replay)> PgnVisitor;
+
+// starts game from the FEN tag (or the start position) and plays the movetext in SAN
+PgnReplay pgn_replay(const PgnGame& pgn, Game& game);
+
+// splits text into at most parts chunks that begin at a game boundary
+std::vector<std::string_view> pgn_split(std::string_view text, int parts);
+
+// called once per chunk with the index of the first game in the chunk. Runs on its own thread per chunk.
+typedef std::function<void(std::string_view chunk, uint64_t first_index)> PgnChunkVisitor;
+
+// splits text into at most threads chunks, counts their games and calls visitor for every chunk in parallel
+void pgn_for_each_chunk(std::string_view text, int threads, const PgnChunkVisitor& visitor);
+
+// replays all games in text. threads > 1 splits the database at game boundaries.
+PgnStats pgn_read(std::string_view text, const PgnVisitor& visitor = nullptr, int threads = 1);
+
+// memory maps path and replays all games. returns false if the file could not be mapped
+bool pgn_read_file(const std::string& path, PgnStats& stats, const PgnVisitor& visitor = nullptr, int threads = 1);
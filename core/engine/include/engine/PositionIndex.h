@@ -0,0 +1,88 @@
+#pragma once
+#include "MappedFile.h"
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#define POSITION_INDEX_MAGIC "CPI1"
+// postings kept in memory per build thread before they are sorted and spilled to a run file (16 bytes each)
+#define POSITION_INDEX_RUN_POSTINGS (1 << 22)
+
+
+/// <summary>
+/// Position reached in a game. ply 0 is the start position of the game.
+/// </summary>
+struct PositionPosting {
+	uint64_t key;
+	uint32_t game;
+	uint32_t ply;
+
+	friend bool operator<(const PositionPosting& lhs, const PositionPosting& rhs)
+	{
+		if (lhs.key != rhs.key) return lhs.key < rhs.key;
+		if (lhs.game != rhs.game) return lhs.game < rhs.game;
+		return lhs.ply < rhs.ply;
+	}
+	friend bool operator==(const PositionPosting& lhs, const PositionPosting& rhs) = default;
+};
+
+/// <summary>
+/// Builds an index file with external sorting: postings are sorted in memory in runs of bounded size,
+/// spilled to temporary run files and k-way merged into the index on finish.
+/// spill can be called from several threads at once, so every build thread sorts its own runs.
+///
+/// File layout (native little endian): magic[4], u32 reserved, u64 posting count, sorted PositionPosting array.
+/// </summary>
+class PositionIndexBuilder
+{
+public:
+	PositionIndexBuilder(std::string path, size_t run_postings = POSITION_INDEX_RUN_POSTINGS);
+	PositionIndexBuilder(const PositionIndexBuilder& other) = delete;
+	PositionIndexBuilder& operator=(const PositionIndexBuilder& other) = delete;
+	// removes left over run files
+	~PositionIndexBuilder();
+
+	size_t get_run_postings() const;
+	// sorts postings and writes them as a run file. postings is cleared. returns false on io errors
+	bool spill(std::vector<PositionPosting>& postings);
+	// merges all runs into the index file. returns false on io errors and removes the partial index file
+	bool finish();
+private:
+	std::string m_path;
+	size_t m_run_postings;
+	std::mutex m_mutex;
+	std::vector<std::string> m_run_paths;
+	std::vector<uint64_t> m_run_sizes;
+	std::atomic<bool> m_failed;
+};
+
+/// <summary>
+/// Read-only view of an index file. Lookups are binary searches over the memory mapped postings.
+/// </summary>
+class PositionIndex
+{
+public:
+	PositionIndex();
+	PositionIndex(const std::string& path);
+	// returns false if the file can not be mapped or is not an index
+	bool open(const std::string& path);
+	bool is_open() const;
+	size_t size() const;
+	// all postings of key sorted by game and ply. Valid as long as the index is open
+	std::span<const PositionPosting> find(uint64_t key) const;
+	std::span<const PositionPosting> get_postings() const;
+private:
+	MappedFile m_file;
+	const PositionPosting* m_postings;
+	size_t m_size;
+};
+
+// indexes every position of every game in a pgn database. the game id is the index of the game in the database.
+// games stop at the first illegal move. returns false on io errors
+bool build_position_index(std::string_view pgn, const std::string& index_path, int threads = 1, size_t run_postings = POSITION_INDEX_RUN_POSTINGS);
+bool build_position_index_file(const std::string& pgn_path, const std::string& index_path, int threads = 1, size_t run_postings = POSITION_INDEX_RUN_POSTINGS);
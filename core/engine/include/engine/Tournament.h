@@ -0,0 +1,77 @@
+#pragma once
+#include "GamePlayer.h"
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+
+struct TournamentConfig {
+	// start positions, every opening is played games_per_opening times with alternating colors. empty: start position
+	std::vector<std::string> openings;
+	int games_per_opening = 2;
+	// 0: one thread per core
+	int threads = 0;
+	PlayerLimits limits;
+	// games longer than this are adjudicated as draw (END_DRAW_MAX_TURNS)
+	int max_plies = 400;
+	uint64_t seed = 1;
+	std::string event = "Tournament";
+};
+
+/// <summary>
+/// Score of the first player against the second.
+/// </summary>
+struct TournamentResult {
+	int wins = 0;
+	int draws = 0;
+	int losses = 0;
+	// games that could not be played (rejected opening)
+	int errors = 0;
+
+	int games() const { return wins + draws + losses; }
+	double score() const;
+	// elo difference implied by the score, clamped to +-1200 for a perfect score
+	double elo() const;
+	// half width of the 95% confidence interval of elo
+	double elo_error() const;
+};
+
+/// <summary>
+/// Headless match of two players.
+///
+/// Games run concurrently on a thread pool: each worker takes the next game index, plays it on a game of
+/// its thread local GamePool with its own clones of the players and reports the finished game.
+/// Games end by the rules of Game (mate, stalemate, half turn limit), by threefold repetition or by max_plies.
+/// Game i plays opening i / games_per_opening, the first player has white in even games.
+/// </summary>
+class Tournament
+{
+public:
+	// called once per finished game, never concurrently. index is the game index, pgn a complete pgn game
+	typedef std::function<void(int index, const std::string& pgn)> GameCallback;
+
+public:
+	Tournament(const IGamePlayer& first, const IGamePlayer& second, TournamentConfig config);
+	Tournament(const Tournament& other) = delete;
+	Tournament& operator=(const Tournament& other) = delete;
+
+	int get_game_count() const;
+	// plays all games and blocks until they are finished
+	TournamentResult run(const GameCallback& on_game = nullptr);
+private:
+	// plays game index, returns the result for white ("1-0", "0-1", "1/2-1/2") or nullptr on errors
+	const char* play(int index, IGamePlayer& first, IGamePlayer& second, std::string& pgn) const;
+private:
+	std::unique_ptr<IGamePlayer> m_first;
+	std::unique_ptr<IGamePlayer> m_second;
+	TournamentConfig m_config;
+};
+
+// reads start positions from an epd or fen file, one per line. Empty lines and lines starting with '#' are skipped.
+// epd operations after the four position fields are dropped. returns false if the file cannot be read
+bool read_openings(const std::string& path, std::vector<std::string>& openings);
+// fen of an epd or fen line, "" if it has less than four fields
+std::string opening_to_fen(std::string_view line);
@@ -0,0 +1,274 @@
+#include "BatchEval.h"
+#include "BatchMoveGen.h"
+#include "Game.h"
+#include "Mcts.h"
+
+#include "gtest/gtest.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+
+
+/// <summary>
+/// Perft regression suite. Checks the node counts of the reference positions in perft_data.csv
+/// (name,fen,nodes at depth 1,nodes at depth 2,...) and measures the throughput.
+/// The same positions are used to report the MCTS playouts/sec (make/unmake with move generation per ply)
+/// and the positions/sec of the batched evaluation and move generation against the scalar ones.
+/// Perft and MCTS are run again with both CoverageMode policies of the board.
+/// 
+/// options (also read from the environment as PERFT_MAX_NODES, PERFT_MIN_NPS, PERFT_DATA):
+///		--max-nodes=<n>   skip depths with more than n expected nodes (default 5000000)
+///		--min-nps=<n>     fail if the overall nodes/sec of the run is below n (default 0, no budget)
+///		--data=<path>     data file (default perft/perft_data.csv, relative to core/engine)
+/// </summary>
+struct PerftOptions {
+	uint64_t max_nodes = 5000000;
+	uint64_t min_nps = 0;
+	std::string data = "perft/perft_data.csv";
+};
+
+static PerftOptions g_options;
+
+struct PerftCase {
+	std::string name;
+	std::string fen;
+	std::vector<uint64_t> nodes;
+};
+
+static std::vector<PerftCase> read_perft_cases(const std::string& path)
+{
+	std::vector<PerftCase> cases;
+	std::ifstream file(path);
+	std::string line;
+	while (std::getline(file, line)) {
+		if (line.empty()) continue;
+		PerftCase c;
+		size_t begin = 0;
+		size_t end = line.find(',');
+		c.name = line.substr(begin, end - begin);
+		begin = end + 1;
+		end = line.find(',', begin);
+		c.fen = line.substr(begin, end - begin);
+		while (end != std::string::npos) {
+			begin = end + 1;
+			end = line.find(',', begin);
+			c.nodes.push_back(std::stoull(line.substr(begin, end - begin)));
+		}
+		cases.push_back(c);
+	}
+	return cases;
+}
+
+TEST(PerftSuite, ReferencePositions) {
+	const std::vector<PerftCase> cases = read_perft_cases(g_options.data);
+	ASSERT_FALSE(cases.empty()) << "no perft data in " << g_options.data;
+
+	uint64_t total_nodes = 0;
+	double total_seconds = 0.0;
+	std::printf("%-20s %5s %12s %10s %12s\n", "position", "depth", "nodes", "ms", "nodes/sec");
+	for (const PerftCase& c : cases) {
+		Game game(c.fen);
+		ASSERT_TRUE(game.get_init_ok()) << c.name;
+		for (int depth = 1; depth <= static_cast<int>(c.nodes.size()); depth++) {
+			const uint64_t expected = c.nodes[depth - 1];
+			if (expected > g_options.max_nodes) break;
+
+			const auto start = std::chrono::steady_clock::now();
+			const uint64_t nodes = game.perft(depth);
+			const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+			EXPECT_EQ(nodes, expected) << c.name << " depth " << depth;
+
+			total_nodes += nodes;
+			total_seconds += seconds;
+			const double nps = seconds > 0.0 ? nodes / seconds : 0.0;
+			std::printf("%-20s %5d %12llu %10.1f %12.0f%s\n", c.name.c_str(), depth, static_cast<unsigned long long>(nodes),
+				seconds * 1000.0, nps, nodes == expected ? "" : "  WRONG");
+		}
+	}
+
+	const double nps = total_seconds > 0.0 ? total_nodes / total_seconds : 0.0;
+	std::printf("total %llu nodes in %.2f s, %.0f nodes/sec\n", static_cast<unsigned long long>(total_nodes), total_seconds, nps);
+	RecordProperty("nodes", std::to_string(total_nodes));
+	RecordProperty("nodes_per_sec", std::to_string(static_cast<uint64_t>(nps)));
+	EXPECT_GE(nps, static_cast<double>(g_options.min_nps)) << "throughput below the --min-nps budget";
+}
+
+TEST(PerftSuite, MctsPlayouts) {
+	const std::vector<PerftCase> cases = read_perft_cases(g_options.data);
+	ASSERT_FALSE(cases.empty()) << "no perft data in " << g_options.data;
+
+	MctsConfig config;
+	config.max_nodes = 1 << 16;
+	MctsSearch search(config);
+	PlayerLimits limits;
+	limits.nodes = 500;
+	uint64_t total_playouts = 0;
+	double total_seconds = 0.0;
+	std::printf("%-20s %12s %10s %12s\n", "position", "playouts", "ms", "playouts/sec");
+	for (const PerftCase& c : cases) {
+		const MctsResult result = search.search(Game(c.fen), limits);
+		EXPECT_EQ(result.playouts, limits.nodes) << c.name;
+		total_playouts += result.playouts;
+		total_seconds += result.seconds;
+		std::printf("%-20s %12llu %10.1f %12.0f\n", c.name.c_str(), static_cast<unsigned long long>(result.playouts),
+			result.seconds * 1000.0, result.playouts_per_sec());
+	}
+	const double pps = total_seconds > 0.0 ? total_playouts / total_seconds : 0.0;
+	std::printf("total %llu playouts in %.2f s, %.0f playouts/sec\n", static_cast<unsigned long long>(total_playouts), total_seconds, pps);
+	RecordProperty("playouts_per_sec", std::to_string(static_cast<uint64_t>(pps)));
+}
+
+// positions of random games from the reference positions
+static std::vector<PositionSnapshot> random_game_snapshots(const std::vector<PerftCase>& cases, size_t count)
+{
+	std::vector<PositionSnapshot> snapshots;
+	std::mt19937_64 rng(1);
+	while (snapshots.size() < count) {
+		for (const PerftCase& c : cases) {
+			Game game(c.fen);
+			for (int ply = 0; ply < 60 && !game.get_game_has_ended(); ply++) {
+				snapshots.push_back(game.get_snapshot());
+				const std::vector<GameMove> moves = game.get_possible_moves();
+				game.move(moves[rng() % moves.size()]);
+			}
+		}
+	}
+	return snapshots;
+}
+
+static double measure_seconds(const std::function<void()>& f)
+{
+	const auto start = std::chrono::steady_clock::now();
+	f();
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+TEST(PerftSuite, BatchEvaluation) {
+	const std::vector<PerftCase> cases = read_perft_cases(g_options.data);
+	ASSERT_FALSE(cases.empty()) << "no perft data in " << g_options.data;
+
+	const std::vector<PositionSnapshot> snapshots = random_game_snapshots(cases, 1 << 16);
+	PositionBatch batch;
+	batch.reserve(static_cast<int>(snapshots.size()));
+	for (const PositionSnapshot& snapshot : snapshots) batch.add(snapshot);
+
+	std::vector<int> expected(snapshots.size());
+	std::vector<int> scores(snapshots.size());
+	const double scalar_seconds = measure_seconds([&] { for (size_t i = 0; i < snapshots.size(); i++) expected[i] = evaluate_static(snapshots[i]); });
+	const double batch_seconds = measure_seconds([&] { evaluate_batch(batch, scores, 1); });
+	EXPECT_EQ(scores, expected);
+	const double threaded_seconds = measure_seconds([&] { evaluate_batch(batch, scores); });
+	EXPECT_EQ(scores, expected);
+
+	const auto rate = [&snapshots](double seconds) { return seconds > 0.0 ? snapshots.size() / seconds : 0.0; };
+	std::printf("%-20s %12s %10s %14s\n", "evaluation", "positions", "ms", "positions/sec");
+	std::printf("%-20s %12zu %10.1f %14.0f\n", "scalar", snapshots.size(), scalar_seconds * 1000.0, rate(scalar_seconds));
+	std::printf("%-20s %12zu %10.1f %14.0f\n", "batch", snapshots.size(), batch_seconds * 1000.0, rate(batch_seconds));
+	std::printf("%-20s %12zu %10.1f %14.0f\n", "batch (threads)", snapshots.size(), threaded_seconds * 1000.0, rate(threaded_seconds));
+	RecordProperty("batch_eval_per_sec", std::to_string(static_cast<uint64_t>(rate(batch_seconds))));
+}
+
+TEST(PerftSuite, BatchMoveGeneration) {
+	const std::vector<PerftCase> cases = read_perft_cases(g_options.data);
+	ASSERT_FALSE(cases.empty()) << "no perft data in " << g_options.data;
+
+	const std::vector<PositionSnapshot> snapshots = random_game_snapshots(cases, 1 << 15);
+	PositionBatch batch;
+	batch.reserve(static_cast<int>(snapshots.size()));
+	for (const PositionSnapshot& snapshot : snapshots) batch.add(snapshot);
+
+	uint64_t expected = 0;
+	const double game_seconds = measure_seconds([&] {
+		Game game;
+		std::array<GameMove, GAME_MAX_MOVES> moves;
+		for (const PositionSnapshot& snapshot : snapshots) {
+			game.new_game(snapshot);
+			expected += game.get_possible_moves(moves);
+		}
+	});
+	BatchMoveGen generator;
+	const double count_seconds = measure_seconds([&] { generator.generate(batch, false, 1); });
+	EXPECT_EQ(generator.get_total_count(), expected);
+	const double list_seconds = measure_seconds([&] { generator.generate(batch, true, 1); });
+	EXPECT_EQ(generator.get_total_count(), expected);
+	const double threaded_seconds = measure_seconds([&] { generator.generate(batch, true); });
+	EXPECT_EQ(generator.get_total_count(), expected);
+
+	const auto rate = [&snapshots](double seconds) { return seconds > 0.0 ? snapshots.size() / seconds : 0.0; };
+	std::printf("%-20s %12s %10s %14s\n", "move generation", "positions", "ms", "positions/sec");
+	std::printf("%-20s %12zu %10.1f %14.0f\n", "game", snapshots.size(), game_seconds * 1000.0, rate(game_seconds));
+	std::printf("%-20s %12zu %10.1f %14.0f\n", "batch count", snapshots.size(), count_seconds * 1000.0, rate(count_seconds));
+	std::printf("%-20s %12zu %10.1f %14.0f\n", "batch list", snapshots.size(), list_seconds * 1000.0, rate(list_seconds));
+	std::printf("%-20s %12zu %10.1f %14.0f\n", "batch list (threads)", snapshots.size(), threaded_seconds * 1000.0, rate(threaded_seconds));
+	RecordProperty("batch_movegen_per_sec", std::to_string(static_cast<uint64_t>(rate(list_seconds))));
+}
+
+TEST(PerftSuite, CoverageModes) {
+	const std::vector<PerftCase> cases = read_perft_cases(g_options.data);
+	ASSERT_FALSE(cases.empty()) << "no perft data in " << g_options.data;
+
+	MctsConfig config;
+	config.max_nodes = 1 << 16;
+	PlayerLimits limits;
+	limits.nodes = 500;
+	std::printf("%-20s %12s %12s %14s\n", "coverage", "nodes", "nodes/sec", "playouts/sec");
+	for (const CoverageMode mode : { CoverageMode::INCREMENTAL, CoverageMode::ON_DEMAND }) {
+		uint64_t nodes = 0;
+		uint64_t playouts = 0;
+		double perft_seconds = 0.0;
+		double search_seconds = 0.0;
+		MctsSearch search(config);
+		for (const PerftCase& c : cases) {
+			Game game(c.fen);
+			game.set_coverage_mode(mode);
+			for (int depth = 1; depth <= static_cast<int>(c.nodes.size()) && c.nodes[depth - 1] <= g_options.max_nodes; depth++) {
+				uint64_t depth_nodes = 0;
+				perft_seconds += measure_seconds([&] { depth_nodes = game.perft(depth); });
+				EXPECT_EQ(depth_nodes, c.nodes[depth - 1]) << c.name << " depth " << depth;
+				nodes += depth_nodes;
+			}
+			const MctsResult result = search.search(game, limits);
+			playouts += result.playouts;
+			search_seconds += result.seconds;
+		}
+		const std::string name = mode == CoverageMode::INCREMENTAL ? "incremental" : "on_demand";
+		const double nps = perft_seconds > 0.0 ? nodes / perft_seconds : 0.0;
+		const double pps = search_seconds > 0.0 ? playouts / search_seconds : 0.0;
+		std::printf("%-20s %12llu %12.0f %14.0f\n", name.c_str(), static_cast<unsigned long long>(nodes), nps, pps);
+		RecordProperty(name + "_nodes_per_sec", std::to_string(static_cast<uint64_t>(nps)));
+	}
+}
+
+static bool parse_option(const char* arg, const char* name, std::string& value)
+{
+	const size_t n = std::strlen(name);
+	if (std::strncmp(arg, name, n) != 0 || arg[n] != '=') return false;
+	value = arg + n + 1;
+	return true;
+}
+
+GTEST_API_ int main(int argc, char** argv) {
+	testing::InitGoogleTest(&argc, argv);
+
+	if (const char* env = std::getenv("PERFT_MAX_NODES")) g_options.max_nodes = std::strtoull(env, nullptr, 10);
+	if (const char* env = std::getenv("PERFT_MIN_NPS")) g_options.min_nps = std::strtoull(env, nullptr, 10);
+	if (const char* env = std::getenv("PERFT_DATA")) g_options.data = env;
+	for (int i = 1; i < argc; i++) {
+		std::string value;
+		if (parse_option(argv[i], "--max-nodes", value)) g_options.max_nodes = std::stoull(value);
+		else if (parse_option(argv[i], "--min-nps", value)) g_options.min_nps = std::stoull(value);
+		else if (parse_option(argv[i], "--data", value)) g_options.data = value;
+		else {
+			std::printf("unknown option %s\n", argv[i]);
+			return 1;
+		}
+	}
+	return RUN_ALL_TESTS();
+}
@@ -0,0 +1,307 @@
+#include "BatchEval.h"
+#include "Game.h"
+#include "GameSimd.h"
+
+#include <algorithm>
+#include <thread>
+
+// centipawns per attacked square
+#define EVAL_MOBILITY_KNIGHT 4
+#define EVAL_MOBILITY_BISHOP 5
+#define EVAL_MOBILITY_ROOK 2
+#define EVAL_MOBILITY_QUEEN 1
+#define EVAL_BLACK 8
+
+
+// piece square tables from white's point of view, rank 8 first. Indexed by Piece
+static constexpr int PIECE_VALUE[7] = { 0, 0, 900, 330, 320, 500, 100 };
+static constexpr int PIECE_SQUARE[7][GAME_BOARD_SIZE] = {
+	{},
+	// king
+	{ -30,-40,-40,-50,-50,-40,-40,-30,
+	  -30,-40,-40,-50,-50,-40,-40,-30,
+	  -30,-40,-40,-50,-50,-40,-40,-30,
+	  -30,-40,-40,-50,-50,-40,-40,-30,
+	  -20,-30,-30,-40,-40,-30,-30,-20,
+	  -10,-20,-20,-20,-20,-20,-20,-10,
+	   20, 20,  0,  0,  0,  0, 20, 20,
+	   20, 30, 10,  0,  0, 10, 30, 20 },
+	// queen
+	{ -20,-10,-10, -5, -5,-10,-10,-20,
+	  -10,  0,  0,  0,  0,  0,  0,-10,
+	  -10,  0,  5,  5,  5,  5,  0,-10,
+	   -5,  0,  5,  5,  5,  5,  0, -5,
+	    0,  0,  5,  5,  5,  5,  0, -5,
+	  -10,  5,  5,  5,  5,  5,  0,-10,
+	  -10,  0,  5,  0,  0,  0,  0,-10,
+	  -20,-10,-10, -5, -5,-10,-10,-20 },
+	// bishop
+	{ -20,-10,-10,-10,-10,-10,-10,-20,
+	  -10,  0,  0,  0,  0,  0,  0,-10,
+	  -10,  0,  5, 10, 10,  5,  0,-10,
+	  -10,  5,  5, 10, 10,  5,  5,-10,
+	  -10,  0, 10, 10, 10, 10,  0,-10,
+	  -10, 10, 10, 10, 10, 10, 10,-10,
+	  -10,  5,  0,  0,  0,  0,  5,-10,
+	  -20,-10,-10,-10,-10,-10,-10,-20 },
+	// knight
+	{ -50,-40,-30,-30,-30,-30,-40,-50,
+	  -40,-20,  0,  0,  0,  0,-20,-40,
+	  -30,  0, 10, 15, 15, 10,  0,-30,
+	  -30,  5, 15, 20, 20, 15,  5,-30,
+	  -30,  0, 15, 20, 20, 15,  0,-30,
+	  -30,  5, 10, 15, 15, 10,  5,-30,
+	  -40,-20,  0,  5,  5,  0,-20,-40,
+	  -50,-40,-30,-30,-30,-30,-40,-50 },
+	// rook
+	{   0,  0,  0,  0,  0,  0,  0,  0,
+	    5, 10, 10, 10, 10, 10, 10,  5,
+	   -5,  0,  0,  0,  0,  0,  0, -5,
+	   -5,  0,  0,  0,  0,  0,  0, -5,
+	   -5,  0,  0,  0,  0,  0,  0, -5,
+	   -5,  0,  0,  0,  0,  0,  0, -5,
+	   -5,  0,  0,  0,  0,  0,  0, -5,
+	    0,  0,  0,  5,  5,  0,  0,  0 },
+	// pawn
+	{   0,  0,  0,  0,  0,  0,  0,  0,
+	   50, 50, 50, 50, 50, 50, 50, 50,
+	   10, 10, 20, 30, 30, 20, 10, 10,
+	    5,  5, 10, 25, 25, 10,  5,  5,
+	    0,  0,  0, 20, 20,  0,  0,  0,
+	    5, -5,-10,  0,  0,-10, -5,  5,
+	    5, 10, 10,-20,-20, 10, 10,  5,
+	    0,  0,  0,  0,  0,  0,  0,  0 },
+};
+
+struct EvalTables {
+	// material and piece square value per piece code and bindex, negative for black
+	std::array<std::array<int16_t, GAME_BOARD_SIZE>, 16> square_value;
+	// knight targets per bindex, -1 terminated
+	std::array<std::array<int8_t, 9>, GAME_BOARD_SIZE> knight;
+	// squares along the 4 orthogonal and 4 diagonal rays of a bindex, -1 terminated
+	std::array<std::array<std::array<int8_t, 8>, 8>, GAME_BOARD_SIZE> rays;
+};
+
+static constexpr EvalTables make_eval_tables()
+{
+	EvalTables tables{};
+	for (int p = 1; p <= 6; p++) {
+		for (int bindex = 0; bindex < GAME_BOARD_SIZE; bindex++) {
+			// the tables list rank 8 first, so white squares are mirrored and black squares are not
+			tables.square_value[p][bindex] = static_cast<int16_t>(PIECE_VALUE[p] + PIECE_SQUARE[p][bindex ^ 56]);
+			tables.square_value[p | EVAL_BLACK][bindex] = static_cast<int16_t>(-(PIECE_VALUE[p] + PIECE_SQUARE[p][bindex]));
+		}
+	}
+	constexpr int knight_dx[8] = { 1, 2, 2, 1, -1, -2, -2, -1 };
+	constexpr int knight_dy[8] = { 2, 1, -1, -2, -2, -1, 1, 2 };
+	constexpr int ray_dx[8] = { 0, 1, 0, -1, 1, 1, -1, -1 };
+	constexpr int ray_dy[8] = { 1, 0, -1, 0, 1, -1, -1, 1 };
+	for (int bindex = 0; bindex < GAME_BOARD_SIZE; bindex++) {
+		const int x = bindex % GAME_WIDTH;
+		const int y = bindex / GAME_WIDTH;
+		int n = 0;
+		for (int i = 0; i < 8; i++) {
+			const int tx = x + knight_dx[i];
+			const int ty = y + knight_dy[i];
+			if (tx >= 0 && tx < GAME_WIDTH && ty >= 0 && ty < GAME_HEIGHT) tables.knight[bindex][n++] = static_cast<int8_t>(ty * GAME_WIDTH + tx);
+		}
+		tables.knight[bindex][n] = -1;
+		for (int dir = 0; dir < 8; dir++) {
+			int steps = 0;
+			for (int tx = x + ray_dx[dir], ty = y + ray_dy[dir]; tx >= 0 && tx < GAME_WIDTH && ty >= 0 && ty < GAME_HEIGHT; tx += ray_dx[dir], ty += ray_dy[dir]) {
+				tables.rays[bindex][dir][steps++] = static_cast<int8_t>(ty * GAME_WIDTH + tx);
+			}
+			if (steps < 8) tables.rays[bindex][dir][steps] = -1;
+		}
+	}
+	return tables;
+}
+
+static constexpr EvalTables EVAL_TABLES = make_eval_tables();
+
+static int piece_code(const PositionSnapshot& snapshot, int bindex)
+{
+	return (snapshot.board[bindex / 2] >> (4 * (bindex & 1))) & 0xF;
+}
+
+
+PositionBatch::PositionBatch() :
+	m_blocks(),
+	m_size(0)
+{
+}
+
+void PositionBatch::clear()
+{
+	m_blocks.clear();
+	m_size = 0;
+}
+
+void PositionBatch::reserve(int positions)
+{
+	m_blocks.reserve((positions + BATCH_LANES - 1) / BATCH_LANES);
+}
+
+bool PositionBatch::add(std::string_view fen)
+{
+	thread_local Game game;
+	game.new_game(fen);
+	if (!game.get_init_ok()) return false;
+	set_lane(game.get_snapshot());
+	return true;
+}
+
+void PositionBatch::add(const PositionSnapshot& snapshot)
+{
+	set_lane(snapshot);
+}
+
+void PositionBatch::set_lane(const PositionSnapshot& snapshot)
+{
+	const int lane = m_size % BATCH_LANES;
+	if (lane == 0) m_blocks.emplace_back(Block{});
+	Block& block = m_blocks.back();
+	for (int bindex = 0; bindex < GAME_BOARD_SIZE; bindex++) block.squares[bindex][lane] = static_cast<int16_t>(piece_code(snapshot, bindex));
+	block.black_to_move[lane] = snapshot.black_to_move ? -1 : 0;
+	block.castles[lane] = snapshot.castles;
+	block.p2_index[lane] = snapshot.p2_index;
+	m_size++;
+}
+
+int PositionBatch::size() const
+{
+	return m_size;
+}
+
+const std::vector<PositionBatch::Block>& PositionBatch::get_blocks() const
+{
+	return m_blocks;
+}
+
+
+int evaluate_static(const PositionSnapshot& snapshot)
+{
+	std::array<int, GAME_BOARD_SIZE> code;
+	for (int bindex = 0; bindex < GAME_BOARD_SIZE; bindex++) code[bindex] = piece_code(snapshot, bindex);
+
+	int score = 0;
+	for (int bindex = 0; bindex < GAME_BOARD_SIZE; bindex++) {
+		const int c = code[bindex];
+		if (c == 0) continue;
+		score += EVAL_TABLES.square_value[c][bindex];
+
+		const Piece p = static_cast<Piece>(c & 7);
+		const bool white = c < EVAL_BLACK;
+		const int sign = white ? 1 : -1;
+		const auto not_own = [&](int target) { return code[target] == 0 || (code[target] < EVAL_BLACK) != white; };
+		if (p == Piece::KNIGHT) {
+			for (const int8_t target : EVAL_TABLES.knight[bindex]) {
+				if (target < 0) break;
+				if (not_own(target)) score += sign * EVAL_MOBILITY_KNIGHT;
+			}
+			continue;
+		}
+		int weight_orthogonal = 0;
+		int weight_diagonal = 0;
+		if (p == Piece::BISHOP) weight_diagonal = EVAL_MOBILITY_BISHOP;
+		if (p == Piece::ROOK) weight_orthogonal = EVAL_MOBILITY_ROOK;
+		if (p == Piece::QUEEN) weight_orthogonal = weight_diagonal = EVAL_MOBILITY_QUEEN;
+		for (int dir = 0; dir < 8; dir++) {
+			const int weight = dir < 4 ? weight_orthogonal : weight_diagonal;
+			if (weight == 0) continue;
+			for (const int8_t target : EVAL_TABLES.rays[bindex][dir]) {
+				if (target < 0) break;
+				if (not_own(target)) score += sign * weight;
+				if (code[target] != 0) break;
+			}
+		}
+	}
+	return snapshot.black_to_move ? -score : score;
+}
+
+/// <summary>
+/// evaluate_static for all lanes of block. Every step is done for all lanes, lanes without the piece add zero
+/// </summary>
+static void evaluate_block(const PositionBatch::Block& block, int16_t* out)
+{
+	std::array<Lanes16, GAME_BOARD_SIZE> code, white, black, empty;
+	const Lanes16 zero = Lanes16::zero();
+	const Lanes16 black_bit = Lanes16::set1(EVAL_BLACK);
+	for (int bindex = 0; bindex < GAME_BOARD_SIZE; bindex++) {
+		code[bindex] = Lanes16::load(block.squares[bindex].data());
+		empty[bindex] = Lanes16::eq(code[bindex], zero);
+		black[bindex] = Lanes16::gt(code[bindex], black_bit);
+		white[bindex] = Lanes16::andnot(empty[bindex], Lanes16::gt(black_bit, code[bindex]));
+	}
+
+	const auto piece = [](int p, bool is_black) { return Lanes16::set1(static_cast<int16_t>(p | (is_black ? EVAL_BLACK : 0))); };
+	Lanes16 score = zero;
+	for (int bindex = 0; bindex < GAME_BOARD_SIZE; bindex++) {
+		const Lanes16 c = code[bindex];
+		if (!Lanes16::andnot(empty[bindex], Lanes16::set1(-1)).any()) continue;
+
+		// material and piece squares: one compare per piece code
+		for (int p = 1; p <= 6; p++) {
+			score = score + (Lanes16::eq(c, piece(p, false)) & Lanes16::set1(EVAL_TABLES.square_value[p][bindex]));
+			score = score + (Lanes16::eq(c, piece(p, true)) & Lanes16::set1(EVAL_TABLES.square_value[p | EVAL_BLACK][bindex]));
+		}
+
+		// mobility weights of the piece on bindex per lane, zero if there is none
+		const Lanes16 knight_w = Lanes16::eq(c, piece(static_cast<int>(Piece::KNIGHT), false)) & Lanes16::set1(EVAL_MOBILITY_KNIGHT);
+		const Lanes16 knight_b = Lanes16::eq(c, piece(static_cast<int>(Piece::KNIGHT), true)) & Lanes16::set1(EVAL_MOBILITY_KNIGHT);
+		if ((knight_w | knight_b).any()) {
+			for (const int8_t target : EVAL_TABLES.knight[bindex]) {
+				if (target < 0) break;
+				score = score + Lanes16::andnot(white[target], knight_w) - Lanes16::andnot(black[target], knight_b);
+			}
+		}
+		const Lanes16 queen_w = Lanes16::eq(c, piece(static_cast<int>(Piece::QUEEN), false)) & Lanes16::set1(EVAL_MOBILITY_QUEEN);
+		const Lanes16 queen_b = Lanes16::eq(c, piece(static_cast<int>(Piece::QUEEN), true)) & Lanes16::set1(EVAL_MOBILITY_QUEEN);
+		const Lanes16 orthogonal_w = queen_w | (Lanes16::eq(c, piece(static_cast<int>(Piece::ROOK), false)) & Lanes16::set1(EVAL_MOBILITY_ROOK));
+		const Lanes16 orthogonal_b = queen_b | (Lanes16::eq(c, piece(static_cast<int>(Piece::ROOK), true)) & Lanes16::set1(EVAL_MOBILITY_ROOK));
+		const Lanes16 diagonal_w = queen_w | (Lanes16::eq(c, piece(static_cast<int>(Piece::BISHOP), false)) & Lanes16::set1(EVAL_MOBILITY_BISHOP));
+		const Lanes16 diagonal_b = queen_b | (Lanes16::eq(c, piece(static_cast<int>(Piece::BISHOP), true)) & Lanes16::set1(EVAL_MOBILITY_BISHOP));
+		for (int dir = 0; dir < 8; dir++) {
+			// weights stay set while the ray is open in that lane
+			Lanes16 open_w = dir < 4 ? orthogonal_w : diagonal_w;
+			Lanes16 open_b = dir < 4 ? orthogonal_b : diagonal_b;
+			for (const int8_t target : EVAL_TABLES.rays[bindex][dir]) {
+				if (target < 0 || !(open_w | open_b).any()) break;
+				score = score + Lanes16::andnot(white[target], open_w) - Lanes16::andnot(black[target], open_b);
+				open_w = open_w & empty[target];
+				open_b = open_b & empty[target];
+			}
+		}
+	}
+
+	// negate for black to move: (x ^ -1) - -1 == -x
+	const Lanes16 black_to_move = Lanes16::load(block.black_to_move.data());
+	score = (score ^ black_to_move) - black_to_move;
+	score.store(out);
+}
+
+void evaluate_batch(const PositionBatch& batch, std::span<int> out, int threads)
+{
+	const std::vector<PositionBatch::Block>& blocks = batch.get_blocks();
+	const int block_count = static_cast<int>(blocks.size());
+	const int size = std::min(batch.size(), static_cast<int>(out.size()));
+	const auto evaluate_range = [&](int begin, int end) {
+		alignas(32) std::array<int16_t, BATCH_LANES> scores;
+		for (int b = begin; b < end; b++) {
+			evaluate_block(blocks[b], scores.data());
+			for (int lane = 0; lane < BATCH_LANES && b * BATCH_LANES + lane < size; lane++) out[b * BATCH_LANES + lane] = scores[lane];
+		}
+	};
+
+	if (threads <= 0) threads = static_cast<int>(std::thread::hardware_concurrency());
+	threads = std::clamp(threads, 1, std::max(block_count, 1));
+	if (threads == 1) {
+		evaluate_range(0, block_count);
+		return;
+	}
+	std::vector<std::thread> workers;
+	for (int i = 0; i < threads; i++) {
+		workers.emplace_back(evaluate_range, block_count * i / threads, block_count * (i + 1) / threads);
+	}
+	for (std::thread& worker : workers) worker.join();
+}
@@ -0,0 +1,399 @@
+#include "BatchMoveGen.h"
+#include "GameSimd.h"
+
+#include <algorithm>
+#include <bit>
+#include <thread>
+
+// set in the piece codes of black pieces
+#define MOVEGEN_BLACK 8
+
+static constexpr int KING = static_cast<int>(Piece::KING);
+static constexpr int QUEEN = static_cast<int>(Piece::QUEEN);
+static constexpr int BISHOP = static_cast<int>(Piece::BISHOP);
+static constexpr int KNIGHT = static_cast<int>(Piece::KNIGHT);
+static constexpr int ROOK = static_cast<int>(Piece::ROOK);
+static constexpr int PAWN = static_cast<int>(Piece::PAWN);
+
+struct MoveGenTables {
+	// knight and king targets per bindex, -1 terminated
+	std::array<std::array<int8_t, 9>, GAME_BOARD_SIZE> knight;
+	std::array<std::array<int8_t, 9>, GAME_BOARD_SIZE> king;
+	// squares along the rays of a bindex in Direction order N, E, S, W, NE, SE, SW, NW, -1 terminated
+	std::array<std::array<std::array<int8_t, 8>, 8>, GAME_BOARD_SIZE> rays;
+	// the same as bitboards
+	std::array<uint64_t, GAME_BOARD_SIZE> knight_mask;
+	std::array<uint64_t, GAME_BOARD_SIZE> king_mask;
+	std::array<std::array<uint64_t, 8>, GAME_BOARD_SIZE> ray_mask;
+	// capture targets of a white [0] or black [1] pawn
+	std::array<std::array<uint64_t, GAME_BOARD_SIZE>, 2> pawn_capture_mask;
+};
+
+static constexpr MoveGenTables make_movegen_tables()
+{
+	MoveGenTables tables{};
+	constexpr int knight_dx[8] = { 1, 2, 2, 1, -1, -2, -2, -1 };
+	constexpr int knight_dy[8] = { 2, 1, -1, -2, -2, -1, 1, 2 };
+	constexpr int ray_dx[8] = { 0, 1, 0, -1, 1, 1, -1, -1 };
+	constexpr int ray_dy[8] = { 1, 0, -1, 0, 1, -1, -1, 1 };
+	const auto on_board = [](int x, int y) { return x >= 0 && x < GAME_WIDTH && y >= 0 && y < GAME_HEIGHT; };
+	for (int bindex = 0; bindex < GAME_BOARD_SIZE; bindex++) {
+		const int x = bindex % GAME_WIDTH;
+		const int y = bindex / GAME_WIDTH;
+		int knights = 0;
+		int kings = 0;
+		for (int i = 0; i < 8; i++) {
+			if (on_board(x + knight_dx[i], y + knight_dy[i])) {
+				const int target = (y + knight_dy[i]) * GAME_WIDTH + x + knight_dx[i];
+				tables.knight[bindex][knights++] = static_cast<int8_t>(target);
+				tables.knight_mask[bindex] |= uint64_t(1) << target;
+			}
+			if (on_board(x + ray_dx[i], y + ray_dy[i])) {
+				const int target = (y + ray_dy[i]) * GAME_WIDTH + x + ray_dx[i];
+				tables.king[bindex][kings++] = static_cast<int8_t>(target);
+				tables.king_mask[bindex] |= uint64_t(1) << target;
+				// NE, NW for white and SE, SW for black
+				if (i == 4 || i == 7) tables.pawn_capture_mask[0][bindex] |= uint64_t(1) << target;
+				if (i == 5 || i == 6) tables.pawn_capture_mask[1][bindex] |= uint64_t(1) << target;
+			}
+		}
+		tables.knight[bindex][knights] = -1;
+		tables.king[bindex][kings] = -1;
+		for (int dir = 0; dir < 8; dir++) {
+			int steps = 0;
+			for (int tx = x + ray_dx[dir], ty = y + ray_dy[dir]; on_board(tx, ty); tx += ray_dx[dir], ty += ray_dy[dir]) {
+				tables.rays[bindex][dir][steps++] = static_cast<int8_t>(ty * GAME_WIDTH + tx);
+				tables.ray_mask[bindex][dir] |= uint64_t(1) << (ty * GAME_WIDTH + tx);
+			}
+			if (steps < 8) tables.rays[bindex][dir][steps] = -1;
+		}
+	}
+	return tables;
+}
+
+static constexpr MoveGenTables MOVEGEN_TABLES = make_movegen_tables();
+
+typedef std::array<std::array<int16_t, BATCH_LANES>, GAME_BOARD_SIZE> LaneSquares;
+
+/// <summary>
+/// Squares attacked by the side not to move, for all lanes of block (non zero if attacked).
+/// The king of the side to move does not block the sliders, so it can not step back along a checking ray.
+/// </summary>
+static void attack_block(const PositionBatch::Block& block, LaneSquares& attacked)
+{
+	std::array<Lanes16, GAME_BOARD_SIZE> type, enemy, open, attack;
+	const Lanes16 zero = Lanes16::zero();
+	const Lanes16 black_to_move = Lanes16::load(block.black_to_move.data());
+	for (int bindex = 0; bindex < GAME_BOARD_SIZE; bindex++) {
+		const Lanes16 code = Lanes16::load(block.squares[bindex].data());
+		const Lanes16 occupied = Lanes16::gt(code, zero);
+		const Lanes16 black = Lanes16::gt(code, Lanes16::set1(static_cast<int16_t>(MOVEGEN_BLACK)));
+		const Lanes16 white = Lanes16::andnot(black, occupied);
+		type[bindex] = code & Lanes16::set1(7);
+		enemy[bindex] = Lanes16::andnot(black_to_move, black) | (black_to_move & white);
+		const Lanes16 own_king = Lanes16::andnot(enemy[bindex], occupied) & Lanes16::eq(type[bindex], Lanes16::set1(KING));
+		open[bindex] = Lanes16::andnot(occupied, Lanes16::set1(-1)) | own_king;
+		attack[bindex] = zero;
+	}
+
+	for (int bindex = 0; bindex < GAME_BOARD_SIZE; bindex++) {
+		const Lanes16 e = enemy[bindex];
+		if (!e.any()) continue;
+		const Lanes16 t = type[bindex];
+		const Lanes16 queen = Lanes16::eq(t, Lanes16::set1(QUEEN));
+
+		const Lanes16 knight = e & Lanes16::eq(t, Lanes16::set1(KNIGHT));
+		if (knight.any()) {
+			for (const int8_t target : MOVEGEN_TABLES.knight[bindex]) {
+				if (target < 0) break;
+				attack[target] = attack[target] | knight;
+			}
+		}
+		const Lanes16 king = e & Lanes16::eq(t, Lanes16::set1(KING));
+		if (king.any()) {
+			for (const int8_t target : MOVEGEN_TABLES.king[bindex]) {
+				if (target < 0) break;
+				attack[target] = attack[target] | king;
+			}
+		}
+		const Lanes16 pawn = e & Lanes16::eq(t, Lanes16::set1(PAWN));
+		if (pawn.any()) {
+			// enemy pawns are white in the lanes with black to move
+			const Lanes16 pawn_by_color[2] = { pawn & black_to_move, Lanes16::andnot(black_to_move, pawn) };
+			for (int color = 0; color < 2; color++) {
+				for (uint64_t targets = MOVEGEN_TABLES.pawn_capture_mask[color][bindex]; targets; targets &= targets - 1) {
+					const int target = std::countr_zero(targets);
+					attack[target] = attack[target] | pawn_by_color[color];
+				}
+			}
+		}
+		const Lanes16 orthogonal = e & (queen | Lanes16::eq(t, Lanes16::set1(ROOK)));
+		const Lanes16 diagonal = e & (queen | Lanes16::eq(t, Lanes16::set1(BISHOP)));
+		if (!(orthogonal | diagonal).any()) continue;
+		for (int dir = 0; dir < 8; dir++) {
+			// set while the ray is open in that lane
+			Lanes16 ray = dir < 4 ? orthogonal : diagonal;
+			for (const int8_t target : MOVEGEN_TABLES.rays[bindex][dir]) {
+				if (target < 0 || !ray.any()) break;
+				attack[target] = attack[target] | ray;
+				ray = ray & open[target];
+			}
+		}
+	}
+	for (int bindex = 0; bindex < GAME_BOARD_SIZE; bindex++) attack[bindex].store(attacked[bindex].data());
+}
+
+static uint64_t bit(int bindex)
+{
+	return uint64_t(1) << bindex;
+}
+
+// nearest square of blockers (not empty) along ray dir
+static int nearest(uint64_t blockers, int dir)
+{
+	// N, E, NE and NW go to higher bindex
+	return dir == 0 || dir == 1 || dir == 4 || dir == 7 ? std::countr_zero(blockers) : 63 - std::countl_zero(blockers);
+}
+
+// squares reached from bindex along ray dir up to and including the first occupied square
+static uint64_t ray_attacks(int bindex, int dir, uint64_t occupied)
+{
+	const uint64_t ray = MOVEGEN_TABLES.ray_mask[bindex][dir];
+	const uint64_t blockers = ray & occupied;
+	return blockers ? ray ^ MOVEGEN_TABLES.ray_mask[nearest(blockers, dir)][dir] : ray;
+}
+
+static uint64_t slider_attacks(int bindex, int first_dir, int last_dir, uint64_t occupied)
+{
+	uint64_t attacks = 0;
+	for (int dir = first_dir; dir < last_dir; dir++) attacks |= ray_attacks(bindex, dir, occupied);
+	return attacks;
+}
+
+/// <summary>
+/// Piece bitboards of one position, own and enemy relative to the side to move
+/// </summary>
+struct LaneBoards {
+	bool black;
+	uint64_t own;
+	uint64_t enemy;
+	uint64_t occupied;
+	// indexed by Piece
+	std::array<uint64_t, 7> own_pieces;
+	std::array<uint64_t, 7> enemy_pieces;
+};
+
+// is bindex attacked by the enemy pieces with occupied as blockers
+static bool is_attacked(const LaneBoards& boards, int bindex, uint64_t occupied, uint64_t enemy_pawns)
+{
+	const std::array<uint64_t, 7>& enemy = boards.enemy_pieces;
+	if (MOVEGEN_TABLES.knight_mask[bindex] & enemy[KNIGHT]) return true;
+	if (MOVEGEN_TABLES.king_mask[bindex] & enemy[KING]) return true;
+	if (MOVEGEN_TABLES.pawn_capture_mask[boards.black][bindex] & enemy_pawns) return true;
+	if (slider_attacks(bindex, 0, 4, occupied) & (enemy[ROOK] | enemy[QUEEN])) return true;
+	return (slider_attacks(bindex, 4, 8, occupied) & (enemy[BISHOP] | enemy[QUEEN])) != 0;
+}
+
+/// <summary>
+/// Legal moves of one lane of block, written to out if it is not null. returns the number of moves
+/// </summary>
+static int generate_lane(const PositionBatch::Block& block, const LaneSquares& attacked, int lane, GameMoveInt* out)
+{
+	// one byte per square, turned into bitboards by comparing all squares at once
+	alignas(32) std::array<uint8_t, GAME_BOARD_SIZE> codes;
+	alignas(32) std::array<uint8_t, GAME_BOARD_SIZE> attacks;
+	for (int bindex = 0; bindex < GAME_BOARD_SIZE; bindex++) {
+		codes[bindex] = static_cast<uint8_t>(block.squares[bindex][lane]);
+		attacks[bindex] = static_cast<uint8_t>(attacked[bindex][lane] != 0);
+	}
+	const uint64_t attacked_mask = ~equal_mask64(attacks.data(), 0);
+	LaneBoards boards;
+	boards.black = block.black_to_move[lane] != 0;
+	const int own_offset = boards.black ? MOVEGEN_BLACK : 0;
+	boards.own = 0;
+	boards.enemy = 0;
+	boards.own_pieces[0] = 0;
+	boards.enemy_pieces[0] = 0;
+	for (int p = KING; p <= PAWN; p++) {
+		boards.own_pieces[p] = equal_mask64(codes.data(), static_cast<uint8_t>(p | own_offset));
+		boards.enemy_pieces[p] = equal_mask64(codes.data(), static_cast<uint8_t>(p | (own_offset ^ MOVEGEN_BLACK)));
+		boards.own |= boards.own_pieces[p];
+		boards.enemy |= boards.enemy_pieces[p];
+	}
+	boards.occupied = boards.own | boards.enemy;
+	if (!boards.own_pieces[KING]) return 0;
+	const int king = std::countr_zero(boards.own_pieces[KING]);
+	const std::array<uint64_t, 7>& own = boards.own_pieces;
+	const std::array<uint64_t, 7>& enemy = boards.enemy_pieces;
+
+	// checkers and pinned pieces, seen from the king
+	uint64_t check_mask = ~uint64_t(0);
+	int checkers = 0;
+	uint64_t pinned = 0;
+	std::array<uint64_t, GAME_BOARD_SIZE> pin_ray;
+	for (int dir = 0; dir < 8; dir++) {
+		const uint64_t sliders = enemy[QUEEN] | enemy[dir < 4 ? ROOK : BISHOP];
+		const uint64_t ray = MOVEGEN_TABLES.ray_mask[king][dir];
+		if (!(ray & sliders)) continue;
+		const uint64_t blockers = ray & boards.occupied;
+		const int first = nearest(blockers, dir);
+		if (sliders & bit(first)) {
+			checkers++;
+			check_mask = ray ^ MOVEGEN_TABLES.ray_mask[first][dir];
+			continue;
+		}
+		if (!(boards.own & bit(first)) || blockers == bit(first)) continue;
+		const int second = nearest(blockers ^ bit(first), dir);
+		if (sliders & bit(second)) {
+			pinned |= bit(first);
+			pin_ray[first] = ray ^ MOVEGEN_TABLES.ray_mask[second][dir];
+		}
+	}
+	const uint64_t leapers = (MOVEGEN_TABLES.knight_mask[king] & enemy[KNIGHT]) | (MOVEGEN_TABLES.pawn_capture_mask[boards.black][king] & enemy[PAWN]);
+	if (leapers) {
+		checkers += std::popcount(leapers);
+		check_mask = leapers;
+	}
+	// double check: only the king moves
+	if (checkers > 1) check_mask = 0;
+
+	int count = 0;
+	const auto add = [&count, out](int from, uint64_t targets) {
+		if (!out) {
+			count += std::popcount(targets);
+			return;
+		}
+		for (; targets; targets &= targets - 1) out[count++] = GameMoveInt(from, std::countr_zero(targets));
+	};
+
+	add(king, MOVEGEN_TABLES.king_mask[king] & ~boards.own & ~attacked_mask);
+	if (check_mask) {
+		const auto allowed = [&](int from) { return pinned & bit(from) ? check_mask & pin_ray[from] : check_mask; };
+		for (uint64_t pieces = own[KNIGHT] & ~pinned; pieces; pieces &= pieces - 1) {
+			const int from = std::countr_zero(pieces);
+			add(from, MOVEGEN_TABLES.knight_mask[from] & ~boards.own & check_mask);
+		}
+		for (uint64_t pieces = own[BISHOP] | own[QUEEN]; pieces; pieces &= pieces - 1) {
+			const int from = std::countr_zero(pieces);
+			add(from, slider_attacks(from, 4, 8, boards.occupied) & ~boards.own & allowed(from));
+		}
+		for (uint64_t pieces = own[ROOK] | own[QUEEN]; pieces; pieces &= pieces - 1) {
+			const int from = std::countr_zero(pieces);
+			add(from, slider_attacks(from, 0, 4, boards.occupied) & ~boards.own & allowed(from));
+		}
+
+		const int forward = boards.black ? -GAME_WIDTH : GAME_WIDTH;
+		const uint64_t promotion_rank = boards.black ? 0xFFull : 0xFFull << 56;
+		const uint64_t double_push_rank = boards.black ? 0xFFull << 32 : 0xFFull << 24;
+		const uint64_t empty = ~boards.occupied;
+		for (uint64_t pieces = own[PAWN]; pieces; pieces &= pieces - 1) {
+			const int from = std::countr_zero(pieces);
+			const int push = from + forward;
+			uint64_t targets = MOVEGEN_TABLES.pawn_capture_mask[boards.black][from] & boards.enemy;
+			if (empty & bit(push)) {
+				targets |= bit(push);
+				if (empty & double_push_rank & bit(push + forward)) targets |= bit(push + forward);
+			}
+			targets &= allowed(from);
+			if (!(targets & promotion_rank)) {
+				add(from, targets);
+				continue;
+			}
+			for (; targets; targets &= targets - 1) {
+				for (const Piece promotion : { Piece::QUEEN, Piece::ROOK, Piece::BISHOP, Piece::KNIGHT }) {
+					if (out) out[count] = GameMoveInt(from, std::countr_zero(targets), promotion);
+					count++;
+				}
+			}
+		}
+
+		// en passant: played on the bitboards, the captured pawn can uncover the king sideways
+		const int p2_index = block.p2_index[lane];
+		if (p2_index >= 0 && (enemy[PAWN] & bit(p2_index)) && (empty & bit(p2_index + forward))) {
+			const int to = p2_index + forward;
+			for (uint64_t pieces = MOVEGEN_TABLES.pawn_capture_mask[!boards.black][to] & own[PAWN]; pieces; pieces &= pieces - 1) {
+				const int from = std::countr_zero(pieces);
+				const uint64_t occupied = (boards.occupied ^ bit(from) ^ bit(p2_index)) | bit(to);
+				if (!is_attacked(boards, king, occupied, enemy[PAWN] ^ bit(p2_index))) add(from, bit(to));
+			}
+		}
+	}
+
+	// castles: the king passes two squares that must be empty and not attacked
+	const int castles = block.castles[lane] >> (boards.black ? 2 : 0);
+	const int home = boards.black ? GAME_BOARD_SIZE - GAME_WIDTH + 4 : 4;
+	if (checkers == 0 && king == home) {
+		const uint64_t blocked = boards.occupied | attacked_mask;
+		if ((castles & GAME_CASTLE_WHITE_KS) && (own[ROOK] & bit(home + 3)) && !(blocked & (bit(home + 1) | bit(home + 2)))) {
+			add(home, bit(home + 2));
+		}
+		if ((castles & GAME_CASTLE_WHITE_QS) && (own[ROOK] & bit(home - 4)) && !(boards.occupied & bit(home - 3))
+			&& !(blocked & (bit(home - 1) | bit(home - 2)))) {
+			add(home, bit(home - 2));
+		}
+	}
+	return count;
+}
+
+
+BatchMoveGen::BatchMoveGen() :
+	m_counts(),
+	m_moves()
+{
+}
+
+void BatchMoveGen::generate(const PositionBatch& batch, bool list_moves, int threads)
+{
+	const std::vector<PositionBatch::Block>& blocks = batch.get_blocks();
+	const int block_count = static_cast<int>(blocks.size());
+	const int size = batch.size();
+	m_counts.assign(size, 0);
+	if (list_moves) m_moves.resize(static_cast<size_t>(size) * GAME_MAX_MOVES);
+	else m_moves.clear();
+
+	const auto generate_range = [&](int begin, int end) {
+		LaneSquares attacked;
+		for (int b = begin; b < end; b++) {
+			attack_block(blocks[b], attacked);
+			for (int lane = 0; lane < BATCH_LANES && b * BATCH_LANES + lane < size; lane++) {
+				const int position = b * BATCH_LANES + lane;
+				m_counts[position] = generate_lane(blocks[b], attacked, lane, list_moves ? &m_moves[static_cast<size_t>(position) * GAME_MAX_MOVES] : nullptr);
+			}
+		}
+	};
+
+	if (threads <= 0) threads = static_cast<int>(std::thread::hardware_concurrency());
+	threads = std::clamp(threads, 1, std::max(block_count, 1));
+	if (threads == 1) {
+		generate_range(0, block_count);
+		return;
+	}
+	std::vector<std::thread> workers;
+	for (int i = 0; i < threads; i++) {
+		workers.emplace_back(generate_range, block_count * i / threads, block_count * (i + 1) / threads);
+	}
+	for (std::thread& worker : workers) worker.join();
+}
+
+int BatchMoveGen::size() const
+{
+	return static_cast<int>(m_counts.size());
+}
+
+int BatchMoveGen::get_count(int position) const
+{
+	return m_counts[position];
+}
+
+uint64_t BatchMoveGen::get_total_count() const
+{
+	uint64_t total = 0;
+	for (const int count : m_counts) total += count;
+	return total;
+}
+
+std::span<const GameMoveInt> BatchMoveGen::get_moves(int position) const
+{
+	if (m_moves.empty()) return {};
+	return { m_moves.data() + static_cast<size_t>(position) * GAME_MAX_MOVES, static_cast<size_t>(m_counts[position]) };
+}
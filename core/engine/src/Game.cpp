@@ -1,60 +1,98 @@
 #include "Game.h"
+#include "GameStats.h"
 
 #include <sstream>
 #include <algorithm>
+#include <bit>
+#include <cctype>
+#include <cstring>
 
 
-Game::Game(const std::string& fen, GameMoveStrFmt fmt, uint8_t MAX_HALF_TURNS) :
-	M_DEFAULT_FEN("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1"),
+Game::Game(std::string_view fen, GameMoveStrFmt fmt, uint8_t MAX_HALF_TURNS) :
+	Game(fmt, MAX_HALF_TURNS)
+{
+	if (!fen.empty()) {
+		m_fen_result = init_fen(fen);
+		if (!m_fen_result.ok()) return;
+	}
+	init_derived_state();
+}
+
+/// <summary>
+/// rebuilds coverage, pins and legal moves from the snapshot instead of copying them
+/// </summary>
+Game::Game(const PositionSnapshot& snapshot, GameMoveStrFmt fmt, uint8_t MAX_HALF_TURNS) :
+	Game(fmt, MAX_HALF_TURNS)
+{
+	m_fen_result = init_snapshot(snapshot);
+	if (!m_fen_result.ok()) return;
+	init_derived_state();
+}
+
+Game::Game(const PackedBoard& board, GameMoveStrFmt fmt, uint8_t MAX_HALF_TURNS) :
+	Game(fmt, MAX_HALF_TURNS)
+{
+	m_fen_result = init_packed(board);
+	if (!m_fen_result.ok()) return;
+	init_derived_state();
+}
+
+/// <summary>
+/// standard board without legal moves. Used by the public constructors
+/// </summary>
+Game::Game(GameMoveStrFmt fmt, uint8_t MAX_HALF_TURNS) :
 	m_board(),
 	m_swap_vars(),
-	m_gamedelta_list(), m_legal_moves(), m_pseudo_moves(), m_block_check_indices(),
-	m_pinned_direction(),
+	m_gamedelta_list(), m_redo_list(), m_checkpoints(), m_legal_states(), m_legal_state_moves(), m_observers(),
+	m_legal_moves(),
+	m_pin_mask(), m_check_mask(~uint64_t(0)),
 	m_ending_gamestate(),
 	m_string_fmt(fmt==GameMoveStrFmt::DEFAULT ? GameMoveStrFmt::UCI : fmt),
 	m_p2_index(-1),
-	m_fen_valid(true),
+	m_fen_result(),
+	m_start_fen(),
 	m_game_has_ended(false),
 	m_turn_number(1),
 	M_MAX_HALF_TURNS(MAX_HALF_TURNS),
-	m_half_turn_number(0)
+	m_half_turn_number(0),
+	m_legal_to_begin(), m_legal_by_to(), m_legal_disambiguation(),
+	m_legal_index_valid(false)
 {
-	m_pseudo_moves.reserve(28);
-	m_legal_moves.reserve(80);
+	// reserve the upper bounds once so that new_game never has to touch the heap
+	m_legal_moves.reserve(GAME_MAX_MOVES);
 	m_gamedelta_list.reserve(100);
-
-	if (!fen.empty()) {
-		m_fen_valid = init_fen(fen);
-		if (!m_fen_valid) return;
-	}
-
-	find_pinned_pieces();
-	find_legal_moves();
-	update_game_has_ended(get_is_check());
 }
 
 Game::Game(const Game& other) :
 	m_board(other.m_board),
 	m_swap_vars(other.m_swap_vars),
 	m_gamedelta_list(other.m_gamedelta_list),
+	m_redo_list(other.m_redo_list),
+	m_checkpoints(other.m_checkpoints),
+	m_legal_states(),
+	m_legal_state_moves(),
+	m_observers(),
 	m_legal_moves(other.m_legal_moves),
-	m_pseudo_moves(other.m_pseudo_moves),
-	m_block_check_indices(other.m_block_check_indices),
-	M_DEFAULT_FEN(other.M_DEFAULT_FEN),
-	m_pinned_direction(other.m_pinned_direction),
+	m_pin_mask(other.m_pin_mask),
+	m_check_mask(other.m_check_mask),
 	m_ending_gamestate(other.m_ending_gamestate),
 	m_string_fmt(other.m_string_fmt),
 	m_p2_index(other.m_p2_index),
-	m_fen_valid(other.m_fen_valid),
+	m_fen_result(other.m_fen_result),
+	m_start_fen(other.m_start_fen),
 	m_game_has_ended(other.m_game_has_ended),
 	m_turn_number(other.m_turn_number),
 	M_MAX_HALF_TURNS(other.M_MAX_HALF_TURNS),
-	m_half_turn_number(other.m_half_turn_number)
+	m_half_turn_number(other.m_half_turn_number),
+	m_legal_to_begin(), m_legal_by_to(), m_legal_disambiguation(),
+	m_legal_index_valid(false)
 {
 	// fix swapvar ptr
 	m_swap_vars.active = &m_swap_vars.white ; 
 	m_swap_vars.passive = &m_swap_vars.black;
 	if (other.m_swap_vars.active->color.IsBlack()) m_swap_vars.Swap();
+	// copies only keep capacity for their size
+	m_legal_moves.reserve(GAME_MAX_MOVES);
 }
 
 std::unique_ptr<IGame> Game::clone() const
@@ -69,7 +107,76 @@ Game::~Game()
 
 bool Game::get_init_ok() const
 {
-	return m_fen_valid;
+	return m_fen_result.ok();
+}
+
+FenResult Game::get_fen_result() const
+{
+	return m_fen_result;
+}
+
+int Game::to_fen(char* buffer, int buffer_size) const
+{
+	char fen[GAME_FEN_LEN_MAX];
+	int n = m_board.to_fen_board(fen);
+
+	fen[n++] = ' ';
+	fen[n++] = m_swap_vars.active->color.IsWhite() ? 'w' : 'b';
+
+	fen[n++] = ' ';
+	const int castles_begin = n;
+	if (m_swap_vars.white.castles.kscastle) fen[n++] = 'K';
+	if (m_swap_vars.white.castles.qscastle) fen[n++] = 'Q';
+	if (m_swap_vars.black.castles.kscastle) fen[n++] = 'k';
+	if (m_swap_vars.black.castles.qscastle) fen[n++] = 'q';
+	if (n == castles_begin) fen[n++] = '-';
+
+	fen[n++] = ' ';
+	if (m_p2_index == -1) fen[n++] = '-';
+	else {
+		// the ep square is the one the p2 pawn skipped
+		const Position ep = bindex_to_position(m_p2_index - m_swap_vars.passive->pawn_forward);
+		fen[n++] = char('a' + ep.x);
+		fen[n++] = char('1' + ep.y);
+	}
+
+	fen[n++] = ' ';
+	n += write_uint(fen + n, m_half_turn_number);
+	fen[n++] = ' ';
+	n += write_uint(fen + n, m_turn_number);
+
+	if (n + 1 > buffer_size) return 0;
+	std::copy(fen, fen + n, buffer);
+	buffer[n] = '\0';
+	return n;
+}
+
+int Game::get_start_fen(char* buffer, int buffer_size) const
+{
+	const int n = static_cast<int>(std::strlen(m_start_fen.data()));
+	if (n + 1 > buffer_size) return 0;
+	std::copy(m_start_fen.data(), m_start_fen.data() + n + 1, buffer);
+	return n;
+}
+
+uint64_t Game::get_hash() const
+{
+	uint64_t hash = m_board.get_hash();
+	if (m_swap_vars.active->color.IsBlack()) hash ^= zobrist_black_to_move_key();
+	if (m_swap_vars.white.castles.kscastle) hash ^= zobrist_castle_key(0);
+	if (m_swap_vars.white.castles.qscastle) hash ^= zobrist_castle_key(1);
+	if (m_swap_vars.black.castles.kscastle) hash ^= zobrist_castle_key(2);
+	if (m_swap_vars.black.castles.qscastle) hash ^= zobrist_castle_key(3);
+	if (m_p2_index != -1) {
+		// only if an active pawn stands next to the p2 pawn, so that transpositions hash equal
+		const int file = m_p2_index % GAME_WIDTH;
+		const UniquePiece left = file > 0 ? m_board.get_up(m_p2_index - 1) : UniquePiece{ 0, Piece::EMPTY };
+		const UniquePiece right = file < GAME_WIDTH - 1 ? m_board.get_up(m_p2_index + 1) : UniquePiece{ 0, Piece::EMPTY };
+		const bool capturable = (left.p == Piece::PAWN && left.IsAlly(m_swap_vars.active->color)) ||
+			(right.p == Piece::PAWN && right.IsAlly(m_swap_vars.active->color));
+		if (capturable) hash ^= zobrist_en_passant_key(file);
+	}
+	return hash;
 }
 
 ChessColor Game::get_active_color() const
@@ -82,137 +189,182 @@ int Game::get_turn_number() const
 	return m_turn_number;
 }
 
-std::vector<GameMove> Game::get_possible_moves() const 
+int Game::get_possible_moves(std::span<GameMove> out) const
 {
-	std::vector<GameMove> vret;
-	vret.reserve(m_legal_moves.size());
-	for (const GameMoveInt& m : m_legal_moves) {
-		vret.emplace_back(m.get_from(), m.get_to(), m.get_promotion());
+	const int number_of_moves = static_cast<int>(std::min(out.size(), m_legal_moves.size()));
+	for (int i = 0; i < number_of_moves; i++) {
+		out[i] = gmi_to_gm(m_legal_moves[i]);
 	}
-	return vret;
+	return number_of_moves;
 }
 
 std::vector<std::string> Game::get_possible_moves_str() const
 {
+	std::array<MoveStr, GAME_MAX_MOVES> moves;
+	const int number_of_moves = get_possible_moves_str(moves, m_string_fmt);
 	std::vector<std::string> vret;
-	vret.reserve(m_legal_moves.size());
-	for (const GameMoveInt& m : m_legal_moves) {
-		vret.push_back(legal_to_string(m));
+	vret.reserve(number_of_moves);
+	for (int i = 0; i < number_of_moves; i++) {
+		vret.emplace_back(moves[i].data());
 	}
 	return vret;
 }
 
-std::vector<GameMove> Game::get_possible_moves(int from_ind) const
+int Game::get_possible_moves_str(std::span<MoveStr> out, GameMoveStrFmt fmt) const
+{
+	if (fmt == GameMoveStrFmt::DEFAULT) fmt = m_string_fmt;
+	const int number_of_moves = static_cast<int>(std::min(out.size(), m_legal_moves.size()));
+	for (int i = 0; i < number_of_moves; i++) {
+		write_legal(out[i].data(), i, fmt);
+	}
+	return number_of_moves;
+}
+
+int Game::get_possible_moves(int from_ind, std::span<GameMove> out) const
 {
-	std::vector<GameMove> vret;
-	vret.reserve(28);
+	int n = 0;
 	for (const GameMoveInt& m : m_legal_moves) {
-		if (m.get_from() == from_ind) {
-			vret.emplace_back(m.get_from(), m.get_to(), m.get_promotion());
-		}
+		if (n == static_cast<int>(out.size())) break;
+		if (m.get_from() == from_ind) out[n++] = gmi_to_gm(m);
 	}
-	vret.shrink_to_fit();
-	return vret;
+	return n;
 }
 
-std::vector<int> Game::get_possible_moves_ind(int index) const
+int Game::get_possible_moves_ind(int index, std::span<int> out) const
 {
-	std::vector<int> vret;
-	vret.reserve(28);
+	int n = 0;
 	int pawn_to = 0, pawn_to_last = -1;
 	for (const GameMoveInt& ms : m_legal_moves) {
+		if (n == static_cast<int>(out.size())) break;
 		if (ms.get_from() == index) {
 			if (m_board.get_piece_from_bindex(index) != Piece::PAWN)
-				vret.push_back(ms.get_to());
+				out[n++] = ms.get_to();
 			else {  // filter multiple promotion moves assuming they come in order XDDDDDDDDD
 				pawn_to = ms.get_to();
-				if (pawn_to != pawn_to_last) vret.push_back(pawn_to);
+				if (pawn_to != pawn_to_last) out[n++] = pawn_to;
 				pawn_to_last = pawn_to;
 			}
 		}
 	}
-	vret.shrink_to_fit();
-	return vret;
+	return n;
 }
 
 std::vector<std::string> Game::get_possible_moves_str(const std::string& from_str) const
 {
-	//TODO
-	return std::vector<std::string>();
+	std::vector<std::string> vret;
+	if (from_str.size() != 2) return vret;
+	const Position from{ from_str[0] - 'a', from_str[1] - '1' };
+	if (from.x < 0 || from.x >= GAME_WIDTH || from.y < 0 || from.y >= GAME_HEIGHT) return vret;
+	const int from_bindex = position_to_bindex(from);
+
+	MoveStr move_str;
+	for (int i = 0; i < static_cast<int>(m_legal_moves.size()); i++) {
+		if (m_legal_moves[i].get_from() != from_bindex) continue;
+		const int len = write_legal(move_str.data(), i, m_string_fmt);
+		vret.emplace_back(move_str.data(), len);
+	}
+	return vret;
 }
 
-std::vector<TileI> Game::get_all_tiles_ind() const
+int Game::get_all_tiles_ind(std::span<TileI> out) const
 {
-	std::vector<TileI> vret;
-	vret.reserve(32);
-	for (int bindex = 0; bindex < GAME_BOARD_SIZE; bindex++) {
+	int n = 0;
+	for (int bindex = 0; bindex < GAME_BOARD_SIZE && n < static_cast<int>(out.size()); bindex++) {
 		const UniquePiece up = m_board.get_up(bindex);
-		if (!up.IsEmpty()) vret.emplace_back(bindex, up.p, up.GetColor());
+		if (!up.IsEmpty()) out[n++] = TileI{ bindex, up.p, up.GetColor() };
 	}
-	vret.shrink_to_fit();
-	return vret;
+	return n;
 }
 
-std::vector<TileI> Game::get_new_tiles_ind() const
+int Game::get_new_tiles_ind(std::span<TileI> out) const
 {
-	if (m_gamedelta_list.empty()) return std::vector<TileI>();
-	std::vector<TileI> vret;
-	vret.reserve(4);
-	const GameDelta& gd_last = m_gamedelta_list.back();
+	if (m_gamedelta_list.empty()) return 0;
+	std::array<TileI, GAME_MAX_CHANGED_TILES> tiles;
+	const int n = std::min(new_tiles(m_gamedelta_list.back(), tiles), static_cast<int>(out.size()));
+	std::copy(tiles.begin(), tiles.begin() + n, out.begin());
+	return n;
+}
 
-	const UniquePiece& up_from = m_board.get_up(gd_last.move.from);
-	Position p_from = bindex_to_position(gd_last.move.from);
-	vret.emplace_back(gd_last.move.from, up_from.p, up_from.GetColor());
+int Game::get_reverse_new_tiles_ind(std::span<TileI> out) const
+{
+	if (m_gamedelta_list.empty()) return 0;
+	std::array<TileI, GAME_MAX_CHANGED_TILES> tiles;
+	const int n = std::min(reverse_new_tiles(m_gamedelta_list.back(), tiles), static_cast<int>(out.size()));
+	std::copy(tiles.begin(), tiles.begin() + n, out.begin());
+	return n;
+}
 
-	const UniquePiece& up_to = m_board.get_up(gd_last.move.to);
-	Position p_to = bindex_to_position(gd_last.move.to);
-	vret.emplace_back(gd_last.move.to, up_to.p, up_to.GetColor());
+/// <summary>
+/// tiles changed by gd. Call after gd was applied
+/// </summary>
+int Game::new_tiles(const GameDelta& gd, std::array<TileI, GAME_MAX_CHANGED_TILES>& tiles) const
+{
+	int n = 0;
+	const UniquePiece& up_from = m_board.get_up(gd.move.from);
+	Position p_from = bindex_to_position(gd.move.from);
+	tiles[n++] = TileI{ gd.move.from, up_from.p, up_from.GetColor() };
 
+	const UniquePiece& up_to = m_board.get_up(gd.move.to);
+	Position p_to = bindex_to_position(gd.move.to);
+	tiles[n++] = TileI{ gd.move.to, up_to.p, up_to.GetColor() };
 
-	if (gd_last.IsEnPassant()) {
-		vret.emplace_back(position_to_bindex({ p_to.x, p_from.y }), Piece::EMPTY, ChessColor{});
-	}
 
-	if (gd_last.IsCastle()) {
-		const int rook_bindex = gd_last.move.from + (gd_last.IsKSCastle() ? 3 : -4);
-		const int king_adjacent_bindex = gd_last.move.from + (gd_last.IsKSCastle() ? 1 : -1);
-		vret.emplace_back(rook_bindex, Piece::EMPTY, ChessColor{});
-		vret.emplace_back(king_adjacent_bindex, Piece::ROOK, up_to.GetColor());
+	if (gd.IsEnPassant()) {
+		tiles[n++] = TileI{ position_to_bindex({ p_to.x, p_from.y }), Piece::EMPTY, ChessColor{} };
 	}
 
-	return vret;
+	if (gd.IsCastle()) {
+		const int rook_bindex = gd.move.from + (gd.IsKSCastle() ? 3 : -4);
+		const int king_adjacent_bindex = gd.move.from + (gd.IsKSCastle() ? 1 : -1);
+		tiles[n++] = TileI{ rook_bindex, Piece::EMPTY, ChessColor{} };
+		tiles[n++] = TileI{ king_adjacent_bindex, Piece::ROOK, up_to.GetColor() };
+	}
+	return n;
 }
 
-std::vector<TileI> Game::get_reverse_new_tiles_ind() const
+/// <summary>
+/// tiles changed by undoing gd. Call before gd is undone
+/// </summary>
+int Game::reverse_new_tiles(const GameDelta& gd, std::array<TileI, GAME_MAX_CHANGED_TILES>& tiles) const
 {
-	if (m_gamedelta_list.empty()) return std::vector<TileI>();
-	std::vector<TileI> vret;
-	vret.reserve(4);
-	const GameDelta& gd_last = m_gamedelta_list.back();
-	UniquePiece up_from = m_board.get_up(gd_last.move.to);
-	if (gd_last.IsPromotion()) up_from.p = Piece::PAWN;
-	vret.emplace_back(gd_last.move.from, up_from.p, up_from.GetColor());
+	int n = 0;
+	UniquePiece up_from = m_board.get_up(gd.move.to);
+	if (gd.IsPromotion()) up_from.p = Piece::PAWN;
+	tiles[n++] = TileI{ gd.move.from, up_from.p, up_from.GetColor() };
 
 	UniquePiece up_to{};
-	if (gd_last.IsTakes()) {
-		up_to = gd_last.takes;
+	if (gd.IsTakes()) {
+		up_to = gd.takes;
 	}
 
-	if (gd_last.IsEnPassant()) {
-		vret.emplace_back(gd_last.move.to - m_swap_vars.passive->pawn_forward, gd_last.takes.p, gd_last.takes.GetColor());
+	if (gd.IsEnPassant()) {
+		tiles[n++] = TileI{ gd.move.to - m_swap_vars.passive->pawn_forward, gd.takes.p, gd.takes.GetColor() };
 		up_to = UniquePiece();
 	}
-	vret.emplace_back(gd_last.move.to, up_to.p, up_to.GetColor());
+	tiles[n++] = TileI{ gd.move.to, up_to.p, up_to.GetColor() };
 
-	if (gd_last.IsCastle()) {
-		const int corner_bindex = gd_last.move.from + (gd_last.IsKSCastle() ? 3 : -4);
-		const int king_adjacent_bindex = gd_last.move.from + (gd_last.IsKSCastle() ? 1 : -1);
-		//const int rook_id = m_bindex_to_id[king_adjacent_bindex];
+	if (gd.IsCastle()) {
+		const int corner_bindex = gd.move.from + (gd.IsKSCastle() ? 3 : -4);
+		const int king_adjacent_bindex = gd.move.from + (gd.IsKSCastle() ? 1 : -1);
 
-		vret.emplace_back( corner_bindex, Piece::ROOK, up_from.GetColor());
-		vret.emplace_back(king_adjacent_bindex, Piece::EMPTY, ChessColor{});
+		tiles[n++] = TileI{ corner_bindex, Piece::ROOK, up_from.GetColor() };
+		tiles[n++] = TileI{ king_adjacent_bindex, Piece::EMPTY, ChessColor{} };
 	}
-	return vret;
+	return n;
+}
+
+/// <summary>
+/// completes event with the move data of gd (nullptr for RESET) and the check state, then notifies all observers
+/// </summary>
+void Game::publish(BoardEvent& event, const GameDelta* gd)
+{
+	if (gd) {
+		event.move = gd->move;
+		event.piece = gd->piece;
+		event.captured = gd->takes.p;
+	}
+	event.check = get_is_check();
+	for (IBoardObserver* observer : m_observers) observer->on_board_event(event);
 }
 
 GameMove Game::get_last_move() const
@@ -222,28 +374,89 @@ GameMove Game::get_last_move() const
 
 std::string Game::get_last_move_str(GameMoveStrFmt fmt) const
 {
-	if (m_gamedelta_list.empty()) return std::string();
-	if (fmt == GameMoveStrFmt::DEFAULT) fmt = m_string_fmt;
+	MoveStr move_str;
+	const int len = get_last_move_str(move_str, fmt);
+	return std::string(move_str.data(), len);
+}
 
-	return gd_to_string(m_gamedelta_list.back());
+int Game::get_last_move_str(MoveStr& out, GameMoveStrFmt fmt) const
+{
+	out[0] = '\0';
+	if (m_gamedelta_list.empty()) return 0;
+	return write_gd(out.data(), m_gamedelta_list.back(), fmt, is_last_move_mate());
 }
 
 
-std::vector<GameMove> Game::get_all_moves() const
+int Game::get_all_moves(std::span<GameMove> out) const
 {
-	std::vector<GameMove> vret;
-	vret.reserve(100);
-	for (const GameDelta& gd : m_gamedelta_list) {
-		vret.push_back(gd.move);
+	const int number_of_moves = static_cast<int>(std::min(out.size(), m_gamedelta_list.size()));
+	for (int i = 0; i < number_of_moves; i++) {
+		out[i] = m_gamedelta_list[i].move;
 	}
-	vret.shrink_to_fit();
-	return vret;
+	return number_of_moves;
 }
 
 std::vector<std::string> Game::get_all_moves_str(GameMoveStrFmt fmt) const
 {
-	// TODO
-	return std::vector<std::string>();
+	std::vector<std::string> vret;
+	vret.reserve(m_gamedelta_list.size());
+	const bool mate = is_last_move_mate();
+	MoveStr move_str;
+	for (size_t i = 0; i < m_gamedelta_list.size(); i++) {
+		const int len = write_gd(move_str.data(), m_gamedelta_list[i], fmt, mate && i + 1 == m_gamedelta_list.size());
+		vret.emplace_back(move_str.data(), len);
+	}
+	return vret;
+}
+
+int Game::get_all_moves_str(std::span<MoveStr> out, GameMoveStrFmt fmt) const
+{
+	const bool mate = is_last_move_mate();
+	const int number_of_moves = static_cast<int>(std::min(out.size(), m_gamedelta_list.size()));
+	for (int i = 0; i < number_of_moves; i++) {
+		write_gd(out[i].data(), m_gamedelta_list[i], fmt, mate && i + 1 == static_cast<int>(m_gamedelta_list.size()));
+	}
+	return number_of_moves;
+}
+
+/// <summary>
+/// Writes the move history as pgn movetext. Turn numbers continue from the start fen,
+/// a history starting with black begins with "n... ".
+/// </summary>
+/// <param name="buffer">output, '\0' terminated</param>
+/// <param name="buffer_size">size of buffer including '\0'</param>
+/// <param name="fmt">notation of the moves</param>
+/// <returns>length without '\0', 0 if buffer_size is too small</returns>
+int Game::to_movetext(char* buffer, int buffer_size, GameMoveStrFmt fmt) const
+{
+	if (buffer_size < 1) return 0;
+	const int plies = static_cast<int>(m_gamedelta_list.size());
+	const bool mate = is_last_move_mate();
+	// ply of the first move in the history counted from 1. e4
+	int ply = 2 * (m_turn_number - 1) + (m_swap_vars.active->color.IsBlack() ? 1 : 0) - plies;
+
+	int len = 0;
+	// separator, turn number, dots and move
+	char entry[1 + 5 + 4 + GAME_MOVE_STR_LEN_MAX + 1];
+	for (int i = 0; i < plies; i++, ply++) {
+		int entry_len = 0;
+		if (i > 0) entry[entry_len++] = ' ';
+		if (ply % 2 == 0 || i == 0) {
+			entry_len += write_uint(entry + entry_len, ply / 2 + 1);
+			entry[entry_len++] = '.';
+			if (ply % 2 == 1) {
+				entry[entry_len++] = '.';
+				entry[entry_len++] = '.';
+			}
+			entry[entry_len++] = ' ';
+		}
+		entry_len += write_gd(entry + entry_len, m_gamedelta_list[i], fmt, mate && i + 1 == plies);
+		if (len + entry_len >= buffer_size) return 0;
+		std::memcpy(buffer + len, entry, entry_len);
+		len += entry_len;
+	}
+	buffer[len] = '\0';
+	return len;
 }
 
 bool Game::get_is_check() const
@@ -273,19 +486,9 @@ GameMoveStrFmt Game::get_move_str_fmt() const
 /// <param name="m"></param>
 /// <param name="fmt"></param>
 /// <returns></returns>
-GameState Game::move(const std::string& m, GameMoveStrFmt fmt)
+GameState Game::move(std::string_view m, GameMoveStrFmt fmt)
 {
-	if (fmt == GameMoveStrFmt::DEFAULT) {
-		fmt = m_string_fmt;
-	}
-
-	switch (fmt)
-	{
-	case GameMoveStrFmt::DEFAULT: return GameState::INVALID_MOVE;
-	case GameMoveStrFmt::UCI: return move(uci_to_gamemove(m));
-	case GameMoveStrFmt::SAN: return move(san_to_gamemove(m));
-	case GameMoveStrFmt::LAN: return move(lan_to_gamemove(m));
-	}
+	return move(string_to_gamemove(m, fmt));
 }
 
 
@@ -307,26 +510,27 @@ GameState Game::move(const GameMove& move)
 	auto it = std::find(m_legal_moves.begin(), m_legal_moves.end(), move_int);
 	if (it == m_legal_moves.end()) return GameState::INVALID_MOVE;
 	
+	if (!m_legal_index_valid) build_legal_index();
 	GameDelta gd = legal_to_gd(move);
 	gd.white_castle = m_swap_vars.white.castles;
 	gd.black_castle = m_swap_vars.black.castles;
 	gd.half_turns = m_half_turn_number;
 	gd.p2_index = m_p2_index;
+	gd.piece = m_board.get_piece_from_bindex(gd.move.from);
+	gd.disambiguation = m_legal_disambiguation[it - m_legal_moves.begin()];
 
-	//execute move on board
-	m_board.apply_gamedelta(gd);
-	update_castles(gd);
-	update_p2_index(gd);
-
-	//end turn
-	if (m_swap_vars.active->color.IsBlack()) m_turn_number += 1;
-	m_half_turn_number += 1;
-	if (gd.IsTakes() || (m_board.get_piece_from_bindex(gd.move.to) == Piece::PAWN)) m_half_turn_number = 0;
+	// playing the next undone move keeps the rest of the line
+	if (!m_redo_list.empty()) {
+		if (m_redo_list.back().move == gd.move) m_redo_list.pop_back();
+		else discard_redo();
+	}
 
-	m_swap_vars.Swap();
+	push_legal_state();
+	apply_delta(gd);
 
 	gd.check = get_is_check();
 	m_gamedelta_list.push_back(gd);
+	push_checkpoint_if_due();
 
 	find_pinned_pieces();
 	find_legal_moves();
@@ -341,40 +545,187 @@ void Game::undo()
 {
 	if (m_gamedelta_list.empty()) return;
 
-	const GameDelta& gd_last = m_gamedelta_list.back();
 	if (m_game_has_ended) m_game_has_ended = false;
-	m_swap_vars.Swap();
-	if (m_swap_vars.active->color.IsBlack()) m_turn_number--;
-	m_half_turn_number = gd_last.half_turns;
-	undo_update_castles(gd_last.white_castle, gd_last.black_castle);
-	undo_update_p2_index(gd_last.p2_index);
-	m_board.undo_gamedelta(gd_last);
-
+	revert_delta(m_gamedelta_list.back());
+	m_redo_list.push_back(m_gamedelta_list.back());
 	m_gamedelta_list.pop_back();
 
-	find_pinned_pieces();
-	find_legal_moves();
+	if (!restore_legal_state()) {
+		find_pinned_pieces();
+		find_legal_moves();
+	}
 
 	return;
 }
 
-void Game::new_game(const std::string& fen)
+GameState Game::redo()
 {
-	m_pseudo_moves.reserve(28);
-	m_legal_moves.reserve(80);
-	m_gamedelta_list.reserve(100);
+	if (m_redo_list.empty()) return GameState::INVALID_MOVE;
 
-	if (!fen.empty()) {
-		m_fen_valid = init_fen(fen);
-		if (!m_fen_valid) return;
+	push_legal_state();
+	push_delta(m_redo_list.back());
+	m_redo_list.pop_back();
+	update_legal_moves();
+
+	if (m_game_has_ended) return GameState::GAME_HAS_ENDED;
+	return GameState::VALID_MOVE;
+}
+
+/// <summary>
+/// Jumps to ply of the current line (played and undone moves).
+/// Either walks from the current position or restores the closest checkpoint at or before ply, whichever replays fewer deltas.
+/// Deltas are replayed without move generation, legal moves are generated once for the target position.
+/// </summary>
+/// <param name="ply">0 for the start position, up to get_ply_count()</param>
+/// <returns>false if ply is out of range</returns>
+bool Game::seek(int ply)
+{
+	if (!get_init_ok() || m_checkpoints.empty()) return false;
+	if (ply < 0 || ply > get_ply_count()) return false;
+	const int current = get_ply();
+	if (ply == current) return true;
+
+	const int checkpoint = std::min(ply / GAME_CHECKPOINT_INTERVAL, static_cast<int>(m_checkpoints.size()) - 1);
+	const int checkpoint_ply = checkpoint * GAME_CHECKPOINT_INTERVAL;
+	if (std::abs(ply - current) > ply - checkpoint_ply) {
+		restore_checkpoint(m_checkpoints[checkpoint]);
+		// only move the deltas between the lists, the board already is at checkpoint_ply
+		while (get_ply() > checkpoint_ply) {
+			m_redo_list.push_back(m_gamedelta_list.back());
+			m_gamedelta_list.pop_back();
+		}
+		while (get_ply() < checkpoint_ply) {
+			m_gamedelta_list.push_back(m_redo_list.back());
+			m_redo_list.pop_back();
+		}
 	}
-	else {
-		m_fen_valid = init_fen(M_DEFAULT_FEN);
+
+	while (get_ply() > ply) {
+		m_redo_list.push_back(m_gamedelta_list.back());
+		pop_delta();
+	}
+	while (get_ply() < ply) {
+		push_delta(m_redo_list.back());
+		m_redo_list.pop_back();
 	}
 
-	find_pinned_pieces();
-	find_legal_moves();
-	update_game_has_ended(get_is_check());
+	update_legal_moves();
+	return true;
+}
+
+int Game::get_ply() const
+{
+	return static_cast<int>(m_gamedelta_list.size());
+}
+
+int Game::get_ply_count() const
+{
+	return static_cast<int>(m_gamedelta_list.size() + m_redo_list.size());
+}
+
+/// <summary>
+/// Starts a new game. Does not allocate as long as the history fits into the capacity of the previous game.
+/// Without fen the start position is copied from a cached pre-parsed game instead of parsing GAME_DEFAULT_FEN.
+/// </summary>
+/// <param name="fen">position to start from. empty for the standard start position</param>
+void Game::new_game(std::string_view fen)
+{
+	m_gamedelta_list.clear();
+	m_redo_list.clear();
+	m_checkpoints.clear();
+	m_legal_states.clear();
+	m_legal_state_moves.clear();
+	m_game_has_ended = false;
+
+	if (fen.empty()) {
+		reset_to_start();
+		if (m_observers.empty()) return;
+		BoardEvent event;
+		publish(event, nullptr);
+		return;
+	}
+
+	m_fen_result = init_fen(fen);
+	if (!m_fen_result.ok()) return;
+	init_derived_state();
+}
+
+void Game::new_game(const PositionSnapshot& snapshot)
+{
+	m_gamedelta_list.clear();
+	m_redo_list.clear();
+	m_checkpoints.clear();
+	m_legal_states.clear();
+	m_legal_state_moves.clear();
+	m_game_has_ended = false;
+
+	m_fen_result = init_snapshot(snapshot);
+	if (!m_fen_result.ok()) return;
+	init_derived_state();
+}
+
+void Game::new_game(const PackedBoard& board)
+{
+	m_gamedelta_list.clear();
+	m_redo_list.clear();
+	m_checkpoints.clear();
+	m_legal_states.clear();
+	m_legal_state_moves.clear();
+	m_game_has_ended = false;
+
+	m_fen_result = init_packed(board);
+	if (!m_fen_result.ok()) return;
+	init_derived_state();
+}
+
+PositionSnapshot Game::get_snapshot() const
+{
+	PositionSnapshot snapshot;
+	m_board.to_snapshot_board(snapshot);
+	snapshot.castles = get_castle_flags();
+	snapshot.p2_index = static_cast<int8_t>(m_p2_index);
+	snapshot.half_turns = m_half_turn_number;
+	snapshot.black_to_move = m_swap_vars.active->color.IsBlack();
+	snapshot.turn_number = m_turn_number;
+	return snapshot;
+}
+
+PackedBoard Game::get_packed() const
+{
+	PackedBoard board;
+	m_board.to_packed_board(board);
+	board.castles = get_castle_flags();
+	board.p2_index = static_cast<int8_t>(m_p2_index);
+	board.half_turns = m_half_turn_number;
+	board.black_to_move = m_swap_vars.active->color.IsBlack();
+	board.turn_number = m_turn_number;
+	board.reserved = 0;
+	return board;
+}
+
+uint8_t Game::get_castle_flags() const
+{
+	uint8_t castles = 0;
+	if (m_swap_vars.white.castles.kscastle) castles |= GAME_CASTLE_WHITE_KS;
+	if (m_swap_vars.white.castles.qscastle) castles |= GAME_CASTLE_WHITE_QS;
+	if (m_swap_vars.black.castles.kscastle) castles |= GAME_CASTLE_BLACK_KS;
+	if (m_swap_vars.black.castles.qscastle) castles |= GAME_CASTLE_BLACK_QS;
+	return castles;
+}
+
+void Game::set_accumulator(NnueAccumulator* accumulator)
+{
+	m_board.set_accumulator(accumulator);
+}
+
+void Game::set_coverage_mode(CoverageMode mode)
+{
+	m_board.set_coverage_mode(mode);
+}
+
+CoverageMode Game::get_coverage_mode() const
+{
+	return m_board.get_coverage_mode();
 }
 
 void Game::set_ending_game_state(GameEndState ges)
@@ -383,6 +734,21 @@ void Game::set_ending_game_state(GameEndState ges)
 	m_ending_gamestate = ges;
 }
 
+void Game::add_observer(IBoardObserver* observer)
+{
+	if (std::find(m_observers.begin(), m_observers.end(), observer) == m_observers.end()) m_observers.push_back(observer);
+}
+
+void Game::remove_observer(IBoardObserver* observer)
+{
+	m_observers.erase(std::remove(m_observers.begin(), m_observers.end(), observer), m_observers.end());
+}
+
+void Game::detach_all()
+{
+	m_observers.clear();
+}
+
 void Game::set_move_str_fmt(GameMoveStrFmt fmt)
 {
 	if (fmt == GameMoveStrFmt::DEFAULT) return;
@@ -396,17 +762,13 @@ uint64_t Game::perft(int depth)
 	if (depth == 0) return 1;
 	if (depth == 1) return m_legal_moves.size();
 
-	const std::vector<GameMoveInt> legal = m_legal_moves;
-	const std::array<Direction, GAME_MAX_ID> pinned = m_pinned_direction;
-
-	int number_of_moves = 0;
-	for (const GameMoveInt m : legal) {
-		perft_move(m);
+	// perft_undo restores the same list, so the moves can be read by index
+	uint64_t number_of_moves = 0;
+	const size_t legal_count = m_legal_moves.size();
+	for (size_t i = 0; i < legal_count; i++) {
+		perft_move(m_legal_moves[i]);
 		number_of_moves += perft(depth - 1);
 		perft_undo();
-		//should be able to comment those two out but cant???????
-		m_pinned_direction = pinned;
-		m_legal_moves = legal;
 	}
 	return number_of_moves;
 }
@@ -416,9 +778,6 @@ void Game::perft_divide(int depth)
 	std::vector<std::string> legal_str = get_possible_moves_str();
 	std::sort(legal_str.begin(), legal_str.end());
 
-	//const std::vector<GameMoveInt> legal = m_legal_moves;
-	const std::array<Direction, GAME_MAX_ID> pinned = m_pinned_direction;
-
 
 	uint64_t tot = 0;
 	for (const std::string& m_str : legal_str) {
@@ -430,7 +789,6 @@ void Game::perft_divide(int depth)
 		tot += n;
 		std::cout << n << "\n";
 		perft_undo();
-		m_pinned_direction = pinned;
 	}
 	std::cout << "\n";
 	std::cout << "total: " << tot << "\n";
@@ -482,14 +840,12 @@ void Game::save_board_DEBUG()
 
 bool operator==(const Game& lhs, const Game& rhs)
 {
-	if (lhs.M_DEFAULT_FEN != rhs.M_DEFAULT_FEN) return false;
 	if (lhs.m_board != rhs.m_board) return false;
 	if (lhs.m_swap_vars != rhs.m_swap_vars) return false;
 	if (lhs.m_gamedelta_list != rhs.m_gamedelta_list) return false;
 	if (lhs.m_legal_moves != rhs.m_legal_moves) return false;
-	if (lhs.m_pseudo_moves != rhs.m_pseudo_moves) return false;
-	if (lhs.m_block_check_indices != rhs.m_block_check_indices) return false;
-	if (lhs.m_pinned_direction != rhs.m_pinned_direction) return false;
+	if (lhs.m_pin_mask != rhs.m_pin_mask) return false;
+	if (lhs.m_check_mask != rhs.m_check_mask) return false;
 	if (lhs.m_p2_index != rhs.m_p2_index) return false;
 	if (lhs.m_game_has_ended != rhs.m_game_has_ended) return false;
 	if (lhs.m_turn_number != rhs.m_turn_number) return false;
@@ -498,7 +854,7 @@ bool operator==(const Game& lhs, const Game& rhs)
 }
 
 
-bool Game::is_en_passant(const GameMove& m)
+bool Game::is_en_passant(const GameMove& m) const
 {
 	if (m_p2_index != -1 && m_board.get_piece_from_bindex(m.from) == Piece::PAWN && m_board.get_piece_from_bindex(m.to) == Piece::EMPTY) {
 		const int d_from = std::abs(m_p2_index - m.from);
@@ -508,7 +864,7 @@ bool Game::is_en_passant(const GameMove& m)
 	return false;
 }
 
-bool Game::is_en_passant(const GameMoveInt& m)
+bool Game::is_en_passant(const GameMoveInt& m) const
 {
 	const int from_bindex = m.get_from();
 	const int to_bindex = m.get_to();
@@ -520,86 +876,107 @@ bool Game::is_en_passant(const GameMoveInt& m)
 	return false;
 }
 
+// true if the square bindex is set in the bitboard mask
+static bool in_mask(uint64_t mask, int bindex)
+{
+	return (mask >> bindex) & 1;
+}
+
 /// <summary>
-/// initializes the game from a fen string. returns true if initialization was successful and false if not 
+/// returns the section of a fen string starting at begin and ending before the next space
+/// </summary>
+static std::string_view fen_section(std::string_view fen, int begin)
+{
+	int end = begin;
+	const int fen_size = static_cast<int>(fen.size());
+	while (end < fen_size && fen[end] != ' ') end++;
+	return fen.substr(begin, end - begin);
+}
+
+/// <summary>
+/// parses a non empty decimal number of at most max_value
+/// </summary>
+static bool fen_parse_uint(std::string_view section, unsigned int max_value, unsigned int& value)
+{
+	if (section.empty()) return false;
+	value = 0;
+	for (const char c : section) {
+		if (c < '0' || c > '9') return false;
+		value = value * 10 + unsigned(c - '0');
+		if (value > max_value) return false;
+	}
+	return true;
+}
+
+/// <summary>
+/// initializes the game from a fen string in a single pass without allocating
 /// (note that the fen string has to match the board dimensions).
 ///
 /// </summary>
-/// <param name="fen_string">
-/// fen string as defined in the standard:
-/// 
+/// <param name="fen">
+/// fen string as defined in the standard: board, active color, castles, en passant, half turns, turn number.
+/// sections are separated by a single space.
 /// </param>
 /// <returns>
-/// bool 
+/// FenResult with the error and the offset of the offending char
 /// </returns>
-bool Game::init_fen(const std::string& fen_string)
+FenResult Game::init_fen(std::string_view fen)
 {
-	int number_of_sections = std::count(fen_string.begin(), fen_string.end(), ' ') + 1;
-	if (number_of_sections != 6) return false;
+	const int fen_size = static_cast<int>(fen.size());
 
 	//validate board
-	size_t section_off = 0;
-	const std::string board_section = fen_string.substr(section_off, fen_string.find(' ', section_off) - section_off);
-	bool board_valid = m_board.new_board(board_section);
-	if (!board_valid) return false;
+	const FenResult board_result = m_board.new_board(fen);
+	if (!board_result.ok()) return board_result;
+	int offset = board_result.offset + 1;
+	if (offset >= fen_size) return { FenError::MISSING_SECTION, fen_size };
 
 	//validate active color
-	section_off += board_section.size() + 1;
-	const std::string active_color_section = fen_string.substr(section_off, fen_string.find(' ', section_off) - section_off);
-	if (active_color_section.size() != 1) return false;
-	if (active_color_section[0] == 'w') {
+	const std::string_view active_color_section = fen_section(fen, offset);
+	if (active_color_section == "w") {
 		m_swap_vars.active = &m_swap_vars.white;
 		m_swap_vars.passive = &m_swap_vars.black;
 	}
-	else if (active_color_section[0] == 'b') {
+	else if (active_color_section == "b") {
 		m_swap_vars.active = &m_swap_vars.black;
 		m_swap_vars.passive = &m_swap_vars.white;
 	}
-	else return false;
+	else return { FenError::ACTIVE_COLOR, offset };
+	offset += static_cast<int>(active_color_section.size()) + 1;
+	if (offset >= fen_size) return { FenError::MISSING_SECTION, fen_size };
 
 	//validate castles
-	section_off += active_color_section.size() + 1;
-	const std::string castles_section = fen_string.substr(section_off, fen_string.find(' ', section_off) - section_off);
-	bool castle_valid = init_fen_castles(castles_section);
-	if (!castle_valid) return false;
+	const std::string_view castles_section = fen_section(fen, offset);
+	if (!init_fen_castles(castles_section)) return { FenError::CASTLES, offset };
+	offset += static_cast<int>(castles_section.size()) + 1;
+	if (offset >= fen_size) return { FenError::MISSING_SECTION, fen_size };
 
 	// validate p2 index
-	section_off += castles_section.size() + 1;
-	const std::string en_passant_section = fen_string.substr(section_off, fen_string.find(' ', section_off) - section_off);
-	bool p2_valid = init_fen_p2_index(en_passant_section);
-	if (!p2_valid) return false;
+	const std::string_view en_passant_section = fen_section(fen, offset);
+	if (!init_fen_p2_index(en_passant_section)) return { FenError::EN_PASSANT, offset };
+	offset += static_cast<int>(en_passant_section.size()) + 1;
+	if (offset >= fen_size) return { FenError::MISSING_SECTION, fen_size };
 
 	// validate half turn
-	section_off += en_passant_section.size() + 1;
-	const std::string half_turns_section = fen_string.substr(section_off, fen_string.find(' ', section_off) - section_off);
-	if (half_turns_section.empty()) return false;
-	m_half_turn_number = 0;
-	for (const char c : half_turns_section) {
-		if (isdigit(c)) {
-			m_half_turn_number *= 10;
-			m_half_turn_number += int(c - '0');
-		}
-		else return false;
-	}
+	const std::string_view half_turns_section = fen_section(fen, offset);
+	unsigned int half_turns = 0;
+	if (!fen_parse_uint(half_turns_section, UINT8_MAX, half_turns)) return { FenError::HALF_TURNS, offset };
+	m_half_turn_number = static_cast<uint8_t>(half_turns);
+	offset += static_cast<int>(half_turns_section.size()) + 1;
+	if (offset >= fen_size) return { FenError::MISSING_SECTION, fen_size };
 
 	//validate turn number
-	section_off += half_turns_section.size() + 1;
-	const std::string number_of_turns_section = fen_string.substr(section_off);
-	if (number_of_turns_section.empty()) return false;
-	m_turn_number = 0;
-	for (const char c : number_of_turns_section) {
-		if (isdigit(c)) {
-			m_turn_number *= 10;
-			m_turn_number += int(c - '0');
-		}
-		else return false;
-	}
+	const std::string_view number_of_turns_section = fen_section(fen, offset);
+	unsigned int turn_number = 0;
+	if (!fen_parse_uint(number_of_turns_section, UINT16_MAX, turn_number)) return { FenError::TURN_NUMBER, offset };
+	m_turn_number = static_cast<uint16_t>(turn_number);
+	offset += static_cast<int>(number_of_turns_section.size());
+	if (offset != fen_size) return { FenError::TRAILING_CHARACTERS, offset };
 
 	//additional constraints
 	//kings are not adjacent
 	const Position white_king_pos = bindex_to_position(m_board.get_bindex(m_swap_vars.white.king_id));
 	const Position black_king_pos = bindex_to_position(m_board.get_bindex(m_swap_vars.black.king_id));
-	if (std::abs(white_king_pos.x - black_king_pos.x) <= 1 && std::abs(white_king_pos.y - black_king_pos.y) <= 1) return false;
+	if (std::abs(white_king_pos.x - black_king_pos.x) <= 1 && std::abs(white_king_pos.y - black_king_pos.y) <= 1) return { FenError::KINGS_ADJACENT, 0 };
 
 
 	//pawns are not on last rank
@@ -624,10 +1001,10 @@ bool Game::init_fen(const std::string& fen_string)
 		}
 		else break;
 	}*/
-	return true;
+	return { FenError::NONE, offset };
 }
 
-bool Game::init_fen_castles(const std::string& fen_castles_section)
+bool Game::init_fen_castles(std::string_view fen_castles_section)
 {
 	m_swap_vars.white.castles.kscastle = false;
 	m_swap_vars.white.castles.qscastle = false;
@@ -686,7 +1063,71 @@ bool Game::init_fen_castles(const std::string& fen_castles_section)
 	return true;
 }
 
-bool Game::init_fen_p2_index(const std::string& fen_ep_section)
+FenResult Game::init_snapshot(const PositionSnapshot& snapshot)
+{
+	const FenResult board_result = m_board.new_board(snapshot);
+	if (!board_result.ok()) return board_result;
+	if (!init_position_state(snapshot.castles, snapshot.p2_index, snapshot.half_turns, snapshot.turn_number, snapshot.black_to_move)) return { FenError::EN_PASSANT, 0 };
+	return board_result;
+}
+
+FenResult Game::init_packed(const PackedBoard& board)
+{
+	const FenResult board_result = m_board.new_board(board);
+	if (!board_result.ok()) return board_result;
+	if (!init_position_state(board.castles, board.p2_index, board.half_turns, board.turn_number, board.black_to_move)) return { FenError::EN_PASSANT, 0 };
+	return board_result;
+}
+
+/// <summary>
+/// active color, castle rights, en passant pawn and clocks of a position loaded without a fen.
+/// returns false if p2_index is not -1 and not a pawn of the passive color that just advanced two squares
+/// </summary>
+bool Game::init_position_state(uint8_t castles, int8_t p2_index, uint8_t half_turns, uint16_t turn_number, bool black_to_move)
+{
+	if (p2_index != -1) {
+		// white captures en passant on rank 6 a black pawn of rank 5, black on rank 3 a white pawn of rank 4
+		const int rank_first = black_to_move ? 3 * GAME_WIDTH : 4 * GAME_WIDTH;
+		if (p2_index < rank_first || p2_index >= rank_first + GAME_WIDTH) return false;
+		const UniquePiece up = m_board.get_up(p2_index);
+		if (up.p != Piece::PAWN || up.IsWhite() != black_to_move) return false;
+		const int skipped_index = p2_index + (black_to_move ? -GAME_WIDTH : GAME_WIDTH);
+		if (m_board.get_piece_from_bindex(skipped_index) != Piece::EMPTY) return false;
+	}
+
+	if (black_to_move) {
+		m_swap_vars.active = &m_swap_vars.black;
+		m_swap_vars.passive = &m_swap_vars.white;
+	}
+	else {
+		m_swap_vars.active = &m_swap_vars.white;
+		m_swap_vars.passive = &m_swap_vars.black;
+	}
+	m_swap_vars.white.castles = { (castles & GAME_CASTLE_WHITE_KS) != 0, (castles & GAME_CASTLE_WHITE_QS) != 0 };
+	m_swap_vars.black.castles = { (castles & GAME_CASTLE_BLACK_KS) != 0, (castles & GAME_CASTLE_BLACK_QS) != 0 };
+	m_p2_index = p2_index;
+	m_half_turn_number = half_turns;
+	m_turn_number = turn_number;
+	return true;
+}
+
+/// <summary>
+/// legal moves, game ending state, start fen and first checkpoint of a freshly loaded position
+/// </summary>
+void Game::init_derived_state()
+{
+	find_pinned_pieces();
+	find_legal_moves();
+	update_game_has_ended(get_is_check());
+	to_fen(m_start_fen.data(), GAME_FEN_LEN_MAX);
+	push_checkpoint_if_due();
+
+	if (m_observers.empty()) return;
+	BoardEvent event;
+	publish(event, nullptr);
+}
+
+bool Game::init_fen_p2_index(std::string_view fen_ep_section)
 {
 	if (fen_ep_section.size() == 1 && fen_ep_section[0] == '-') {
 		m_p2_index = -1;
@@ -699,16 +1140,24 @@ bool Game::init_fen_p2_index(const std::string& fen_ep_section)
 		const char rank = fen_ep_section[1];
 		if (rank != '3' && rank != '6') return false;
 		const int y = rank - '1';
-		const int forward = y == 3 ? GAME_WIDTH : -GAME_WIDTH;
+		// the p2 pawn stands one rank behind the ep square as seen from the capturing side
+		const int forward = y == 2 ? GAME_WIDTH : -GAME_WIDTH;
 		m_p2_index = GAME_WIDTH * y + x + forward;
 		return true;
 	}
 	return false;
 }
 
+/// <summary>
+/// generates the legal moves of the active player in one pass. Moves of pieces other than the king have to land
+/// on m_check_mask (the checking piece or a square between it and the king, every square without check)
+/// and on the pin ray of the piece. The king only moves to uncovered squares.
+/// </summary>
 void Game::find_legal_moves()
 {
+	GAME_STAT_SCOPE(GameStatId::FIND_LEGAL_MOVES);
 	m_legal_moves.clear();
+	m_legal_index_valid = false;
 	const int active_king_id = m_swap_vars.active->king_id;
 	const int active_king_index = m_board.get_bindex(active_king_id);
 	const int coverage_cnt = m_board.get_cover_count_color(active_king_index, m_swap_vars.passive->color_offset);
@@ -716,38 +1165,29 @@ void Game::find_legal_moves()
 	const bool is_check = coverage_cnt == 1;
 
 	if (is_double_check) {
-		piece_moves(active_king_id);
+		m_check_mask = 0;
+		king_moves(active_king_index);
 		return;
 	}
 	if (is_check) {
 		const int check_id = m_board.get_first_cover_id_color(active_king_index, m_swap_vars.passive->color_offset);
-		const int check_index = m_board.get_bindex(check_id);
-		find_block_indices(active_king_index, check_index);
-		find_pseudo_moves();
-		append_en_passant_if_resolves_check(active_king_index, check_id);
-		filter_pinned_moves();
-		filter_block_moves();
-		append_and_clear();
-		m_block_check_indices.clear();
-		return;
+		find_check_mask(active_king_index, m_board.get_bindex(check_id));
 	}
-	find_pseudo_moves();
-	filter_pinned_moves();
-	append_and_clear();
-	return;
-}
+	else m_check_mask = ~uint64_t(0);
 
-void Game::find_pseudo_moves()
-{
-	const int active_king_id = m_swap_vars.active->king_id;
 	const int id_end = active_king_id + GAME_MAX_COLOR_ID;
 	for (int id = active_king_id; id < id_end; id++) {
 		if (m_board.get_piece_from_id(id) != Piece::EMPTY) piece_moves(id);
 	}
+	return;
 }
 
+/// <summary>
+/// sets m_pin_mask of every piece pinned to the active king to the squares from the king to the pinning piece
+/// </summary>
 void Game::find_pinned_pieces()
 {
+	GAME_STAT_SCOPE(GameStatId::FIND_PINNED_PIECES);
 	clear_pinned();
 
 	int active_king_bindex = m_board.get_bindex(m_swap_vars.active->king_id);
@@ -769,9 +1209,11 @@ void Game::find_pinned_direction(const Direction dir, const int king_bindex, con
 	int d = get_bindex_delta(dir);
 	int to_index = king_bindex;
 	int first_id = -1;
+	uint64_t ray = 0;
 
 	for (int8_t n = 1; n <= nsteps; n++) {
 		to_index += d;
+		ray |= uint64_t(1) << to_index;
 		UniquePiece up = m_board.get_up(to_index);
 		if (up.IsEmpty()) continue;
 		else if (up.IsAlly(m_swap_vars.active->color)) {
@@ -781,7 +1223,7 @@ void Game::find_pinned_direction(const Direction dir, const int king_bindex, con
 		else {
 			if (up.p != dirp && up.p != Piece::QUEEN) return;
 			else if (first_id != -1) {
-				m_pinned_direction[first_id] = dir;
+				m_pin_mask[first_id] = ray;
 				return;
 			}
 			else return;
@@ -792,20 +1234,22 @@ void Game::find_pinned_direction(const Direction dir, const int king_bindex, con
 
 void Game::clear_pinned()
 {
-	m_pinned_direction.fill(Direction::NONE);
+	m_pin_mask.fill(~uint64_t(0));
 	return;
 }
 
 void Game::piece_moves(int id)
 {
 	const int index = m_board.get_bindex(id);
+	// squares that keep the own king safe
+	const uint64_t target = m_check_mask & m_pin_mask[id];
 	switch (m_board.get_piece_from_id(id)) {
 	case (Piece::KING):   return king_moves(index);
-	case (Piece::QUEEN):  return queen_moves(index);
-	case (Piece::BISHOP): return bishop_moves(index);
-	case(Piece::KNIGHT):  return knight_moves(index);
-	case(Piece::ROOK):    return rook_moves(index);
-	case(Piece::PAWN):    return pawn_moves(index);
+	case (Piece::QUEEN):  return queen_moves(index, target);
+	case (Piece::BISHOP): return bishop_moves(index, target);
+	case(Piece::KNIGHT):  return knight_moves(index, target);
+	case(Piece::ROOK):    return rook_moves(index, target);
+	case(Piece::PAWN):    return pawn_moves(index, target);
 	default:              return;
 	}
 }
@@ -827,34 +1271,36 @@ void Game::king_moves(int from_index)
 	return;
 }
 
-void Game::queen_moves(int bindex)
+void Game::queen_moves(int bindex, uint64_t target)
 {
-	rook_moves(bindex);
-	bishop_moves(bindex);
+	rook_moves(bindex, target);
+	bishop_moves(bindex, target);
 }
 
-void Game::bishop_moves(int from_index)
+void Game::bishop_moves(int from_index, uint64_t target)
 {
 	for (Direction dir = Direction::NE; dir <= Direction::NW; ++dir) {
-		move_and_append(dir, from_index);
+		move_and_append(dir, from_index, target);
 	}
 }
 
-void Game::knight_moves(int from_index)
+void Game::knight_moves(int from_index, uint64_t target)
 {
+	// a pinned knight never stays on its pin ray
+	if (m_pin_mask[m_board.get_id(from_index)] != ~uint64_t(0)) return;
 	for (Direction dir = Direction::NNE; dir <= Direction::NNW; ++dir) {
-		move_and_append(dir, from_index);
+		move_and_append(dir, from_index, target);
 	}
 }
 
-void Game::rook_moves(int from_index)
+void Game::rook_moves(int from_index, uint64_t target)
 {
 	for (Direction dir = Direction::N; dir <= Direction::W; ++dir) {
-		move_and_append(dir, from_index);
+		move_and_append(dir, from_index, target);
 	}
 }
 
-void Game::pawn_moves(int from_index)
+void Game::pawn_moves(int from_index, uint64_t target)
 {
 	const int forward = m_swap_vars.active->pawn_forward;
 	const int starting_y = m_swap_vars.active->pawn_start_y;
@@ -867,18 +1313,18 @@ void Game::pawn_moves(int from_index)
 		//single_forward
 		int to_index = from_index + forward;
 		const UniquePiece up = m_board.get_up(to_index);
-		if (up.IsEmpty()) {
+		if (up.IsEmpty() && in_mask(target, to_index)) {
 			for (const Piece pp : promo_piece) {
-				m_pseudo_moves.emplace_back(from_index, to_index, pp);
+				m_legal_moves.emplace_back(from_index, to_index, pp);
 			}
 		}
 		//takes_left
 		if (pos.x > 0) {
 			int to_index = from_index + forward - 1;
 			const UniquePiece up = m_board.get_up(to_index);
-			if (up.IsEnemy(m_swap_vars.active->color)) {
+			if (up.IsEnemy(m_swap_vars.active->color) && in_mask(target, to_index)) {
 				for (const Piece pp : promo_piece) {
-					m_pseudo_moves.emplace_back(from_index, to_index, pp);
+					m_legal_moves.emplace_back(from_index, to_index, pp);
 				}
 			}
 		}
@@ -887,9 +1333,9 @@ void Game::pawn_moves(int from_index)
 		if (pos.x < GAME_WIDTH - 1) {
 			int to_index = from_index + forward + 1;
 			UniquePiece up = m_board.get_up(to_index);
-			if (up.IsEnemy(m_swap_vars.active->color)) {
+			if (up.IsEnemy(m_swap_vars.active->color) && in_mask(target, to_index)) {
 				for (const Piece pp : promo_piece) {
-					m_pseudo_moves.emplace_back(from_index, to_index, pp);
+					m_legal_moves.emplace_back(from_index, to_index, pp);
 				}
 			}
 		}
@@ -899,14 +1345,14 @@ void Game::pawn_moves(int from_index)
 	//single_forward
 	int to_index = from_index + forward;
 	UniquePiece up = m_board.get_up(to_index);
-	if (up.IsEmpty()) m_pseudo_moves.emplace_back(from_index, to_index);
+	if (up.IsEmpty() && in_mask(target, to_index)) m_legal_moves.emplace_back(from_index, to_index);
 	
 	//takes_left
 	if (pos.x > 0) {
 		int to_index = from_index + forward - 1;
 		UniquePiece up = m_board.get_up(to_index);
-		if (up.IsEnemy(m_swap_vars.active->color)) {
-			m_pseudo_moves.emplace_back(from_index, to_index);
+		if (up.IsEnemy(m_swap_vars.active->color) && in_mask(target, to_index)) {
+			m_legal_moves.emplace_back(from_index, to_index);
 		}
 	}
 	
@@ -914,8 +1360,8 @@ void Game::pawn_moves(int from_index)
 	if (pos.x < 7) {
 		int to_index = from_index + forward + 1;
 		UniquePiece up = m_board.get_up(to_index);
-		if (up.IsEnemy(m_swap_vars.active->color)) {
-			m_pseudo_moves.emplace_back(from_index, to_index);
+		if (up.IsEnemy(m_swap_vars.active->color) && in_mask(target, to_index)) {
+			m_legal_moves.emplace_back(from_index, to_index);
 		}
 	}
 	
@@ -924,7 +1370,7 @@ void Game::pawn_moves(int from_index)
 		int to_index = from_index + 2 * forward;
 		UniquePiece upskip = m_board.get_up(from_index + forward);
 		UniquePiece up = m_board.get_up(to_index);
-		if (upskip.IsEmpty() && up.IsEmpty()) m_pseudo_moves.emplace_back(from_index, to_index); //m_pseudo_moves.push_back(GAME_MOVE_TYPE(from_index, to_index));
+		if (upskip.IsEmpty() && up.IsEmpty() && in_mask(target, to_index)) m_legal_moves.emplace_back(from_index, to_index);
 	}
 
 	//en_passant
@@ -934,16 +1380,20 @@ void Game::pawn_moves(int from_index)
 		int dx = p2pos.x - pos.x;
 		int dy = p2pos.y - pos.y;
 		if (dy==0 && (dx == 1 || dx == -1)) {
+			const int to_index = from_index + forward + dx;
+			// resolves a check by blocking it or by taking the checking pawn
+			const bool resolves_check = in_mask(m_check_mask, to_index) || in_mask(m_check_mask, m_p2_index);
+			const bool keeps_pin = in_mask(m_pin_mask[m_board.get_id(from_index)], to_index);
 			// weired special case
-			if (!en_passant_is_self_check(pos.x,pos.y,p2pos.x)) {
-				m_pseudo_moves.emplace_back(from_index, from_index + forward + dx);
+			if (resolves_check && keeps_pin && !en_passant_is_self_check(pos.x,pos.y,p2pos.x)) {
+				m_legal_moves.emplace_back(from_index, to_index);
 			}  
 		}
 	}
 	return;
 }
 
-void Game::move_and_append(const Direction dir, const int from_index)
+void Game::move_and_append(const Direction dir, const int from_index, const uint64_t target)
 {
 	int8_t nsteps = GetOOBSteps(from_index, dir);
 	int d = get_bindex_delta(dir);
@@ -951,9 +1401,11 @@ void Game::move_and_append(const Direction dir, const int from_index)
 	for (int8_t n = 1; n <= nsteps; n++) {
 		to_index += d;
 		const UniquePiece up = m_board.get_up(to_index);
-		if (up.IsEmpty()) m_pseudo_moves.emplace_back(from_index, to_index);
+		if (up.IsEmpty()) {
+			if (in_mask(target, to_index)) m_legal_moves.emplace_back(from_index, to_index);
+		}
 		else if (up.IsEnemy(m_swap_vars.active->color)) {
-			m_pseudo_moves.emplace_back(from_index, to_index);
+			if (in_mask(target, to_index)) m_legal_moves.emplace_back(from_index, to_index);
 			return;
 		}
 		else return;
@@ -1027,42 +1479,12 @@ bool Game::en_passant_is_self_check(int from_x, int from_y, int ep_x)
 	return false;
 }
 
-void Game::filter_pinned_moves()
-{
-	for (GameMoveInt& m : m_pseudo_moves) {
-		if (!m.is_null()) {
-			const int from_bindex = m.get_from();
-			const int from_id = m_board.get_id(from_bindex);
-			Direction pdir = m_pinned_direction[from_id];
-			if (pdir != Direction::NONE) {
-				Direction mdir = get_hvd(from_bindex, m.get_to());
-				if (!(pdir==mdir || pdir==get_opposite_direction(mdir))) m.set_null();
-			}
-		}
-	}
-	return;
-}
-
-void Game::filter_block_moves()
-{
-	for (GameMoveInt& m : m_pseudo_moves) {
-		if (!m.is_null()) {
-			bool found = false;
-			for (const int block_index : m_block_check_indices) {
-				if (m.get_to() == block_index) {
-					found = true;
-					break;
-				}
-			}
-			if (!found) m.set_null();
-		}
-	}
-	return;
-}
-
-void Game::find_block_indices(int king_index, int check_index)
+/// <summary>
+/// m_check_mask of a single check: the square of the checking piece and, for a slider, the squares between it and the king
+/// </summary>
+void Game::find_check_mask(int king_index, int check_index)
 {
-	m_block_check_indices.push_back(check_index);
+	m_check_mask = uint64_t(1) << check_index;
 	Direction cdir = get_hvd(king_index, check_index);
 	if (cdir==Direction::NONE) return;
 
@@ -1073,37 +1495,43 @@ void Game::find_block_indices(int king_index, int check_index)
 		to_index += d;
 		const UniquePiece up = m_board.get_up(to_index);
 		if (up.IsEmpty()) {
-			m_block_check_indices.push_back(to_index);
+			m_check_mask |= uint64_t(1) << to_index;
 		}
 		else return;
 	}
 }
 
-void Game::append_and_clear()
+void Game::reset_to_start()
 {
-	for (const GameMoveInt& m : m_pseudo_moves) {
-		if (!m.is_null()) m_legal_moves.push_back(m);
-	}
-	m_pseudo_moves.clear();
-	return;
+	const Game& start = start_position();
+	const CoverageMode coverage_mode = m_board.get_coverage_mode();
+	m_board = start.m_board;
+	m_board.set_coverage_mode(coverage_mode);
+	m_swap_vars.white.castles = start.m_swap_vars.white.castles;
+	m_swap_vars.black.castles = start.m_swap_vars.black.castles;
+	m_swap_vars.active = &m_swap_vars.white;
+	m_swap_vars.passive = &m_swap_vars.black;
+	m_legal_moves.assign(start.m_legal_moves.begin(), start.m_legal_moves.end());
+	m_legal_index_valid = false;
+	m_pin_mask = start.m_pin_mask;
+	m_check_mask = start.m_check_mask;
+	m_ending_gamestate = start.m_ending_gamestate;
+	m_p2_index = start.m_p2_index;
+	m_fen_result = start.m_fen_result;
+	m_start_fen = start.m_start_fen;
+	m_checkpoints.assign(start.m_checkpoints.begin(), start.m_checkpoints.end());
+	m_game_has_ended = start.m_game_has_ended;
+	m_turn_number = start.m_turn_number;
+	m_half_turn_number = start.m_half_turn_number;
 }
 
 /// <summary>
-/// called when allied king is in check directly after pseudo-move generation
-/// Appends en-passant moves to legal if they resolve the check.
-/// Note that if the pevious pawn move led to a discovered check this function should not append anything.
+/// start position parsed once per process (thread safe static init). Only read afterwards.
 /// </summary>
-/// <param name="active_king_index"></param>
-void Game::append_en_passant_if_resolves_check(int active_king_index, int check_id)
+const Game& Game::start_position()
 {
-	//last move was p2
-	if (m_p2_index == -1) return;
-	// check is given by p2
-	if (check_id != m_board.get_id(m_p2_index)) return;
-	// append eps
-	for (const GameMoveInt& m : m_pseudo_moves) {
-		if (is_en_passant(m)) m_legal_moves.push_back(m);
-	}
+	static const Game start{};
+	return start;
 }
 
 bool Game::move_is_legal(const GameMove& m) const
@@ -1115,7 +1543,7 @@ bool Game::move_is_legal(const GameMove& m) const
 	return false;
 }
 
-GameDelta Game::legal_to_gd(const GameMove& move)
+GameDelta Game::legal_to_gd(const GameMove& move) const
 {
 	GameDelta gd(move);
 
@@ -1141,13 +1569,28 @@ GameDelta Game::legal_to_gd(const GameMove& move)
 	return gd;
 }
 
-GameMove Game::string_to_gamemove(const std::string& s) const
+GameMove Game::string_to_gamemove(std::string_view s) const
 {
 	//TODO
 	return uci_to_gamemove(s);
 }
 
-GameMove Game::uci_to_gamemove(const std::string& uci) const 
+GameMove Game::string_to_gamemove(std::string_view s, GameMoveStrFmt fmt) const
+{
+	if (fmt == GameMoveStrFmt::DEFAULT) {
+		fmt = m_string_fmt;
+	}
+
+	switch (fmt)
+	{
+	case GameMoveStrFmt::UCI: return uci_to_gamemove(s);
+	case GameMoveStrFmt::SAN: return san_to_gamemove(s);
+	case GameMoveStrFmt::LAN: return lan_to_gamemove(s);
+	default: return GameMove{};
+	}
+}
+
+GameMove Game::uci_to_gamemove(std::string_view uci) const 
 {
 	GameMove m_ret{};
 	const int uci_string_size = uci.size();
@@ -1171,23 +1614,134 @@ GameMove Game::uci_to_gamemove(const std::string& uci) const
 	return m_ret;
 }
 
-GameMove Game::san_to_gamemove(const std::string& san) const
+/// <summary>
+/// Decodes standard algebraic notation against the legal moves of the active player.
+/// Accepts O-O/0-0 castles, optional piece letter, file/rank/square disambiguation,
+/// 'x' or '-' separators, promotion with or without '=' and trailing +, #, ! and ? glyphs.
+/// Candidates are looked up by destination square, so nothing is generated or allocated.
+/// </summary>
+/// <param name="san">move in SAN</param>
+/// <returns>legal move or an empty GameMove if san is invalid or ambiguous</returns>
+GameMove Game::san_to_gamemove(std::string_view san) const
+{
+	size_t size = san.size();
+	while (size > 0) {
+		const char c = san[size - 1];
+		if (c != '+' && c != '#' && c != '!' && c != '?') break;
+		size--;
+	}
+	san = san.substr(0, size);
+	if (size < 2) return GameMove();
+
+	if (san[0] == 'O' || san[0] == '0') return castles_to_gamemove(san);
+
+	int index = 0;
+	Piece piece = Piece::PAWN;
+	const char first = san[0];
+	if (first == 'K' || first == 'Q' || first == 'R' || first == 'B' || first == 'N' || first == 'P') {
+		piece = char_to_piece(first);
+		index = 1;
+	}
+
+	Piece promotion = Piece::EMPTY;
+	const char last = san[size - 1];
+	if (piece == Piece::PAWN && (last == 'Q' || last == 'R' || last == 'B' || last == 'N' ||
+		last == 'q' || last == 'r' || last == 'n')) {
+		promotion = char_to_piece(last);
+		size--;
+		if (size > 0 && san[size - 1] == '=') size--;
+	}
+	if (size < static_cast<size_t>(index) + 2) return GameMove();
+
+	const Position to{ san[size - 2] - 'a', san[size - 1] - '1' };
+	if (to.x < 0 || to.x >= GAME_WIDTH || to.y < 0 || to.y >= GAME_HEIGHT) return GameMove();
+	const int to_bindex = position_to_bindex(to);
+
+	int from_file = -1;
+	int from_rank = -1;
+	for (size_t i = index; i < size - 2; i++) {
+		const char c = san[i];
+		if (c >= 'a' && c < 'a' + GAME_WIDTH) from_file = c - 'a';
+		else if (c >= '1' && c < '1' + GAME_HEIGHT) from_rank = c - '1';
+		else if (c != 'x' && c != '-' && c != ':') return GameMove();
+	}
+
+	if (!m_legal_index_valid) build_legal_index();
+	GameMove found{};
+	int found_count = 0;
+	for (int i = m_legal_to_begin[to_bindex]; i < m_legal_to_begin[to_bindex + 1]; i++) {
+		const GameMoveInt& m = m_legal_moves[m_legal_by_to[i]];
+		const int from_bindex = m.get_from();
+		if (m_board.get_piece_from_bindex(from_bindex) != piece) continue;
+		if (m.get_promotion() != promotion) continue;
+		if (from_file >= 0 && from_bindex % GAME_WIDTH != from_file) continue;
+		if (from_rank >= 0 && from_bindex / GAME_WIDTH != from_rank) continue;
+		found = gmi_to_gm(m);
+		found_count++;
+	}
+	return found_count == 1 ? found : GameMove();
+}
+
+/// <summary>
+/// Counting sort of the legal move indices by destination square.
+/// Moves of the same piece type to the same square get their SAN disambiguation here,
+/// so it is computed once per legal move list instead of once per written move.
+/// </summary>
+void Game::build_legal_index() const
+{
+	m_legal_to_begin.fill(0);
+	for (const GameMoveInt& m : m_legal_moves) m_legal_to_begin[m.get_to() + 1]++;
+	for (int i = 0; i < GAME_BOARD_SIZE; i++) m_legal_to_begin[i + 1] += m_legal_to_begin[i];
+
+	std::array<uint16_t, GAME_BOARD_SIZE> next;
+	std::copy(m_legal_to_begin.begin(), m_legal_to_begin.end() - 1, next.begin());
+	for (int i = 0; i < static_cast<int>(m_legal_moves.size()); i++) {
+		m_legal_by_to[next[m_legal_moves[i].get_to()]++] = static_cast<uint8_t>(i);
+	}
+
+	for (int to_bindex = 0; to_bindex < GAME_BOARD_SIZE; to_bindex++) {
+		const int begin = m_legal_to_begin[to_bindex];
+		const int end = m_legal_to_begin[to_bindex + 1];
+		for (int i = begin; i < end; i++) {
+			const int from_bindex = m_legal_moves[m_legal_by_to[i]].get_from();
+			const Piece piece = m_board.get_piece_from_bindex(from_bindex);
+			bool is_ambiguous = false, same_file = false, same_rank = false;
+			// pawns are identified by the file of captures already
+			if (piece != Piece::PAWN) {
+				for (int j = begin; j < end; j++) {
+					const int other_bindex = m_legal_moves[m_legal_by_to[j]].get_from();
+					if (other_bindex == from_bindex || m_board.get_piece_from_bindex(other_bindex) != piece) continue;
+					is_ambiguous = true;
+					if (other_bindex % GAME_WIDTH == from_bindex % GAME_WIDTH) same_file = true;
+					if (other_bindex / GAME_WIDTH == from_bindex / GAME_WIDTH) same_rank = true;
+				}
+			}
+			uint8_t disambiguation = 0;
+			if (is_ambiguous) {
+				if (!same_file) disambiguation = GAME_SAN_FILE;
+				else if (!same_rank) disambiguation = GAME_SAN_RANK;
+				else disambiguation = GAME_SAN_FILE | GAME_SAN_RANK;
+			}
+			m_legal_disambiguation[m_legal_by_to[i]] = disambiguation;
+		}
+	}
+	m_legal_index_valid = true;
+}
+
+GameMove Game::castles_to_gamemove(std::string_view castles) const
 {
-	// TODO
-	// Do ksc,qsc separate
-	// identify move piece
-	// lfind first digit -> to pos
-	// if move piece is king lookup from pos -> finished
-	// check = right of first digit for promo
-	// generate all possible moves from to pos for move piece.
-	// lookup all indicies -> if only one -> finished
-	// not one -> find all contenders and from pos hint
-	// filter -> if only one 
-	return GameMove();
+	const bool is_ksc = castles == "O-O" || castles == "0-0";
+	const bool is_qsc = castles == "O-O-O" || castles == "0-0-0";
+	if (!is_ksc && !is_qsc) return GameMove();
+	const int king_bindex = m_board.get_bindex(m_swap_vars.active->king_id);
+	return GameMove(king_bindex, king_bindex + (is_ksc ? 2 : -2));
 }
 
-GameMove Game::lan_to_gamemove(const std::string& lan) const
+GameMove Game::lan_to_gamemove(std::string_view lan) const
 {
+	while (!lan.empty() && (lan.back() == '+' || lan.back() == '#')) lan.remove_suffix(1);
+	if (!lan.empty() && (lan[0] == 'O' || lan[0] == '0')) return castles_to_gamemove(lan);
+
 	GameMove m_ret{};
 	const int lan_size = lan.size();
 	//not sure about 10 as max size (pawn takes into promo check should be longest)
@@ -1219,161 +1773,317 @@ GameMove Game::lan_to_gamemove(const std::string& lan) const
 	return GameMove();
 }
 
-std::string Game::legal_to_string(const GameMoveInt& move) const
+/// <summary>
+/// writes m_legal_moves[legal_index] in fmt. SAN/LAN mark checks with '+', mates are not detected.
+/// </summary>
+/// <param name="buffer">output with space for GAME_MOVE_STR_LEN_MAX chars and '\0'</param>
+/// <returns>length without '\0'</returns>
+int Game::write_legal(char* buffer, int legal_index, GameMoveStrFmt fmt) const
 {
-	//TODO
-	return legal_to_uci(move);
-}
-
-std::string Game::legal_to_uci(const GameMoveInt& move) const
-{
-	/*const GameDelta& gd = m_gamedelta_list.back();
-	std::string uci(gd.m.IsPromo() ? 5 : 4,' ');
-
-	const Position from = IndexToPosition(gd.m.from);
-	uci[0] = 'a' + from.x;
-	uci[1] = '1' + from.y;
-	const Position to = IndexToPosition(gd.m.to);
-	uci[2] = 'a' + to.x;
-	uci[3] = '1' + to.y;
-	if (gd.m.IsPromo()) uci[4] = PIECE_TO_CHAR.at(gd.m.promo);
-	return uci;*/
-	std::string uci(4,' ');
-
-	const Position from = bindex_to_position(move.get_from());
-	uci[0] = 'a' + from.x;
-	uci[1] = '1' + from.y;
-	const Position to = bindex_to_position(move.get_to());
-	uci[2] = 'a' + to.x;
-	uci[3] = '1' + to.y;
-	if (move.is_promotion()) uci += piece_to_char(move.get_promotion());
-	return uci;
-	
-}
+	const GameMoveInt& move = m_legal_moves[legal_index];
+	if (fmt == GameMoveStrFmt::DEFAULT) fmt = m_string_fmt;
+	if (fmt == GameMoveStrFmt::UCI) return write_gd(buffer, GameDelta(gmi_to_gm(move)), fmt, false);
 
-std::string Game::legal_to_san(const GameMoveInt& move) const
-{
-	//const GameDelta& gd = m_gamedelta_list.back();
-	//std::stringstream ss;
-
-	//// castling special cases
-	//if (gd.m.IsKSCastle()) {
-	//	ss << "O-O";
-	//	if (gd.check) ss << "+";
-	//	return ss.str();
-	//}
-	//if (gd.m.IsQSCastle()) {
-	//	ss << "O-O-O";
-	//	if (gd.check) ss << "+";
-	//	return ss.str();
-	//}
-
-	//// From Piece?
-	//UniquePiece from_up = m_board.index2up[gd.m.to];
-	//if (from_up.p != PIECE::PAWN) ss << PIECE_TO_CHAR.at(from_up.p);
-	//
-	//// From rank, file?
-	//const Position from = IndexToPosition(gd.m.from);
-	//for (int index = GAME_WIDTH * from.y; index < GAME_WIDTH * (from.y + 1); index++) {
-	//	UniquePiece up = m_board.index2up[index];
-	//	if (up.p == from_up.p && up.IsAlly(from_up.GetColor())) {
-	//		ss << from.x - 'a';
-	//		break;
-	//	}
-	//}
-	//for (int index = from.x; index < GAME_NUMBER_OF_TILES; index += GAME_WIDTH) {
-	//	UniquePiece up = m_board.index2up[index];
-	//	if (up.p == from_up.p && up.IsAlly(from_up.GetColor())) {
-	//		ss << from.y - '1';
-	//		break;
-	//	}
-	//}
-	//
-	//if (gd.m.IsTakes()) ss << 'x';
-
-	//const Position to = IndexToPosition(gd.m.to);
-	//ss << to.x - 'a' << to.y - '1';
-	//
-	//if(gd.m.IsPromo()) ss << '=' << PIECE_TO_CHAR.at(gd.m.promo);
-
-	//if (gd.check) ss << '+';
-
-	//return ss.str();
-	// TODO
-	return std::string("TODO");
-}
-
-std::string Game::legal_to_lan(const GameMoveInt& move) const
-{
-	//const GameDelta& gd = m_gamedelta_list.back();
-	//std::stringstream ss;
-
-	//// castling special cases
-	//if (gd.m.IsKSCastle()) {
-	//	ss << "O-O";
-	//	if (gd.check) ss << "+";
-	//	return ss.str();
-	//}
-	//if (gd.m.IsQSCastle()) {
-	//	ss << "O-O-O";
-	//	if (gd.check) ss << "+";
-	//	return ss.str();
-	//}
-
-	//// From Piece?
-	//UniquePiece from_up = m_board.index2up[gd.m.to];
-	//if (from_up.p != PIECE::PAWN) ss << PIECE_TO_CHAR.at(from_up.p);
-
-	//// From rank, file?
-	//const Position from = IndexToPosition(gd.m.from);
-	//ss << from.x - 'a' << from.y - '1';
-	//
-	//if (gd.m.IsTakes()) ss << 'x';
-
-	//const Position to = IndexToPosition(gd.m.to);
-	//ss << to.x - 'a' << to.y - '1';
-
-	//if (gd.m.IsPromo()) ss << '=' << PIECE_TO_CHAR.at(gd.m.promo);
-
-	//if (gd.check) ss << '+';
-
-	//return ss.str();
-	return std::string("TODO");
-}
-
-std::string Game::gd_to_string(const GameDelta& gd) const
-{
-	switch (m_string_fmt)
-	{
-	case GameMoveStrFmt::DEFAULT: return std::string{};
-	case GameMoveStrFmt::UCI: return gd_to_uci(gd);
-	case GameMoveStrFmt::SAN: return gd_to_san(gd);
-	case GameMoveStrFmt::LAN: return gd_to_lan(gd);
-	}
+	if (!m_legal_index_valid) build_legal_index();
+	GameDelta gd = legal_to_gd(gmi_to_gm(move));
+	gd.piece = m_board.get_piece_from_bindex(move.get_from());
+	gd.disambiguation = m_legal_disambiguation[legal_index];
+	gd.check = move_gives_check(move);
+	return write_gd(buffer, gd, fmt, false);
 }
 
-std::string Game::gd_to_uci(const GameDelta& gd) const
+/// <summary>
+/// writes a game delta in fmt. SAN and LAN need gd.piece and gd.disambiguation as set by move.
+/// </summary>
+/// <param name="buffer">output with space for GAME_MOVE_STR_LEN_MAX chars and '\0'</param>
+/// <param name="mate">replaces the check suffix with '#'</param>
+/// <returns>length without '\0'</returns>
+int Game::write_gd(char* buffer, const GameDelta& gd, GameMoveStrFmt fmt, bool mate) const
 {
-	std::string uci(4, ' ');
-
+	if (fmt == GameMoveStrFmt::DEFAULT) fmt = m_string_fmt;
 	const Position from = bindex_to_position(gd.move.from);
-	uci[0] = 'a' + from.x;
-	uci[1] = '1' + from.y;
 	const Position to = bindex_to_position(gd.move.to);
-	uci[2] = 'a' + to.x;
-	uci[3] = '1' + to.y;
-	if (gd.IsPromotion()) uci += piece_to_char(gd.move.promotion);
-	return uci;
+	int len = 0;
+
+	if (fmt == GameMoveStrFmt::UCI) {
+		buffer[len++] = 'a' + from.x;
+		buffer[len++] = '1' + from.y;
+		buffer[len++] = 'a' + to.x;
+		buffer[len++] = '1' + to.y;
+		if (gd.IsPromotion()) buffer[len++] = piece_to_char(gd.move.promotion);
+		buffer[len] = '\0';
+		return len;
+	}
+
+	if (gd.IsCastle()) {
+		const char* castles = gd.IsKSCastle() ? "O-O" : "O-O-O";
+		while (*castles) buffer[len++] = *castles++;
+	}
+	else {
+		if (gd.piece != Piece::PAWN) buffer[len++] = std::toupper(piece_to_char(gd.piece));
+		if (fmt == GameMoveStrFmt::LAN) {
+			buffer[len++] = 'a' + from.x;
+			buffer[len++] = '1' + from.y;
+			buffer[len++] = gd.IsTakes() ? 'x' : '-';
+		}
+		else {
+			if ((gd.disambiguation & GAME_SAN_FILE) || (gd.piece == Piece::PAWN && gd.IsTakes())) buffer[len++] = 'a' + from.x;
+			if (gd.disambiguation & GAME_SAN_RANK) buffer[len++] = '1' + from.y;
+			if (gd.IsTakes()) buffer[len++] = 'x';
+		}
+		buffer[len++] = 'a' + to.x;
+		buffer[len++] = '1' + to.y;
+		if (gd.IsPromotion()) {
+			buffer[len++] = '=';
+			buffer[len++] = std::toupper(piece_to_char(gd.move.promotion));
+		}
+	}
+
+	if (mate) buffer[len++] = '#';
+	else if (gd.check) buffer[len++] = '+';
+	buffer[len] = '\0';
+	return len;
+}
+
+/// <summary>
+/// Checks if a legal move of the active player attacks the passive king without applying it.
+/// Looks from the passive king along all rays, knight jumps and pawn captures on the board after the move,
+/// which covers direct, discovered, castle (rook), en passant and promotion checks.
+/// </summary>
+bool Game::move_gives_check(const GameMoveInt& move) const
+{
+	const int king_bindex = m_board.get_bindex(m_swap_vars.passive->king_id);
+	const int from_bindex = move.get_from();
+	const int to_bindex = move.get_to();
+	const Piece moved = m_board.get_piece_from_bindex(from_bindex);
+
+	// squares that change: the mover leaves from and lands on to. castles also move the rook, en passant removes the passed pawn
+	int vacated_bindex = -1;
+	int rook_bindex = -1;
+	if (moved == Piece::KING && to_bindex - from_bindex == 2) {
+		vacated_bindex = from_bindex + 3;
+		rook_bindex = from_bindex + 1;
+	}
+	else if (moved == Piece::KING && from_bindex - to_bindex == 2) {
+		vacated_bindex = from_bindex - 4;
+		rook_bindex = from_bindex - 1;
+	}
+	else if (is_en_passant(move)) {
+		vacated_bindex = m_p2_index;
+	}
+	const Piece placed = move.is_promotion() ? move.get_promotion() : moved;
+	const ChessColor active_color = m_swap_vars.active->color;
+
+	// piece of the active player after the move, EMPTY if none. blocked is set for any piece
+	auto ally_after = [&](int bindex, bool& blocked) -> Piece {
+		blocked = true;
+		if (bindex == to_bindex) return placed;
+		if (bindex == rook_bindex) return Piece::ROOK;
+		if (bindex == from_bindex || bindex == vacated_bindex) {
+			blocked = false;
+			return Piece::EMPTY;
+		}
+		const UniquePiece up = m_board.get_up(bindex);
+		blocked = !up.IsEmpty();
+		return up.IsAlly(active_color) ? up.p : Piece::EMPTY;
+	};
+
+	bool blocked = false;
+	for (Direction dir = Direction::N; dir <= Direction::NW; ++dir) {
+		const bool is_hv = dir <= Direction::W;
+		const int delta = get_bindex_delta(dir);
+		const int steps = GetOOBSteps(king_bindex, dir);
+		int bindex = king_bindex;
+		for (int step = 0; step < steps; step++) {
+			bindex += delta;
+			const Piece p = ally_after(bindex, blocked);
+			if (p == Piece::QUEEN || (is_hv && p == Piece::ROOK) || (!is_hv && p == Piece::BISHOP)) return true;
+			if (blocked) break;
+		}
+	}
+	for (Direction dir = Direction::NNE; dir <= Direction::NNW; ++dir) {
+		if (GetOOBSteps(king_bindex, dir) > 0 && ally_after(king_bindex + get_bindex_delta(dir), blocked) == Piece::KNIGHT) return true;
+	}
+	// pawns of the active player capture towards the passive king
+	const Direction pawn_dirs[2] = {
+		active_color.IsWhite() ? Direction::SW : Direction::NW,
+		active_color.IsWhite() ? Direction::SE : Direction::NE
+	};
+	for (const Direction dir : pawn_dirs) {
+		if (GetOOBSteps(king_bindex, dir) > 0 && ally_after(king_bindex + get_bindex_delta(dir), blocked) == Piece::PAWN) return true;
+	}
+	return false;
 }
 
-std::string Game::gd_to_san(const GameDelta& gd) const
+bool Game::is_last_move_mate() const
 {
-	return std::string();
+	if (m_gamedelta_list.empty() || !m_game_has_ended) return false;
+	return m_ending_gamestate == GameEndState::WHITE_WIN_CM || m_ending_gamestate == GameEndState::BLACK_WIN_CM;
 }
 
-std::string Game::gd_to_lan(const GameDelta& gd) const
+// centipawns per Piece for the static exchange evaluation. The king is never captured
+static constexpr int SEE_PIECE_VALUE[7] = { 0, 0, 900, 330, 320, 500, 100 };
+// order in which the attackers of a square capture: pawn, knight, bishop, rook, queen, king
+static constexpr int SEE_PIECE_ORDER[7] = { 6, 5, 4, 2, 1, 3, 0 };
+
+/// <summary>
+/// pieces able to capture on one square during a static exchange. Starts with the pieces covering the square
+/// and adds the sliders behind a piece once it left for the square (x-rays). The board is only read.
+/// </summary>
+class ExchangeSquare
 {
-	return std::string();
+public:
+	ExchangeSquare(const ChessBoard& board, int bindex) : m_board(board), m_bindex(bindex), m_attackers(board.get_cover_ids(bindex)), m_removed(0)
+	{
+		// the coverage of sliders passes through the king of the other color, it blocks them until it captured
+		for (uint32_t ids = m_attackers; ids; ids &= ids - 1) {
+			const int id = std::countr_zero(ids);
+			if (!is_slider(m_board.get_piece_from_id(id))) continue;
+			if (nearest(get_hvd(m_bindex, m_board.get_bindex(id)), m_bindex) != m_board.get_bindex(id)) m_attackers &= ~(uint32_t(1) << id);
+		}
+	}
+
+	// takes the piece on bindex off the board of the exchange and adds the slider behind it
+	void remove(int bindex)
+	{
+		m_removed |= uint64_t(1) << bindex;
+		m_attackers &= ~(uint32_t(1) << m_board.get_id(bindex));
+		const Direction dir = get_hvd(m_bindex, bindex);
+		if (dir == Direction::NONE) return;
+		const int behind = nearest(dir, bindex);
+		if (behind == -1) return;
+		const Piece p = m_board.get_piece_from_bindex(behind);
+		if (p == Piece::QUEEN || p == (is_hvd_straight(dir) ? Piece::ROOK : Piece::BISHOP)) m_attackers |= uint32_t(1) << m_board.get_id(behind);
+	}
+
+	// least valuable attacker of the color of color_off, -1 if there is none
+	int least_valuable(int color_off) const
+	{
+		int best_id = -1;
+		int best_order = 7;
+		for (uint32_t ids = m_attackers & color_mask(color_off); ids; ids &= ids - 1) {
+			const int id = std::countr_zero(ids);
+			const int order = SEE_PIECE_ORDER[static_cast<int>(m_board.get_piece_from_id(id))];
+			if (order < best_order) {
+				best_order = order;
+				best_id = id;
+			}
+		}
+		return best_id;
+	}
+
+	bool has_attacker(int color_off) const
+	{
+		return (m_attackers & color_mask(color_off)) != 0;
+	}
+
+private:
+	static uint32_t color_mask(int color_off)
+	{
+		return ((uint32_t(1) << GAME_MAX_COLOR_ID) - 1) << color_off;
+	}
+
+	static bool is_slider(Piece p)
+	{
+		return p == Piece::QUEEN || p == Piece::ROOK || p == Piece::BISHOP;
+	}
+
+	static bool is_hvd_straight(Direction dir)
+	{
+		return dir >= Direction::N && dir <= Direction::W;
+	}
+
+	// first occupied square after from in direction dir, -1 if there is none
+	int nearest(Direction dir, int from) const
+	{
+		const int d = get_bindex_delta(dir);
+		int to_index = from;
+		for (int8_t n = GetOOBSteps(from, dir); n > 0; n--) {
+			to_index += d;
+			if (m_removed & (uint64_t(1) << to_index)) continue;
+			if (m_board.get_piece_from_bindex(to_index) != Piece::EMPTY) return to_index;
+		}
+		return -1;
+	}
+
+	const ChessBoard& m_board;
+	const int m_bindex;
+	uint32_t m_attackers;
+	uint64_t m_removed;
+};
+
+void Game::see_start(const GameMove& move, int& captured_value, int& moved_value) const
+{
+	captured_value = is_en_passant(move) ? SEE_PIECE_VALUE[static_cast<int>(Piece::PAWN)] : SEE_PIECE_VALUE[static_cast<int>(m_board.get_piece_from_bindex(move.to))];
+	moved_value = SEE_PIECE_VALUE[static_cast<int>(m_board.get_piece_from_bindex(move.from))];
+	if (move.promotion != Piece::EMPTY) {
+		captured_value += SEE_PIECE_VALUE[static_cast<int>(move.promotion)] - moved_value;
+		moved_value = SEE_PIECE_VALUE[static_cast<int>(move.promotion)];
+	}
+}
+
+/// <summary>
+/// swap algorithm: gain[d] is the material won by the side making the d-th capture if the exchange stopped there.
+/// Going back from the last capture, each side only captures if it does not lose by it.
+/// A king only captures if the other side has no attacker left. Recaptures are never promotions.
+/// </summary>
+int Game::see(const GameMove& move) const
+{
+	if (!move_is_legal(move)) return 0;
+	std::array<int, GAME_MAX_ID + 1> gain;
+	int on_square;
+	see_start(move, gain[0], on_square);
+
+	ExchangeSquare square(m_board, move.to);
+	square.remove(move.from);
+	if (is_en_passant(move)) square.remove(m_p2_index);
+
+	int color_off = m_swap_vars.passive->color_offset;
+	int d = 0;
+	for (int id = square.least_valuable(color_off); id != -1; id = square.least_valuable(color_off)) {
+		const int other_off = color_off ^ GAME_MAX_COLOR_ID;
+		if (m_board.get_piece_from_id(id) == Piece::KING && square.has_attacker(other_off)) break;
+		d++;
+		gain[d] = on_square - gain[d - 1];
+		on_square = SEE_PIECE_VALUE[static_cast<int>(m_board.get_piece_from_id(id))];
+		square.remove(m_board.get_bindex(id));
+		color_off = other_off;
+	}
+	for (; d > 0; d--) gain[d - 1] = -std::max(-gain[d - 1], gain[d]);
+	return gain[0];
+}
+
+/// <summary>
+/// swap is what the side to capture next has to win back for the threshold to be missed (or reached).
+/// Each capture flips the winner res, the exchange ends as soon as the side to capture can not change it.
+/// </summary>
+bool Game::see_ge(const GameMove& move, int threshold) const
+{
+	if (!move_is_legal(move)) return threshold <= 0;
+	int captured_value;
+	int moved_value;
+	see_start(move, captured_value, moved_value);
+	int swap = captured_value - threshold;
+	if (swap < 0) return false;
+	swap = moved_value - swap;
+	if (swap <= 0) return true;
+
+	ExchangeSquare square(m_board, move.to);
+	square.remove(move.from);
+	if (is_en_passant(move)) square.remove(m_p2_index);
+
+	bool res = true;
+	int color_off = m_swap_vars.passive->color_offset;
+	for (int id = square.least_valuable(color_off); id != -1; id = square.least_valuable(color_off)) {
+		const int other_off = color_off ^ GAME_MAX_COLOR_ID;
+		if (m_board.get_piece_from_id(id) == Piece::KING) return square.has_attacker(other_off) ? res : !res;
+		res = !res;
+		swap = SEE_PIECE_VALUE[static_cast<int>(m_board.get_piece_from_id(id))] - swap;
+		if (swap < int(res)) break;
+		square.remove(m_board.get_bindex(id));
+		color_off = other_off;
+	}
+	return res;
 }
 
 void Game::update_p2_index(const GameDelta& gd)
@@ -1449,6 +2159,211 @@ void Game::undo_update_castles(PlayerCastles white_last, PlayerCastles black_las
 	m_swap_vars.black.castles = black_last;
 }
 
+/// <summary>
+/// executes gd on the board and updates castle rights, en passant, clocks and active color.
+/// Does not touch the delta lists and does not generate legal moves.
+/// </summary>
+void Game::apply_delta(const GameDelta& gd, bool notify)
+{
+	//castle rights depend on the piece before it moves
+	update_castles(gd);
+
+	//execute move on board
+	m_board.apply_gamedelta(gd);
+	update_p2_index(gd);
+
+	//end turn. gd.piece is the piece before a promotion
+	if (m_swap_vars.active->color.IsBlack()) m_turn_number += 1;
+	m_half_turn_number += 1;
+	if (gd.IsTakes() || gd.piece == Piece::PAWN) m_half_turn_number = 0;
+
+	m_swap_vars.Swap();
+
+	if (!notify || m_observers.empty()) return;
+	BoardEvent event;
+	event.type = BoardEventType::MOVE;
+	event.tile_count = new_tiles(gd, event.tiles);
+	publish(event, &gd);
+}
+
+/// <summary>
+/// inverse of apply_delta
+/// </summary>
+void Game::revert_delta(const GameDelta& gd, bool notify)
+{
+	const bool publish_event = notify && !m_observers.empty();
+	BoardEvent event;
+	if (publish_event) {
+		event.type = BoardEventType::UNDO;
+		event.tile_count = reverse_new_tiles(gd, event.tiles);
+	}
+
+	m_swap_vars.Swap();
+	if (m_swap_vars.active->color.IsBlack()) m_turn_number--;
+	m_half_turn_number = gd.half_turns;
+	undo_update_castles(gd.white_castle, gd.black_castle);
+	undo_update_p2_index(gd.p2_index);
+	m_board.undo_gamedelta(gd);
+
+	if (publish_event) publish(event, &gd);
+}
+
+/// <summary>
+/// applies gd and appends it to the history without generating legal moves
+/// </summary>
+void Game::push_delta(const GameDelta& gd)
+{
+	discard_legal_states();
+	apply_delta(gd);
+	m_gamedelta_list.push_back(gd);
+	push_checkpoint_if_due();
+}
+
+/// <summary>
+/// reverts and removes the last delta of the history without generating legal moves
+/// </summary>
+void Game::pop_delta()
+{
+	revert_delta(m_gamedelta_list.back());
+	m_gamedelta_list.pop_back();
+}
+
+/// <summary>
+/// plays a legal move of the current position and generates the legal moves of the new one.
+/// Nothing is allocated while the history stays within its capacity.
+/// </summary>
+GameState Game::search_move(const GameMoveInt& gmove)
+{
+	GameDelta gd = legal_to_gd(gmi_to_gm(gmove));
+	gd.white_castle = m_swap_vars.white.castles;
+	gd.black_castle = m_swap_vars.black.castles;
+	gd.half_turns = m_half_turn_number;
+	gd.p2_index = m_p2_index;
+	gd.piece = m_board.get_piece_from_bindex(gd.move.from);
+
+	// playouts rarely take a move back with its legal moves needed, so nothing is cached here
+	discard_legal_states();
+	apply_delta(gd, false);
+	gd.check = get_is_check();
+	m_gamedelta_list.push_back(gd);
+	m_legal_index_valid = false;
+
+	update_legal_moves();
+	return m_game_has_ended ? GameState::GAME_HAS_ENDED : GameState::VALID_MOVE;
+}
+
+/// <summary>
+/// takes back the last search_move. Only the board state is restored, call update_legal_moves before using the legal moves
+/// </summary>
+void Game::search_undo()
+{
+	revert_delta(m_gamedelta_list.back(), false);
+	m_gamedelta_list.pop_back();
+	m_game_has_ended = false;
+	m_legal_index_valid = false;
+}
+
+/// <summary>
+/// legal moves and game ending state of the position after pushing/popping deltas
+/// </summary>
+void Game::update_legal_moves()
+{
+	m_game_has_ended = false;
+	if (!restore_legal_state()) {
+		find_pinned_pieces();
+		find_legal_moves();
+	}
+	update_game_has_ended(get_is_check());
+}
+
+/// <summary>
+/// stores the legal moves and pins of the current position unless they are stored already.
+/// Only called while the legal moves are up to date, right before a delta is pushed
+/// </summary>
+void Game::push_legal_state()
+{
+	discard_legal_states();
+	const int ply = get_ply();
+	if (!m_legal_states.empty() && m_legal_states.back().ply == ply) return;
+	m_legal_states.push_back({ m_pin_mask, m_check_mask, ply,
+		static_cast<uint32_t>(m_legal_state_moves.size()), static_cast<uint16_t>(m_legal_moves.size()) });
+	m_legal_state_moves.insert(m_legal_state_moves.end(), m_legal_moves.begin(), m_legal_moves.end());
+}
+
+/// <summary>
+/// legal moves and pins of the current position from the stack. returns false if they are not stored
+/// </summary>
+bool Game::restore_legal_state()
+{
+	discard_legal_states();
+	if (m_legal_states.empty() || m_legal_states.back().ply != get_ply()) return false;
+	const LegalState& state = m_legal_states.back();
+	const auto moves = m_legal_state_moves.begin() + state.move_begin;
+	m_legal_moves.assign(moves, moves + state.move_count);
+	m_pin_mask = state.pin_mask;
+	m_check_mask = state.check_mask;
+	m_legal_index_valid = false;
+	GAME_STAT_ADD(legal_states_restored, 1);
+	return true;
+}
+
+/// <summary>
+/// drops the states of plies after the current one. Their positions are gone once a delta is popped and another pushed
+/// </summary>
+void Game::discard_legal_states()
+{
+	const int ply = get_ply();
+	while (!m_legal_states.empty() && m_legal_states.back().ply > ply) {
+		m_legal_state_moves.resize(m_legal_states.back().move_begin);
+		m_legal_states.pop_back();
+	}
+}
+
+/// <summary>
+/// drops the undone moves and the checkpoints after the current ply
+/// </summary>
+void Game::discard_redo()
+{
+	m_redo_list.clear();
+	const size_t keep = m_gamedelta_list.size() / GAME_CHECKPOINT_INTERVAL + 1;
+	if (m_checkpoints.size() > keep) m_checkpoints.resize(keep);
+}
+
+void Game::push_checkpoint_if_due()
+{
+	const size_t ply = m_gamedelta_list.size();
+	if (ply % GAME_CHECKPOINT_INTERVAL != 0) return;
+	if (m_checkpoints.size() == ply / GAME_CHECKPOINT_INTERVAL) m_checkpoints.push_back(make_checkpoint());
+}
+
+GameCheckpoint Game::make_checkpoint() const
+{
+	GameCheckpoint checkpoint;
+	checkpoint.placement = m_board.get_placement();
+	checkpoint.white_castle = m_swap_vars.white.castles;
+	checkpoint.black_castle = m_swap_vars.black.castles;
+	checkpoint.p2_index = static_cast<int8_t>(m_p2_index);
+	checkpoint.half_turns = m_half_turn_number;
+	checkpoint.turn_number = m_turn_number;
+	checkpoint.black_to_move = m_swap_vars.active->color.IsBlack();
+	return checkpoint;
+}
+
+void Game::restore_checkpoint(const GameCheckpoint& checkpoint)
+{
+	m_board.set_placement(checkpoint.placement);
+	m_swap_vars.white.castles = checkpoint.white_castle;
+	m_swap_vars.black.castles = checkpoint.black_castle;
+	if (m_swap_vars.active->color.IsBlack() != checkpoint.black_to_move) m_swap_vars.Swap();
+	m_p2_index = checkpoint.p2_index;
+	m_half_turn_number = checkpoint.half_turns;
+	m_turn_number = checkpoint.turn_number;
+
+	if (m_observers.empty()) return;
+	BoardEvent event;
+	publish(event, nullptr);
+}
+
 //--------------------------------DEBUG UTIL---------------------------------------//
 
 GameState Game::perft_move(const GameMoveInt& gmove)
@@ -1458,6 +2373,7 @@ GameState Game::perft_move(const GameMoveInt& gmove)
 	gd.black_castle = m_swap_vars.black.castles;
 	gd.half_turns = m_half_turn_number;
 	gd.p2_index = m_p2_index;
+	push_legal_state();
 	//execute move on board
 	update_castles(gd);
 	m_board.apply_gamedelta(gd);
@@ -1497,6 +2413,7 @@ void Game::perft_undo()
 	undo_update_castles(gd_last.white_castle, gd_last.black_castle);
 	undo_update_p2_index(gd_last.p2_index);
 	m_board.undo_gamedelta(gd_last);
+	restore_legal_state();
 
 	return;
 }
@@ -1507,6 +2424,5 @@ char Game::bindex_to_pinned_dir_char_DEBUG(int bindex)
 	if (up.IsEmpty()) return '.';
 	if (up.IsEnemy(m_swap_vars.active->color)) return '.';
 	if (up.p == Piece::KING) return 'K';
-	int pinned_offset = m_swap_vars.active->color.IsWhite() ? 1 : 17;
-	return char(int(m_pinned_direction[up.id - pinned_offset]) + '0');
+	return m_pin_mask[up.id] != ~uint64_t(0) ? 'P' : '0';
 }
\ No newline at end of file
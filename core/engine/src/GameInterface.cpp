@@ -1,5 +1,105 @@
 #include "GameInterface.h"
 
+#include <algorithm>
+#include <array>
+
+static int tiles_to_pos(std::span<const TileI> tiles, std::span<TileP> out)
+{
+    const int n = static_cast<int>(std::min(tiles.size(), out.size()));
+    for (int i = 0; i < n; i++) out[i] = TileP{ bindex_to_position(tiles[i].index), tiles[i].piece, tiles[i].color };
+    return n;
+}
+
+std::string IGame::get_fen() const
+{
+    char buffer[GAME_FEN_LEN_MAX];
+    const int n = to_fen(buffer, GAME_FEN_LEN_MAX);
+    return std::string(buffer, n);
+}
+
+std::vector<GameMove> IGame::get_possible_moves() const
+{
+    std::array<GameMove, GAME_MAX_MOVES> moves;
+    const int n = get_possible_moves(moves);
+    return std::vector<GameMove>(moves.begin(), moves.begin() + n);
+}
+
+std::vector<GameMove> IGame::get_possible_moves(int from_ind) const
+{
+    std::array<GameMove, GAME_MAX_MOVES> moves;
+    const int n = get_possible_moves(from_ind, moves);
+    return std::vector<GameMove>(moves.begin(), moves.begin() + n);
+}
+
+std::vector<int> IGame::get_possible_moves_ind(int from_ind) const
+{
+    std::array<int, GAME_MAX_MOVES> indices;
+    const int n = get_possible_moves_ind(from_ind, indices);
+    return std::vector<int>(indices.begin(), indices.begin() + n);
+}
+
+std::vector<TileI> IGame::get_all_tiles_ind() const
+{
+    std::array<TileI, GAME_MAX_PIECES> tiles;
+    const int n = get_all_tiles_ind(tiles);
+    return std::vector<TileI>(tiles.begin(), tiles.begin() + n);
+}
+
+std::vector<TileI> IGame::get_new_tiles_ind() const
+{
+    std::array<TileI, GAME_MAX_CHANGED_TILES> tiles;
+    const int n = get_new_tiles_ind(tiles);
+    return std::vector<TileI>(tiles.begin(), tiles.begin() + n);
+}
+
+std::vector<TileI> IGame::get_reverse_new_tiles_ind() const
+{
+    std::array<TileI, GAME_MAX_CHANGED_TILES> tiles;
+    const int n = get_reverse_new_tiles_ind(tiles);
+    return std::vector<TileI>(tiles.begin(), tiles.begin() + n);
+}
+
+std::vector<GameMove> IGame::get_all_moves() const
+{
+    std::vector<GameMove> vret(get_ply());
+    get_all_moves(vret);
+    return vret;
+}
+
+int IGame::get_possible_moves(Position from_pos, std::span<GameMove> out) const
+{
+    return get_possible_moves(position_to_bindex(from_pos), out);
+}
+
+int IGame::get_possible_moves_pos(Position from_pos, std::span<Position> out) const
+{
+    std::array<int, GAME_MAX_MOVES> indices;
+    const int n = std::min(get_possible_moves_ind(position_to_bindex(from_pos), indices), static_cast<int>(out.size()));
+    for (int i = 0; i < n; i++) out[i] = bindex_to_position(indices[i]);
+    return n;
+}
+
+int IGame::get_all_tiles_pos(std::span<TileP> out) const
+{
+    std::array<TileI, GAME_MAX_PIECES> tiles;
+    const int n = get_all_tiles_ind(tiles);
+    return tiles_to_pos(std::span<const TileI>(tiles.data(), n), out);
+}
+
+int IGame::get_new_tiles_pos(std::span<TileP> out) const
+{
+    std::array<TileI, GAME_MAX_CHANGED_TILES> tiles;
+    const int n = get_new_tiles_ind(tiles);
+    return tiles_to_pos(std::span<const TileI>(tiles.data(), n), out);
+}
+
+int IGame::get_reverse_new_tiles_pos(std::span<TileP> out) const
+{
+    std::array<TileI, GAME_MAX_CHANGED_TILES> tiles;
+    const int n = get_reverse_new_tiles_ind(tiles);
+    return tiles_to_pos(std::span<const TileI>(tiles.data(), n), out);
+}
+
 std::vector<GameMove> IGame::get_possible_moves(Position from_pos) const
 {
     return get_possible_moves(position_to_bindex(from_pos));
@@ -7,36 +107,28 @@ std::vector<GameMove> IGame::get_possible_moves(Position from_pos) const
 
 std::vector<Position> IGame::get_possible_moves_pos(Position from_pos) const
 {
-    const std::vector<int>& vind = get_possible_moves_ind(position_to_bindex(from_pos));
-    std::vector<Position> vpos;
-    vpos.reserve(vind.size());
-    for (int index : vind) vpos.push_back(bindex_to_position(index));
-    return vpos;
+    std::array<Position, GAME_MAX_MOVES> positions;
+    const int n = get_possible_moves_pos(from_pos, positions);
+    return std::vector<Position>(positions.begin(), positions.begin() + n);
 }
 
 std::vector<TileP> IGame::get_all_tiles_pos() const
 {
-    const std::vector<TileI>& vind = get_all_tiles_ind();
-    std::vector<TileP> vpos;
-    vpos.reserve(vind.size());
-    for (const TileI& ti : vind) vpos.emplace_back(bindex_to_position(ti.index),ti.piece, ti.color);
-    return vpos;
+    std::array<TileP, GAME_MAX_PIECES> tiles;
+    const int n = get_all_tiles_pos(tiles);
+    return std::vector<TileP>(tiles.begin(), tiles.begin() + n);
 }
 
 std::vector<TileP> IGame::get_new_tiles_pos() const
 {
-    const std::vector<TileI>& vind = get_new_tiles_ind();
-    std::vector<TileP> vpos;
-    vpos.reserve(vind.size());
-    for (const TileI& ti : vind) vpos.emplace_back(bindex_to_position(ti.index), ti.piece, ti.color);
-    return vpos;
+    std::array<TileP, GAME_MAX_CHANGED_TILES> tiles;
+    const int n = get_new_tiles_pos(tiles);
+    return std::vector<TileP>(tiles.begin(), tiles.begin() + n);
 }
 
 std::vector<TileP> IGame::get_reverse_new_tiles_pos() const
 {
-    const std::vector<TileI>& vind = get_reverse_new_tiles_ind();
-    std::vector<TileP> vpos;
-    vpos.reserve(vind.size());
-    for (const TileI& ti : vind) vpos.emplace_back(bindex_to_position(ti.index), ti.piece, ti.color);
-    return vpos;
+    std::array<TileP, GAME_MAX_CHANGED_TILES> tiles;
+    const int n = get_reverse_new_tiles_pos(tiles);
+    return std::vector<TileP>(tiles.begin(), tiles.begin() + n);
 }
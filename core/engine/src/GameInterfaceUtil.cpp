@@ -42,6 +42,27 @@ bool operator==(const GameMove& lhs, const GameMove& rhs)
 	return true;
 }
 
+const char* fen_error_to_string(FenError error)
+{
+	switch (error) {
+	case FenError::NONE: return "ok";
+	case FenError::MISSING_SECTION: return "fen needs 6 sections";
+	case FenError::TRAILING_CHARACTERS: return "unexpected characters after turn number";
+	case FenError::BOARD_INVALID_CHAR: return "invalid character in board section";
+	case FenError::BOARD_RANK_SIZE: return "rank does not have 8 files";
+	case FenError::BOARD_RANK_COUNT: return "board does not have 8 ranks";
+	case FenError::BOARD_PIECE_COUNT: return "too many pieces of one color";
+	case FenError::BOARD_KING_COUNT: return "each side needs exactly one king";
+	case FenError::ACTIVE_COLOR: return "active color must be w or b";
+	case FenError::CASTLES: return "invalid castle section";
+	case FenError::EN_PASSANT: return "invalid en passant square";
+	case FenError::HALF_TURNS: return "invalid half turn clock";
+	case FenError::TURN_NUMBER: return "invalid turn number";
+	case FenError::KINGS_ADJACENT: return "kings are adjacent";
+	default: return "unknown error";
+	}
+}
+
 int position_to_bindex(Position pos)
 {
 	return pos.y * GAME_WIDTH + pos.x;
@@ -0,0 +1,161 @@
+#include "GamePlayer.h"
+#include "Mcts.h"
+
+#include <algorithm>
+#include <charconv>
+
+// score of being mated, reduced by the remaining depth so that faster mates are preferred
+#define GAME_PLAYER_MATE 100000
+#define GAME_PLAYER_INF 1000000
+
+
+std::unique_ptr<IGamePlayer> RandomPlayer::clone() const
+{
+	return std::make_unique<RandomPlayer>(*this);
+}
+
+std::string RandomPlayer::get_name() const
+{
+	return "random";
+}
+
+void RandomPlayer::new_game(uint64_t seed)
+{
+	m_rng.seed(seed);
+}
+
+GameMove RandomPlayer::choose_move(Game& game, const PlayerLimits& /*limits*/)
+{
+	std::array<GameMove, GAME_MAX_MOVES> moves;
+	const int n = game.get_possible_moves(moves);
+	if (n == 0) return GameMove();
+	return moves[std::uniform_int_distribution<int>(0, n - 1)(m_rng)];
+}
+
+
+MaterialPlayer::MaterialPlayer(int depth) :
+	m_depth(std::max(depth, 1)),
+	m_rng(),
+	m_limits(),
+	m_nodes(0),
+	m_deadline(),
+	m_stopped(false)
+{
+}
+
+std::unique_ptr<IGamePlayer> MaterialPlayer::clone() const
+{
+	return std::make_unique<MaterialPlayer>(*this);
+}
+
+std::string MaterialPlayer::get_name() const
+{
+	return "material:" + std::to_string(m_depth);
+}
+
+void MaterialPlayer::new_game(uint64_t seed)
+{
+	m_rng.seed(seed);
+}
+
+GameMove MaterialPlayer::choose_move(Game& game, const PlayerLimits& limits)
+{
+	std::array<GameMove, GAME_MAX_MOVES> moves;
+	const int n = game.get_possible_moves(moves);
+	if (n == 0) return GameMove();
+	// ties keep the first move found, shuffling picks a random one among them
+	std::shuffle(moves.begin(), moves.begin() + n, m_rng);
+
+	m_limits = limits;
+	m_nodes = 0;
+	m_deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(limits.move_time_ms);
+	m_stopped = false;
+
+	GameMove best = moves[0];
+	for (int depth = 1; depth <= m_depth; depth++) {
+		GameMove depth_best = moves[0];
+		int alpha = -GAME_PLAYER_INF;
+		for (int i = 0; i < n; i++) {
+			game.move(moves[i]);
+			const int score = -negamax(game, depth - 1, -GAME_PLAYER_INF, -alpha);
+			game.undo();
+			if (m_stopped) break;
+			if (score > alpha) {
+				alpha = score;
+				depth_best = moves[i];
+			}
+		}
+		// an interrupted depth did not look at all moves
+		if (m_stopped) break;
+		best = depth_best;
+	}
+	return best;
+}
+
+int MaterialPlayer::evaluate(const Game& game)
+{
+	static constexpr int piece_value[] = { 0, 0, 900, 330, 320, 500, 100 };
+	std::array<TileI, GAME_MAX_PIECES> tiles;
+	const int n = game.get_all_tiles_ind(tiles);
+	const bool white = game.get_active_color().IsWhite();
+	int score = 0;
+	for (int i = 0; i < n; i++) {
+		const int value = piece_value[static_cast<int>(tiles[i].piece)];
+		score += tiles[i].color.white == white ? value : -value;
+	}
+	return score;
+}
+
+int MaterialPlayer::negamax(Game& game, int depth, int alpha, int beta)
+{
+	m_nodes++;
+	if (game.get_game_has_ended()) {
+		const int state = static_cast<int>(game.get_ending_game_state());
+		const bool mate = state == static_cast<int>(GameEndState::WHITE_WIN_CM) || state == static_cast<int>(GameEndState::BLACK_WIN_CM);
+		return mate ? -GAME_PLAYER_MATE - depth : 0;
+	}
+	if (depth == 0 || out_of_budget()) return evaluate(game);
+
+	std::array<GameMove, GAME_MAX_MOVES> moves;
+	const int n = game.get_possible_moves(moves);
+	for (int i = 0; i < n; i++) {
+		game.move(moves[i]);
+		const int score = -negamax(game, depth - 1, -beta, -alpha);
+		game.undo();
+		if (m_stopped) return 0;
+		if (score >= beta) return score;
+		alpha = std::max(alpha, score);
+	}
+	return alpha;
+}
+
+bool MaterialPlayer::out_of_budget()
+{
+	if (m_limits.nodes && m_nodes >= m_limits.nodes) m_stopped = true;
+	// the clock is only read every 256 nodes
+	if (m_limits.move_time_ms && (m_nodes & 0xFF) == 0 && std::chrono::steady_clock::now() >= m_deadline) m_stopped = true;
+	return m_stopped;
+}
+
+
+std::unique_ptr<IGamePlayer> make_player(std::string_view name)
+{
+	if (name == "random") return std::make_unique<RandomPlayer>();
+	if (name == "mcts") {
+		// tournaments run one game per core, so the search uses a single thread and a smaller arena
+		MctsConfig config;
+		config.threads = 1;
+		config.max_nodes = 1 << 18;
+		return std::make_unique<MctsPlayer>(config);
+	}
+
+	const std::string_view material = "material";
+	if (name.substr(0, material.size()) != material) return nullptr;
+	name.remove_prefix(material.size());
+	if (name.empty()) return std::make_unique<MaterialPlayer>();
+	if (name[0] != ':') return nullptr;
+	int depth = 0;
+	const auto res = std::from_chars(name.data() + 1, name.data() + name.size(), depth);
+	if (res.ec != std::errc() || res.ptr != name.data() + name.size() || depth < 1) return nullptr;
+	return std::make_unique<MaterialPlayer>(depth);
+}
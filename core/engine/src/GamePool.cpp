@@ -0,0 +1,77 @@
+#include "GamePool.h"
+
+#include <algorithm>
+
+
+void GamePool::Releaser::operator()(Game* game) const
+{
+	if (m_pool) m_pool->release(game);
+	else delete game;
+}
+
+GamePool::GamePool(int initial_size) :
+	m_idle(), m_games(0)
+{
+	reserve(initial_size);
+}
+
+GamePool::Handle GamePool::acquire(std::string_view fen)
+{
+	if (m_idle.empty()) {
+		add_game_slot();
+		return Handle(new Game(fen), Releaser(this));
+	}
+	Game* game = m_idle.back().release();
+	m_idle.pop_back();
+	game->new_game(fen);
+	return Handle(game, Releaser(this));
+}
+
+GamePool::Handle GamePool::acquire(const PositionSnapshot& snapshot)
+{
+	if (m_idle.empty()) {
+		add_game_slot();
+		return Handle(new Game(snapshot), Releaser(this));
+	}
+	Game* game = m_idle.back().release();
+	m_idle.pop_back();
+	game->new_game(snapshot);
+	return Handle(game, Releaser(this));
+}
+
+void GamePool::reserve(int n)
+{
+	while (size() < n) {
+		add_game_slot();
+		m_idle.push_back(std::make_unique<Game>());
+	}
+}
+
+int GamePool::size() const
+{
+	return static_cast<int>(m_idle.size());
+}
+
+GamePool& GamePool::local()
+{
+	thread_local GamePool pool;
+	return pool;
+}
+
+void GamePool::release(Game* game)
+{
+	// the next user must not reach the accumulator of this one, new_game would refresh it
+	game->set_accumulator(nullptr);
+	game->set_coverage_mode(CoverageMode::INCREMENTAL);
+	// observers of the previous user may be gone before the next new_game publishes its reset
+	game->detach_all();
+	// m_idle has room for every created game, see add_game_slot
+	m_idle.emplace_back(game);
+}
+
+void GamePool::add_game_slot()
+{
+	const size_t games = m_games + 1;
+	if (games > m_idle.capacity()) m_idle.reserve(std::max(games, 2 * m_idle.capacity()));
+	m_games = games;
+}
@@ -0,0 +1,319 @@
+#include "GameSave.h"
+#include "GameUtils.h"
+#include "PgnReader.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+#define GAME_SAVE_FLAG_FEN 1
+// pgn lines are wrapped before this length
+#define GAME_PGN_LINE_MAX 80
+
+
+static void append_u8(std::string& out, unsigned value)
+{
+	out.push_back(static_cast<char>(value & 0xFF));
+}
+
+static void append_u16(std::string& out, unsigned value)
+{
+	out.push_back(static_cast<char>(value & 0xFF));
+	out.push_back(static_cast<char>((value >> 8) & 0xFF));
+}
+
+static bool read_u8(std::string_view data, size_t& pos, unsigned& value)
+{
+	if (pos + 1 > data.size()) return false;
+	value = static_cast<unsigned char>(data[pos]);
+	pos += 1;
+	return true;
+}
+
+static bool read_u16(std::string_view data, size_t& pos, unsigned& value)
+{
+	if (pos + 2 > data.size()) return false;
+	value = static_cast<unsigned char>(data[pos]) | (static_cast<unsigned char>(data[pos + 1]) << 8);
+	pos += 2;
+	return true;
+}
+
+static bool read_bytes(std::string_view data, size_t& pos, size_t n, std::string& value)
+{
+	if (pos + n > data.size()) return false;
+	value.assign(data.data() + pos, n);
+	pos += n;
+	return true;
+}
+
+static bool is_default_start(const char* fen)
+{
+	return std::strcmp(fen, GAME_DEFAULT_FEN) == 0;
+}
+
+static bool is_valid_end_state(unsigned value)
+{
+	// no default, so that -Wswitch reports end states added to the enum but not here
+	switch (static_cast<GameEndState>(value)) {
+	case GameEndState::WHITE_WIN_CM:
+	case GameEndState::WHITE_WIN_FF:
+	case GameEndState::WHITE_WIN_TIME:
+	case GameEndState::WHITE_WIN_REP_INV_MOVE:
+	case GameEndState::BLACK_WIN_CM:
+	case GameEndState::BLACK_WIN_FF:
+	case GameEndState::BLACK_WIN_TIME:
+	case GameEndState::BLACK_WIN_REP_INV_MOVE:
+	case GameEndState::END_DRAW_STALEMATE:
+	case GameEndState::END_DRAW_OFFER:
+	case GameEndState::END_DRAW_3FOLD:
+	case GameEndState::END_DRAW_MAX_TURNS:
+	case GameEndState::END_DRAW_MAX_HALF_TURNS:
+		return true;
+	}
+	return false;
+}
+
+bool write_game_binary(const IGame& game, const std::vector<GameTag>& tags, std::string& out)
+{
+	char fen[GAME_FEN_LEN_MAX];
+	const int fen_len = game.get_start_fen(fen, GAME_FEN_LEN_MAX);
+	const bool custom_start = !is_default_start(fen);
+	const std::vector<GameMove> moves = game.get_all_moves();
+	// cutting moves or tags would save a different game
+	if (tags.size() > 0xFF || moves.size() > 0xFFFF) return false;
+	for (const GameTag& tag : tags) {
+		if (tag.name.size() > 0xFF || tag.value.size() > 0xFFFF) return false;
+	}
+	const size_t tag_count = tags.size();
+	const size_t ply_count = moves.size();
+
+	out.reserve(out.size() + 10 + fen_len + 2 * ply_count);
+	out.append(GAME_SAVE_MAGIC, 4);
+	append_u8(out, GAME_SAVE_VERSION);
+	append_u8(out, custom_start ? GAME_SAVE_FLAG_FEN : 0);
+	append_u8(out, game.get_game_has_ended() ? static_cast<unsigned>(game.get_ending_game_state()) : GAME_SAVE_NO_RESULT);
+	append_u8(out, static_cast<unsigned>(tag_count));
+	append_u16(out, static_cast<unsigned>(ply_count));
+	if (custom_start) {
+		append_u8(out, fen_len);
+		out.append(fen, fen_len);
+	}
+	for (size_t i = 0; i < tag_count; i++) {
+		const size_t name_len = tags[i].name.size();
+		const size_t value_len = tags[i].value.size();
+		append_u8(out, static_cast<unsigned>(name_len));
+		out.append(tags[i].name.data(), name_len);
+		append_u16(out, static_cast<unsigned>(value_len));
+		out.append(tags[i].value.data(), value_len);
+	}
+	for (size_t i = 0; i < ply_count; i++) {
+		append_u16(out, gm_to_gmi(moves[i]).get_data());
+	}
+	return true;
+}
+
+bool read_game_binary(std::string_view data, GameRecord& record, size_t* consumed)
+{
+	size_t pos = 0;
+	if (data.substr(0, 4) != GAME_SAVE_MAGIC) return false;
+	pos += 4;
+
+	unsigned version, flags, result, tag_count, ply_count;
+	if (!read_u8(data, pos, version) || version != GAME_SAVE_VERSION) return false;
+	if (!read_u8(data, pos, flags)) return false;
+	if (!read_u8(data, pos, result)) return false;
+	if (!read_u8(data, pos, tag_count)) return false;
+	if (!read_u16(data, pos, ply_count)) return false;
+
+	record.start_fen.clear();
+	if (flags & GAME_SAVE_FLAG_FEN) {
+		unsigned fen_len;
+		if (!read_u8(data, pos, fen_len) || !read_bytes(data, pos, fen_len, record.start_fen)) return false;
+	}
+
+	record.has_result = result != GAME_SAVE_NO_RESULT;
+	if (record.has_result) {
+		if (!is_valid_end_state(result)) return false;
+		record.result = static_cast<GameEndState>(result);
+	}
+
+	record.tags.resize(tag_count);
+	for (GameTag& tag : record.tags) {
+		unsigned name_len, value_len;
+		if (!read_u8(data, pos, name_len) || !read_bytes(data, pos, name_len, tag.name)) return false;
+		if (!read_u16(data, pos, value_len) || !read_bytes(data, pos, value_len, tag.value)) return false;
+	}
+
+	record.moves.clear();
+	record.moves.reserve(ply_count);
+	for (unsigned i = 0; i < ply_count; i++) {
+		unsigned move;
+		if (!read_u16(data, pos, move)) return false;
+		record.moves.push_back(gmi_to_gm(GameMoveInt(static_cast<uint16_t>(move))));
+	}
+
+	if (consumed) *consumed = pos;
+	return true;
+}
+
+bool load_game_record(const GameRecord& record, IGame& game)
+{
+	game.new_game(record.start_fen);
+	if (!game.get_init_ok()) return false;
+	for (const GameMove& move : record.moves) {
+		if (game.move(move) == GameState::INVALID_MOVE) return false;
+	}
+	// endings that are not decided on the board (forfeit, time, draw offer)
+	if (record.has_result && !game.get_game_has_ended()) game.set_ending_game_state(record.result);
+	return true;
+}
+
+const char* game_result_to_string(const IGame& game)
+{
+	if (!game.get_game_has_ended()) return "*";
+	const int state = static_cast<int>(game.get_ending_game_state());
+	if (state < static_cast<int>(GameEndState::BLACK_WIN_CM)) return "1-0";
+	if (state < static_cast<int>(GameEndState::END_DRAW_STALEMATE)) return "0-1";
+	return "1/2-1/2";
+}
+
+static void append_pgn_tag(std::string& out, std::string_view name, std::string_view value)
+{
+	out += '[';
+	out += name;
+	out += " \"";
+	for (const char c : value) {
+		if (c == '"' || c == '\\') out += '\\';
+		out += c;
+	}
+	out += "\"]\n";
+}
+
+std::string write_game_pgn(const IGame& game, const std::vector<GameTag>& tags)
+{
+	const char* result = game_result_to_string(game);
+	std::string pgn;
+
+	// seven tag roster first, user values replace the defaults
+	for (const char* name : { "Event", "Site", "Date", "Round", "White", "Black" }) {
+		auto it = std::find_if(tags.begin(), tags.end(), [name](const GameTag& tag) { return tag.name == name; });
+		append_pgn_tag(pgn, name, it == tags.end() ? "?" : it->value);
+	}
+	append_pgn_tag(pgn, "Result", result);
+
+	char fen[GAME_FEN_LEN_MAX];
+	game.get_start_fen(fen, GAME_FEN_LEN_MAX);
+	if (!is_default_start(fen)) {
+		append_pgn_tag(pgn, "SetUp", "1");
+		append_pgn_tag(pgn, "FEN", fen);
+	}
+	for (const GameTag& tag : tags) {
+		const bool is_roster = tag.name == "Event" || tag.name == "Site" || tag.name == "Date" || tag.name == "Round" ||
+			tag.name == "White" || tag.name == "Black" || tag.name == "Result" || tag.name == "SetUp" || tag.name == "FEN";
+		if (!is_roster) append_pgn_tag(pgn, tag.name, tag.value);
+	}
+	pgn += '\n';
+
+	// movetext: each ply needs at most turn number, dots, move and a separator
+	const std::vector<GameMove> moves = game.get_all_moves();
+	std::string movetext(moves.size() * (GAME_MOVE_STR_LEN_MAX + 8) + 16, '\0');
+	const int movetext_len = game.to_movetext(movetext.data(), static_cast<int>(movetext.size()), GameMoveStrFmt::SAN);
+	movetext.resize(movetext_len);
+	if (!movetext.empty()) movetext += ' ';
+	movetext += result;
+
+	// wrap lines at spaces
+	size_t line_begin = 0;
+	while (movetext.size() - line_begin >= GAME_PGN_LINE_MAX) {
+		const size_t space = movetext.rfind(' ', line_begin + GAME_PGN_LINE_MAX - 1);
+		if (space == std::string::npos || space <= line_begin) break;
+		movetext[space] = '\n';
+		line_begin = space + 1;
+	}
+	pgn += movetext;
+	pgn += '\n';
+	return pgn;
+}
+
+bool load_game_pgn(std::string_view pgn, IGame& game)
+{
+	PgnReader reader(pgn);
+	PgnGame pgn_game;
+	if (!reader.next(pgn_game)) return false;
+
+	game.new_game(pgn_game.get_tag("FEN"));
+	if (!game.get_init_ok()) return false;
+	PgnMoveTokenizer tokenizer(pgn_game.movetext);
+	std::string_view san;
+	while (tokenizer.next(san)) {
+		if (game.move(san, GameMoveStrFmt::SAN) == GameState::INVALID_MOVE) return false;
+	}
+	return true;
+}
+
+
+GameSaveWriter::GameSaveWriter() :
+	m_mutex(), m_job_cv(), m_idle_cv(), m_jobs(), m_results(), m_busy(false), m_stop(false), m_thread()
+{
+	m_thread = std::thread(&GameSaveWriter::run, this);
+}
+
+GameSaveWriter::~GameSaveWriter()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stop = true;
+	}
+	m_job_cv.notify_one();
+	m_thread.join();
+}
+
+void GameSaveWriter::save(std::string path, std::string data)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_jobs.push_back(Job{ std::move(path), std::move(data) });
+	}
+	m_job_cv.notify_one();
+}
+
+void GameSaveWriter::flush()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_idle_cv.wait(lock, [this]() { return m_jobs.empty() && !m_busy; });
+}
+
+std::vector<GameSaveResult> GameSaveWriter::take_results()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	std::vector<GameSaveResult> results;
+	results.swap(m_results);
+	return results;
+}
+
+void GameSaveWriter::run()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	while (true) {
+		m_job_cv.wait(lock, [this]() { return m_stop || !m_jobs.empty(); });
+		if (m_jobs.empty()) return; // stopped and nothing left to write
+
+		Job job = std::move(m_jobs.front());
+		m_jobs.pop_front();
+		m_busy = true;
+		lock.unlock();
+
+		std::ofstream file(job.path, std::ios::binary | std::ios::trunc);
+		bool ok = file.is_open();
+		if (ok) {
+			file.write(job.data.data(), static_cast<std::streamsize>(job.data.size()));
+			file.close();
+			ok = !file.fail();
+		}
+
+		lock.lock();
+		m_busy = false;
+		m_results.push_back(GameSaveResult{ std::move(job.path), ok });
+		if (m_jobs.empty()) m_idle_cv.notify_all();
+	}
+}
@@ -0,0 +1,60 @@
+#include "GameStats.h"
+
+#ifdef GAME_ENABLE_STATS
+#if defined(_MSC_VER)
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#else
+#include <chrono>
+#endif
+#endif
+
+
+const char* game_stat_name(GameStatId id)
+{
+	switch (id) {
+	case GameStatId::FIND_LEGAL_MOVES: return "find_legal_moves";
+	case GameStatId::FIND_PINNED_PIECES: return "find_pinned_pieces";
+	case GameStatId::UPDATE_COVERAGE: return "update_coverage";
+	case GameStatId::APPLY_GAMEDELTA: return "apply_gamedelta";
+	case GameStatId::UNDO_GAMEDELTA: return "undo_gamedelta";
+	default: return "unknown";
+	}
+}
+
+#ifdef GAME_ENABLE_STATS
+GameStats& game_stats_local()
+{
+	thread_local GameStats stats;
+	return stats;
+}
+
+uint64_t game_stat_timestamp()
+{
+#if defined(_MSC_VER) || defined(__x86_64__) || defined(__i386__)
+	return __rdtsc();
+#else
+	return static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+}
+
+GameStats get_game_stats()
+{
+	return game_stats_local();
+}
+
+void reset_game_stats()
+{
+	game_stats_local() = GameStats();
+}
+#else
+GameStats get_game_stats()
+{
+	return GameStats();
+}
+
+void reset_game_stats()
+{
+}
+#endif
@@ -0,0 +1,134 @@
+#include "GameTree.h"
+
+
+GameTree::GameTree(Game& game) :
+	m_game(game),
+	m_nodes(),
+	m_path(),
+	m_current(0)
+{
+	reset();
+}
+
+void GameTree::reset()
+{
+	m_nodes.clear();
+	m_nodes.emplace_back();
+	m_current = 0;
+}
+
+/// <summary>
+/// existing children are entered without validating the move again,
+/// new moves are validated and executed by Game::move and the resulting delta is stored.
+/// </summary>
+uint32_t GameTree::play(const GameMove& move)
+{
+	const uint32_t child = find_child(m_current, move);
+	if (child != GAME_TREE_NO_NODE) {
+		go_to(child);
+		return child;
+	}
+
+	// keeps the undone moves of the game from turning up in the new variation
+	m_game.discard_redo();
+	if (m_game.move(move) == GameState::INVALID_MOVE) return GAME_TREE_NO_NODE;
+	m_current = add_child(m_current, m_game.m_gamedelta_list.back());
+	return m_current;
+}
+
+uint32_t GameTree::play(std::string_view move, GameMoveStrFmt fmt)
+{
+	return play(m_game.string_to_gamemove(move, fmt));
+}
+
+bool GameTree::go_to(uint32_t node)
+{
+	if (node >= m_nodes.size()) return false;
+	if (node == m_current) return true;
+
+	const uint32_t ancestor = common_ancestor(m_current, node);
+	for (uint32_t n = m_current; n != ancestor; n = m_nodes[n].parent) m_game.pop_delta();
+	m_game.discard_redo();
+
+	m_path.clear();
+	for (uint32_t n = node; n != ancestor; n = m_nodes[n].parent) m_path.push_back(n);
+	for (auto it = m_path.rbegin(); it != m_path.rend(); ++it) m_game.push_delta(m_nodes[*it].delta);
+
+	m_game.update_legal_moves();
+	m_current = node;
+	return true;
+}
+
+void GameTree::promote(uint32_t node)
+{
+	if (node == 0 || node >= m_nodes.size()) return;
+	GameTreeNode& parent = m_nodes[m_nodes[node].parent];
+	if (parent.first_child == node) return;
+
+	uint32_t prev = parent.first_child;
+	while (m_nodes[prev].next_sibling != node) prev = m_nodes[prev].next_sibling;
+	m_nodes[prev].next_sibling = m_nodes[node].next_sibling;
+	m_nodes[node].next_sibling = parent.first_child;
+	parent.first_child = node;
+}
+
+uint32_t GameTree::get_root() const
+{
+	return 0;
+}
+
+uint32_t GameTree::get_current() const
+{
+	return m_current;
+}
+
+const GameTreeNode& GameTree::get_node(uint32_t node) const
+{
+	return m_nodes[node];
+}
+
+GameMove GameTree::get_move(uint32_t node) const
+{
+	return m_nodes[node].delta.move;
+}
+
+uint32_t GameTree::find_child(uint32_t node, const GameMove& move) const
+{
+	for (uint32_t c = m_nodes[node].first_child; c != GAME_TREE_NO_NODE; c = m_nodes[c].next_sibling) {
+		if (m_nodes[c].delta.move == move) return c;
+	}
+	return GAME_TREE_NO_NODE;
+}
+
+int GameTree::size() const
+{
+	return static_cast<int>(m_nodes.size());
+}
+
+/// <summary>
+/// appends gd as the last variation of parent
+/// </summary>
+uint32_t GameTree::add_child(uint32_t parent, const GameDelta& gd)
+{
+	const uint32_t node = static_cast<uint32_t>(m_nodes.size());
+	GameTreeNode& n = m_nodes.emplace_back();
+	n.delta = gd;
+	n.parent = parent;
+	n.depth = m_nodes[parent].depth + 1;
+
+	uint32_t* link = &m_nodes[parent].first_child;
+	while (*link != GAME_TREE_NO_NODE) link = &m_nodes[*link].next_sibling;
+	*link = node;
+	return node;
+}
+
+uint32_t GameTree::common_ancestor(uint32_t a, uint32_t b) const
+{
+	while (m_nodes[a].depth > m_nodes[b].depth) a = m_nodes[a].parent;
+	while (m_nodes[b].depth > m_nodes[a].depth) b = m_nodes[b].parent;
+	while (a != b) {
+		a = m_nodes[a].parent;
+		b = m_nodes[b].parent;
+	}
+	return a;
+}
@@ -1,5 +1,9 @@
 #include "GameUtils.h"
-#include "GameUtils.h"
+#include "GameStats.h"
+#include "Nnue.h"
+
+#include <bit>
+#include <cstring>
 
 #define GAME_DELTA_DIR_N GAME_WIDTH
 #define GAME_DELTA_DIR_E 1
@@ -344,11 +348,6 @@ void GameMoveInt::set_promotion(Piece promo)
 	}
 }
 
-void GameMoveInt::set_null()
-{
-	m_data = 0;
-}
-
 
 GameMoveInt gm_to_gmi(const GameMove& m)
 {
@@ -455,15 +454,65 @@ bool operator==(const GameDelta& lhs, const GameDelta& rhs)
 }
 
 
-ChessBoard::ChessBoard() : m_coverage_delta_indices(), m_bindex_to_id{}, m_bindex_to_piece{}, m_id_to_bindex{}, m_id_to_piece{}, m_coverage{}
+ChessBoard::ChessBoard() : m_coverage_delta_indices(), m_bindex_to_id{}, m_bindex_to_piece{}, m_id_to_bindex{}, m_id_to_piece{}, m_coverage{}, m_hash(0), m_accumulator(nullptr), m_coverage_mode(CoverageMode::INCREMENTAL)
 {
 	init_from_fen("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR");
 }
 
-bool ChessBoard::new_board(const std::string& fen_board_section)
+ChessBoard::ChessBoard(const ChessBoard& other) :
+	m_coverage_delta_indices(other.m_coverage_delta_indices),
+	m_bindex_to_id(other.m_bindex_to_id),
+	m_bindex_to_piece(other.m_bindex_to_piece),
+	m_id_to_bindex(other.m_id_to_bindex),
+	m_id_to_piece(other.m_id_to_piece),
+	m_coverage(other.m_coverage),
+	m_hash(other.m_hash),
+	m_accumulator(nullptr),
+	m_coverage_mode(other.m_coverage_mode)
+{
+}
+
+ChessBoard& ChessBoard::operator=(const ChessBoard& other)
+{
+	if (this == &other) return *this;
+	m_coverage_delta_indices = other.m_coverage_delta_indices;
+	m_bindex_to_id = other.m_bindex_to_id;
+	m_bindex_to_piece = other.m_bindex_to_piece;
+	m_id_to_bindex = other.m_id_to_bindex;
+	m_id_to_piece = other.m_id_to_piece;
+	m_coverage = other.m_coverage;
+	m_hash = other.m_hash;
+	m_coverage_mode = other.m_coverage_mode;
+	if (m_accumulator) m_accumulator->refresh(*this);
+	return *this;
+}
+
+FenResult ChessBoard::new_board(std::string_view fen)
 {
 	clear();
-	return init_from_fen(fen_board_section);
+	return init_from_fen(fen);
+}
+
+int ChessBoard::to_fen_board(char* buffer) const
+{
+	int n = 0;
+	for (int y = GAME_HEIGHT - 1; y >= 0; y--) {
+		int empty_count = 0;
+		for (int x = 0; x < GAME_WIDTH; x++) {
+			const UniquePiece up = get_up(position_to_bindex({ x, y }));
+			if (up.IsEmpty()) {
+				empty_count++;
+				continue;
+			}
+			if (empty_count) buffer[n++] = char('0' + empty_count);
+			empty_count = 0;
+			const char c = piece_to_char(up.p);
+			buffer[n++] = up.IsWhite() ? char(std::toupper(c)) : c;
+		}
+		if (empty_count) buffer[n++] = char('0' + empty_count);
+		if (y > 0) buffer[n++] = '/';
+	}
+	return n;
 }
 
 void ChessBoard::register_up(int bindex, int id, Piece p)
@@ -476,8 +525,11 @@ void ChessBoard::register_up(int bindex, int id, Piece p)
 
 void ChessBoard::apply_gamedelta(const GameDelta& gd)
 {
+	GAME_STAT_SCOPE(GameStatId::APPLY_GAMEDELTA);
 	const UniquePiece up_from = get_up(gd.move.from);
 	const UniquePiece up_to = get_up(gd.move.to);
+	const bool incremental = m_coverage_mode == CoverageMode::INCREMENTAL;
+	toggle_hash_delta(gd);
 
 	//normal case
 	//set from bindex empty
@@ -492,9 +544,11 @@ void ChessBoard::apply_gamedelta(const GameDelta& gd)
 	m_id_to_bindex[up_from.id] = gd.move.to;
 
 	//push coverage edit
-	m_coverage_delta_indices.push_back(gd.move.from);
-	m_coverage_delta_indices.push_back(gd.move.to);
-	set_coverage_single(up_from.id, gd.move.from, true); //flag from id
+	if (incremental) {
+		m_coverage_delta_indices.push_back(gd.move.from);
+		m_coverage_delta_indices.push_back(gd.move.to);
+		set_coverage_single(up_from.id, gd.move.from, true); //flag from id
+	}
 
 	//check for castle move
 	if (gd.IsCastle()) {
@@ -510,9 +564,11 @@ void ChessBoard::apply_gamedelta(const GameDelta& gd)
 
 		m_id_to_bindex[rook_id] = king_adjacent_bindex;
 
-		m_coverage_delta_indices.push_back(rook_bindex);
-		m_coverage_delta_indices.push_back(king_adjacent_bindex);
-		set_coverage_single(rook_id, rook_bindex, true); //flag rook id
+		if (incremental) {
+			m_coverage_delta_indices.push_back(rook_bindex);
+			m_coverage_delta_indices.push_back(king_adjacent_bindex);
+			set_coverage_single(rook_id, rook_bindex, true); //flag rook id
+		}
 	}
 
 	//check for promotion
@@ -527,23 +583,30 @@ void ChessBoard::apply_gamedelta(const GameDelta& gd)
 		m_id_to_piece[gd.takes.id] = Piece::EMPTY;
 		m_id_to_bindex[gd.takes.id] = 0;
 
-		reset_coverage(gd.takes.id);
+		if (incremental) reset_coverage(gd.takes.id);
 	}
 
 	if (gd.IsEnPassant()) {
 		m_bindex_to_id[gd.p2_index] = 0;
 		m_bindex_to_piece[gd.p2_index] = Piece::EMPTY;
-		m_coverage_delta_indices.push_back(gd.p2_index);
+		if (incremental) m_coverage_delta_indices.push_back(gd.p2_index);
 	}
 
-	update_coverage();
-	m_coverage_delta_indices.clear();
+	toggle_hash_delta(gd);
+	if (incremental) {
+		update_coverage();
+		m_coverage_delta_indices.clear();
+	}
+	if (m_accumulator) m_accumulator->push(*this, gd);
 	return;
 }
 
 void ChessBoard::undo_gamedelta(const GameDelta& gd)
 {
+	GAME_STAT_SCOPE(GameStatId::UNDO_GAMEDELTA);
 	const UniquePiece up_board_to = get_up(gd.move.to);
+	const bool incremental = m_coverage_mode == CoverageMode::INCREMENTAL;
+	toggle_hash_delta(gd);
 
 	m_bindex_to_id[gd.move.from] = up_board_to.id;
 	m_bindex_to_piece[gd.move.from] = up_board_to.p;
@@ -552,9 +615,11 @@ void ChessBoard::undo_gamedelta(const GameDelta& gd)
 	m_bindex_to_id[gd.move.to] = 0;
 	m_bindex_to_piece[gd.move.to] = Piece::EMPTY;
 
-	m_coverage_delta_indices.push_back(gd.move.from);
-	m_coverage_delta_indices.push_back(gd.move.to);
-	set_coverage_single(up_board_to.id, gd.move.from, true);
+	if (incremental) {
+		m_coverage_delta_indices.push_back(gd.move.from);
+		m_coverage_delta_indices.push_back(gd.move.to);
+		set_coverage_single(up_board_to.id, gd.move.from, true);
+	}
 
 	//check for castle move
 	if (gd.IsCastle()) {
@@ -570,9 +635,11 @@ void ChessBoard::undo_gamedelta(const GameDelta& gd)
 
 		m_id_to_bindex[rook_id] = corner_bindex;
 
-		m_coverage_delta_indices.push_back(corner_bindex);
-		m_coverage_delta_indices.push_back(king_adjacent_bindex);
-		set_coverage_single(rook_id, corner_bindex, true);
+		if (incremental) {
+			m_coverage_delta_indices.push_back(corner_bindex);
+			m_coverage_delta_indices.push_back(king_adjacent_bindex);
+			set_coverage_single(rook_id, corner_bindex, true);
+		}
 	}
 
 	//undo promotion
@@ -588,7 +655,7 @@ void ChessBoard::undo_gamedelta(const GameDelta& gd)
 		m_id_to_piece[gd.takes.id] = gd.takes.p;
 		m_id_to_bindex[gd.takes.id] = gd.move.to;
 
-		set_coverage_single(gd.takes.id, gd.move.to, true);
+		if (incremental) set_coverage_single(gd.takes.id, gd.move.to, true);
 	}
 
 	if (gd.IsEnPassant()) {
@@ -597,15 +664,45 @@ void ChessBoard::undo_gamedelta(const GameDelta& gd)
 		m_id_to_piece[gd.takes.id] = gd.takes.p;
 		m_id_to_bindex[gd.takes.id] = gd.p2_index;
 
-		set_coverage_single(gd.takes.id, gd.p2_index, true);
-		m_coverage_delta_indices.push_back(gd.p2_index);
+		if (incremental) {
+			set_coverage_single(gd.takes.id, gd.p2_index, true);
+			m_coverage_delta_indices.push_back(gd.p2_index);
+		}
 	}
 
-	update_coverage();
-	m_coverage_delta_indices.clear();
+	toggle_hash_delta(gd);
+	if (incremental) {
+		update_coverage();
+		m_coverage_delta_indices.clear();
+	}
+	if (m_accumulator) m_accumulator->pop(*this);
 	return;
 }
 
+BoardPlacement ChessBoard::get_placement() const
+{
+	BoardPlacement placement;
+	for (int id = 0; id < GAME_MAX_ID; id++) {
+		placement.id_to_bindex[id] = static_cast<uint8_t>(m_id_to_bindex[id]);
+		placement.id_to_piece[id] = static_cast<uint8_t>(m_id_to_piece[id]);
+	}
+	return placement;
+}
+
+/// <summary>
+/// replaces the board with placement. Ids are kept so that game-deltas recorded after the placement stay valid.
+/// </summary>
+void ChessBoard::set_placement(const BoardPlacement& placement)
+{
+	clear();
+	for (int id = 0; id < GAME_MAX_ID; id++) {
+		const Piece p = static_cast<Piece>(placement.id_to_piece[id]);
+		if (p == Piece::EMPTY) continue;
+		register_up(placement.id_to_bindex[id], id, p);
+	}
+	init_incremental();
+}
+
 int ChessBoard::get_bindex(int id) const
 {
 	return m_id_to_bindex[id];
@@ -638,6 +735,7 @@ bool ChessBoard::empty(int bindex)
 
 bool ChessBoard::is_covered(int index) const
 {
+	if (m_coverage_mode == CoverageMode::ON_DEMAND) return is_covered_color(index, 0) || is_covered_color(index, GAME_MAX_COLOR_ID);
 	for (const std::array<bool, GAME_BOARD_SIZE>& idboard : m_coverage) {
 		if (idboard[index]) return true;
 	}
@@ -646,6 +744,7 @@ bool ChessBoard::is_covered(int index) const
 
 bool ChessBoard::is_covered_color(int index, int color_off) const
 {
+	if (m_coverage_mode == CoverageMode::ON_DEMAND) return find_attackers_color(index, color_off) != 0;
 	const int id_end = color_off + GAME_MAX_COLOR_ID;
 	for (int id = color_off; id < id_end; id++) {
 		if (m_coverage[id][index]) return true;
@@ -655,6 +754,7 @@ bool ChessBoard::is_covered_color(int index, int color_off) const
 
 int ChessBoard::get_cover_count(int index) const
 {
+	if (m_coverage_mode == CoverageMode::ON_DEMAND) return get_cover_count_color(index, 0) + get_cover_count_color(index, GAME_MAX_COLOR_ID);
 	int cnt = 0;
 	for (const std::array<bool, GAME_BOARD_SIZE>& idboard : m_coverage) {
 		if (idboard[index]) cnt++;
@@ -664,6 +764,7 @@ int ChessBoard::get_cover_count(int index) const
 
 int ChessBoard::get_cover_count_color(int index, int color_off) const
 {
+	if (m_coverage_mode == CoverageMode::ON_DEMAND) return std::popcount(find_attackers_color(index, color_off));
 	const int id_end = color_off + GAME_MAX_COLOR_ID;
 	int cnt = 0;
 	for (int id = color_off; id < id_end; id++) {
@@ -674,6 +775,10 @@ int ChessBoard::get_cover_count_color(int index, int color_off) const
 
 int ChessBoard::get_first_cover_id(int index) const
 {
+	if (m_coverage_mode == CoverageMode::ON_DEMAND) {
+		const int white_id = get_first_cover_id_color(index, 0);
+		return white_id != -1 ? white_id : get_first_cover_id_color(index, GAME_MAX_COLOR_ID);
+	}
 	for (int id = 0; id < GAME_MAX_ID; id++) {
 		if (m_coverage[id][index]) return id;
 	}
@@ -682,6 +787,10 @@ int ChessBoard::get_first_cover_id(int index) const
 
 int ChessBoard::get_first_cover_id_color(int index, int color_off) const
 {
+	if (m_coverage_mode == CoverageMode::ON_DEMAND) {
+		const uint32_t attackers = find_attackers_color(index, color_off);
+		return attackers ? std::countr_zero(attackers) : -1;
+	}
 	const int id_end = color_off + GAME_MAX_COLOR_ID;
 	for (int id = color_off; id < id_end; id++) {
 		if (m_coverage[id][index]) return id;
@@ -689,78 +798,259 @@ int ChessBoard::get_first_cover_id_color(int index, int color_off) const
 	return -1;
 }
 
+uint32_t ChessBoard::get_cover_ids(int index) const
+{
+	if (m_coverage_mode == CoverageMode::ON_DEMAND) return find_attackers_color(index, 0) | find_attackers_color(index, GAME_MAX_COLOR_ID);
+	uint32_t ids = 0;
+	for (int id = 0; id < GAME_MAX_ID; id++) ids |= uint32_t(m_coverage[id][index]) << id;
+	return ids;
+}
+
+void ChessBoard::set_coverage_mode(CoverageMode mode)
+{
+	if (mode == m_coverage_mode) return;
+	m_coverage_mode = mode;
+	for (std::array<bool, GAME_BOARD_SIZE>& id_coverage : m_coverage) id_coverage.fill(false);
+	if (m_coverage_mode == CoverageMode::INCREMENTAL) init_coverage();
+}
+
+CoverageMode ChessBoard::get_coverage_mode() const
+{
+	return m_coverage_mode;
+}
+
+/// <summary>
+/// squares from which a piece covers a square. Leapers and pawns as masks, sliders as the squares of each ray
+/// </summary>
+struct AttackTables {
+	std::array<uint64_t, GAME_BOARD_SIZE> knight;
+	std::array<uint64_t, GAME_BOARD_SIZE> king;
+	// [0] white pawns, [1] black pawns covering the square
+	std::array<std::array<uint64_t, GAME_BOARD_SIZE>, 2> pawn;
+	// rays in Direction N..NW (index dir - 1), nearest square first
+	std::array<std::array<std::array<int8_t, GAME_WIDTH - 1>, 8>, GAME_BOARD_SIZE> rays;
+	std::array<std::array<int8_t, 8>, GAME_BOARD_SIZE> ray_length;
+};
+
+static constexpr AttackTables make_attack_tables()
+{
+	constexpr int ray_dx[8] = { 0, 1, 0, -1, 1, 1, -1, -1 };
+	constexpr int ray_dy[8] = { 1, 0, -1, 0, 1, -1, -1, 1 };
+	constexpr int knight_dx[8] = { 1, 2, 2, 1, -1, -2, -2, -1 };
+	constexpr int knight_dy[8] = { 2, 1, -1, -2, -2, -1, 1, 2 };
+	const auto on_board = [](int x, int y) { return x >= 0 && x < GAME_WIDTH && y >= 0 && y < GAME_HEIGHT; };
+
+	AttackTables tables{};
+	for (int bindex = 0; bindex < GAME_BOARD_SIZE; bindex++) {
+		const int x = bindex % GAME_WIDTH;
+		const int y = bindex / GAME_WIDTH;
+		for (int i = 0; i < 8; i++) {
+			if (on_board(x + knight_dx[i], y + knight_dy[i])) tables.knight[bindex] |= uint64_t(1) << ((y + knight_dy[i]) * GAME_WIDTH + x + knight_dx[i]);
+			if (on_board(x + ray_dx[i], y + ray_dy[i])) tables.king[bindex] |= uint64_t(1) << ((y + ray_dy[i]) * GAME_WIDTH + x + ray_dx[i]);
+			int n = 0;
+			for (int tx = x + ray_dx[i], ty = y + ray_dy[i]; on_board(tx, ty); tx += ray_dx[i], ty += ray_dy[i]) {
+				tables.rays[bindex][i][n++] = static_cast<int8_t>(ty * GAME_WIDTH + tx);
+			}
+			tables.ray_length[bindex][i] = static_cast<int8_t>(n);
+		}
+		// a white pawn covers the squares diagonally in front of it, so it stands diagonally below
+		for (const int dx : { -1, 1 }) {
+			if (on_board(x + dx, y - 1)) tables.pawn[0][bindex] |= uint64_t(1) << ((y - 1) * GAME_WIDTH + x + dx);
+			if (on_board(x + dx, y + 1)) tables.pawn[1][bindex] |= uint64_t(1) << ((y + 1) * GAME_WIDTH + x + dx);
+		}
+	}
+	return tables;
+}
+
+static constexpr AttackTables ATTACK_TABLES = make_attack_tables();
+
+/// <summary>
+/// same result as reading m_coverage: sliders see through the king of the other color, leapers and pawns
+/// cover their squares whatever the occupancy.
+/// </summary>
+uint32_t ChessBoard::find_attackers_color(int index, int color_off) const
+{
+	const auto is_color = [color_off](int id) { return unsigned(id - color_off) < unsigned(GAME_MAX_COLOR_ID); };
+	uint32_t attackers = 0;
+	const auto add_leapers = [&](uint64_t from_mask, Piece p) {
+		for (; from_mask; from_mask &= from_mask - 1) {
+			const int from = std::countr_zero(from_mask);
+			if (m_bindex_to_piece[from] == p && is_color(m_bindex_to_id[from])) attackers |= uint32_t(1) << m_bindex_to_id[from];
+		}
+	};
+	add_leapers(ATTACK_TABLES.knight[index], Piece::KNIGHT);
+	add_leapers(ATTACK_TABLES.king[index], Piece::KING);
+	add_leapers(ATTACK_TABLES.pawn[color_off == 0 ? 0 : 1][index], Piece::PAWN);
+
+	const int transparent_king_id = color_off == 0 ? GAME_MAX_COLOR_ID : 0;
+	for (int ray = 0; ray < 8; ray++) {
+		const Piece slider = ray < 4 ? Piece::ROOK : Piece::BISHOP;
+		const std::array<int8_t, GAME_WIDTH - 1>& squares = ATTACK_TABLES.rays[index][ray];
+		for (int n = 0; n < ATTACK_TABLES.ray_length[index][ray]; n++) {
+			const Piece p = m_bindex_to_piece[squares[n]];
+			if (p == Piece::EMPTY) continue;
+			const int id = m_bindex_to_id[squares[n]];
+			if (p == Piece::KING && id == transparent_king_id) continue;
+			if ((p == slider || p == Piece::QUEEN) && is_color(id)) attackers |= uint32_t(1) << id;
+			break;
+		}
+	}
+	return attackers;
+}
+
 /// <summary>
 /// registers pieces on the board according to board section of a fen string.
+/// Parsing stops at the first space or at the end of the string.
 /// checks if the following criteria are met:
+///		- every rank has GAME_WIDTH files and there are GAME_HEIGHT ranks
 ///		- all pieces in fen can be registered (max 16 per color)
 ///		- there is only one king per team
 /// </summary>
-/// <param name="fen_board_section"></param>
+/// <param name="fen">fen string starting with the board section</param>
 /// <returns>
-/// true if board section was valid else false
+/// FenResult with the offset of the first char after the board section, or of the offending char
 /// </returns>
-bool ChessBoard::init_from_fen(const std::string& fen_board_section)
+FenResult ChessBoard::init_from_fen(std::string_view fen)
 {
-	int parse_section = 1;
 	int x = 0;
 	int y = GAME_HEIGHT - 1;
-	int digit_stack = 0;
 	int white_id = 1;
 	int black_id = GAME_MAX_COLOR_ID + 1;
 	bool last_was_digit = false;
-	bool received_rank = false;
-	int white_king_count = 0;
-	int black_king_count = 0;
-	for (const char c : fen_board_section) {
-		if (isdigit(c)) {
-			if (last_was_digit || c == '9') return false;
+	int i = 0;
+	const int fen_size = static_cast<int>(fen.size());
+	for (; i < fen_size && fen[i] != ' '; i++) {
+		const char c = fen[i];
+		if (c >= '1' && c <= '8') {
+			if (last_was_digit) return { FenError::BOARD_INVALID_CHAR, i };
 			last_was_digit = true;
 			x += int(c - '0');
-			if (x > GAME_WIDTH) return false;
+			if (x > GAME_WIDTH) return { FenError::BOARD_RANK_SIZE, i };
 		}
 		else if (c == '/') {
+			if (x != GAME_WIDTH) return { FenError::BOARD_RANK_SIZE, i };
+			if (y == 0) return { FenError::BOARD_RANK_COUNT, i };
 			x = 0;
 			y -= 1;
 			last_was_digit = false;
 		}
 		else {
-			if (x > GAME_WIDTH - 1) return false;
-			if (y < 0) return false;
-			Piece p = char_to_piece(c);
-			if (p==Piece::EMPTY) return false;
-			bool is_white = isupper(c);
-			int index = position_to_bindex({ x, y });
-			if (p == Piece::KING) {
-				if (is_white) {
-					register_up(index, 0, Piece::KING);
-					white_king_count++;
-				}
-				else {
-					register_up(index, GAME_MAX_COLOR_ID, Piece::KING);
-					black_king_count++;
-				}
-			}
-			else {
-				if (is_white) {
-					if (white_id >= GAME_MAX_COLOR_ID) return false;
-					register_up(index, white_id, p);
-					white_id++;
-				}
-
-				else {
-					if (black_id >= GAME_MAX_ID) return false;
-					register_up(index, black_id, p);
-					black_id++;
-				}
-			}
+			const Piece p = char_to_piece(c);
+			if (p == Piece::EMPTY) return { FenError::BOARD_INVALID_CHAR, i };
+			if (x > GAME_WIDTH - 1) return { FenError::BOARD_RANK_SIZE, i };
+			const bool is_white = c >= 'A' && c <= 'Z';
+			const FenError error = register_next(position_to_bindex({ x, y }), p, is_white, white_id, black_id);
+			if (error != FenError::NONE) return { error, i };
 			x += 1;
 			last_was_digit = false;
 		}
 	}
-	if (white_king_count != 1 || black_king_count != 1) return false;
+	if (x != GAME_WIDTH) return { FenError::BOARD_RANK_SIZE, i };
+	if (y != 0) return { FenError::BOARD_RANK_COUNT, i };
+	if (m_id_to_piece[0] != Piece::KING || m_id_to_piece[GAME_MAX_COLOR_ID] != Piece::KING) return { FenError::BOARD_KING_COUNT, i };
 
-	init_coverage();
-	return true;
+	init_incremental();
+	return { FenError::NONE, i };
+}
+
+FenResult ChessBoard::new_board(const PositionSnapshot& snapshot)
+{
+	clear();
+	int white_id = 1;
+	int black_id = GAME_MAX_COLOR_ID + 1;
+	// same square order as a fen, so that both number the pieces alike
+	for (int y = GAME_HEIGHT - 1; y >= 0; y--) {
+		for (int x = 0; x < GAME_WIDTH; x++) {
+			const int bindex = position_to_bindex({ x, y });
+			const int nibble = (snapshot.board[bindex / 2] >> (4 * (bindex & 1))) & 0xF;
+			if (nibble == 0) continue;
+			const Piece p = static_cast<Piece>(nibble & 7);
+			if (p > Piece::PAWN) return { FenError::BOARD_INVALID_CHAR, bindex };
+			const FenError error = register_next(bindex, p, (nibble & 8) == 0, white_id, black_id);
+			if (error != FenError::NONE) return { error, bindex };
+		}
+	}
+	if (m_id_to_piece[0] != Piece::KING || m_id_to_piece[GAME_MAX_COLOR_ID] != Piece::KING) return { FenError::BOARD_KING_COUNT, GAME_BOARD_SIZE };
+
+	init_incremental();
+	return { FenError::NONE, GAME_BOARD_SIZE };
+}
+
+void ChessBoard::to_snapshot_board(PositionSnapshot& snapshot) const
+{
+	snapshot.board.fill(0);
+	for (int bindex = 0; bindex < GAME_BOARD_SIZE; bindex++) {
+		const Piece p = m_bindex_to_piece[bindex];
+		if (p == Piece::EMPTY) continue;
+		const int nibble = static_cast<int>(p) | (m_bindex_to_id[bindex] < GAME_MAX_COLOR_ID ? 0 : 8);
+		snapshot.board[bindex / 2] |= static_cast<uint8_t>(nibble << (4 * (bindex & 1)));
+	}
+}
+
+FenResult ChessBoard::new_board(const PackedBoard& board)
+{
+	clear();
+	int white_id = 1;
+	int black_id = GAME_MAX_COLOR_ID + 1;
+	if (std::popcount(board.occupancy) > GAME_MAX_ID) return { FenError::BOARD_PIECE_COUNT, GAME_BOARD_SIZE };
+	// same square order as a fen, so that both number the pieces alike
+	for (int y = GAME_HEIGHT - 1; y >= 0; y--) {
+		for (int x = 0; x < GAME_WIDTH; x++) {
+			const int bindex = position_to_bindex({ x, y });
+			const uint64_t square = uint64_t(1) << bindex;
+			if (!(board.occupancy & square)) continue;
+			const int n = std::popcount(board.occupancy & (square - 1));
+			const int nibble = (board.pieces[n / 2] >> (4 * (n & 1))) & 0xF;
+			const Piece p = static_cast<Piece>(nibble & 7);
+			if (p == Piece::EMPTY || p > Piece::PAWN) return { FenError::BOARD_INVALID_CHAR, bindex };
+			const FenError error = register_next(bindex, p, (nibble & 8) == 0, white_id, black_id);
+			if (error != FenError::NONE) return { error, bindex };
+		}
+	}
+	if (m_id_to_piece[0] != Piece::KING || m_id_to_piece[GAME_MAX_COLOR_ID] != Piece::KING) return { FenError::BOARD_KING_COUNT, GAME_BOARD_SIZE };
+
+	init_incremental();
+	return { FenError::NONE, GAME_BOARD_SIZE };
+}
+
+void ChessBoard::to_packed_board(PackedBoard& board) const
+{
+	board.occupancy = 0;
+	board.pieces.fill(0);
+	int n = 0;
+	for (int bindex = 0; bindex < GAME_BOARD_SIZE; bindex++) {
+		const Piece p = m_bindex_to_piece[bindex];
+		if (p == Piece::EMPTY) continue;
+		const int nibble = static_cast<int>(p) | (m_bindex_to_id[bindex] < GAME_MAX_COLOR_ID ? 0 : 8);
+		board.occupancy |= uint64_t(1) << bindex;
+		board.pieces[n / 2] |= static_cast<uint8_t>(nibble << (4 * (n & 1)));
+		n++;
+	}
+}
+
+/// <summary>
+/// registers p on bindex. Kings get the fixed king id of their color, other pieces the next free id.
+/// </summary>
+FenError ChessBoard::register_next(int bindex, Piece p, bool is_white, int& white_id, int& black_id)
+{
+	if (p == Piece::KING) {
+		const int king_id = is_white ? 0 : GAME_MAX_COLOR_ID;
+		if (m_id_to_piece[king_id] != Piece::EMPTY) return FenError::BOARD_KING_COUNT;
+		register_up(bindex, king_id, Piece::KING);
+		return FenError::NONE;
+	}
+	int& id = is_white ? white_id : black_id;
+	if (id >= (is_white ? GAME_MAX_COLOR_ID : GAME_MAX_ID)) return FenError::BOARD_PIECE_COUNT;
+	register_up(bindex, id, p);
+	id++;
+	return FenError::NONE;
+}
+
+void ChessBoard::init_incremental()
+{
+	if (m_coverage_mode == CoverageMode::INCREMENTAL) init_coverage();
+	init_hash();
+	if (m_accumulator) m_accumulator->refresh(*this);
 }
 
 void ChessBoard::init_coverage()
@@ -768,8 +1058,51 @@ void ChessBoard::init_coverage()
 	for (int id = 0; id < GAME_MAX_ID; id++) piece_covers(id);
 }
 
+uint64_t ChessBoard::get_hash() const
+{
+	return m_hash;
+}
+
+void ChessBoard::set_accumulator(NnueAccumulator* accumulator)
+{
+	m_accumulator = accumulator;
+	if (m_accumulator) m_accumulator->refresh(*this);
+}
+
+NnueAccumulator* ChessBoard::get_accumulator() const
+{
+	return m_accumulator;
+}
+
+void ChessBoard::init_hash()
+{
+	m_hash = 0;
+	for (int bindex = 0; bindex < GAME_BOARD_SIZE; bindex++) toggle_hash(bindex);
+}
+
+void ChessBoard::toggle_hash(int bindex)
+{
+	const Piece p = m_bindex_to_piece[bindex];
+	if (p != Piece::EMPTY) m_hash ^= zobrist_piece_key(m_bindex_to_id[bindex] < GAME_MAX_COLOR_ID, p, bindex);
+}
+
+/// <summary>
+/// xors the occupants of all squares touched by gd. Called before and after the board change
+/// </summary>
+void ChessBoard::toggle_hash_delta(const GameDelta& gd)
+{
+	toggle_hash(gd.move.from);
+	toggle_hash(gd.move.to);
+	if (gd.IsCastle()) {
+		toggle_hash(gd.move.from + (gd.IsKSCastle() ? 3 : -4));
+		toggle_hash(gd.move.from + (gd.IsKSCastle() ? 1 : -1));
+	}
+	if (gd.IsEnPassant()) toggle_hash(gd.p2_index);
+}
+
 void ChessBoard::clear()
 {
+	m_hash = 0;
 	m_coverage_delta_indices.clear();
 	m_bindex_to_id.fill(0);
 	m_bindex_to_piece.fill(Piece::EMPTY);
@@ -895,22 +1228,57 @@ void ChessBoard::cover_and_append(const Direction dir, const int id, const int b
 	return;
 }
 
+/// <summary>
+/// recomputes the coverage touched by the squares in m_coverage_delta_indices.
+/// Pieces standing on a changed square were placed there and are recomputed completely. Other sliders covering a
+/// changed square only recompute the ray through it, which is truncated or extended there. Kings, knights and
+/// pawns cover the same squares whatever the occupancy, so they keep their coverage.
+/// </summary>
 void ChessBoard::update_coverage()
 {
-	bool id_needs_update[32]{};
+	GAME_STAT_SCOPE(GameStatId::UPDATE_COVERAGE);
+	uint64_t changed = 0;
+	uint32_t touched = 0; // bit per id covering a changed square
 	for (const int bindex : m_coverage_delta_indices) {
-		for (int id = 0; id < 32; id++) {
-			id_needs_update[id] |= m_coverage[id][bindex];
-		}
+		changed |= uint64_t(1) << bindex;
+		for (int id = 0; id < GAME_MAX_ID; id++) touched |= uint32_t(m_coverage[id][bindex]) << id;
 	}
-	for (int id = 0; id < 32; id++) {
-		if (id_needs_update[id]) {
+	for (; touched; touched &= touched - 1) {
+		const int id = std::countr_zero(touched);
+		const int bindex = m_id_to_bindex[id];
+		const Piece p = m_id_to_piece[id];
+		if (p == Piece::EMPTY) continue;
+		if (changed & (uint64_t(1) << bindex)) {
 			reset_coverage(id);
 			piece_covers(id);
+			GAME_STAT_ADD(coverage_ids_recomputed, 1);
+			continue;
+		}
+		if (p != Piece::QUEEN && p != Piece::ROOK && p != Piece::BISHOP) continue;
+
+		uint32_t rays = 0; // bit per Direction
+		for (const int changed_bindex : m_coverage_delta_indices) {
+			if (m_coverage[id][changed_bindex]) rays |= uint32_t(1) << get_hvd(bindex, changed_bindex);
+		}
+		for (; rays; rays &= rays - 1) {
+			update_ray_coverage(id, static_cast<Direction>(std::countr_zero(rays)));
+			GAME_STAT_ADD(coverage_rays_recomputed, 1);
 		}
 	}
 }
 
+void ChessBoard::update_ray_coverage(int id, Direction dir)
+{
+	const int bindex = m_id_to_bindex[id];
+	const int d = get_bindex_delta(dir);
+	int to_index = bindex;
+	for (int8_t n = GetOOBSteps(bindex, dir); n > 0; n--) {
+		to_index += d;
+		m_coverage[id][to_index] = false;
+	}
+	cover_and_append(dir, id, bindex);
+}
+
 bool operator==(const ChessBoard& lhs, const ChessBoard& rhs)
 {
     if (lhs.m_bindex_to_id != rhs.m_bindex_to_id) return false;
@@ -1008,3 +1376,112 @@ std::string PositionToString(Position pos)
 	return s_ret;
 }
 
+int write_uint(char* buffer, unsigned int value)
+{
+	char digits[10];
+	int n = 0;
+	do {
+		digits[n++] = char('0' + value % 10);
+		value /= 10;
+	} while (value);
+	for (int i = 0; i < n; i++) buffer[i] = digits[n - 1 - i];
+	return n;
+}
+
+
+struct ZobristKeys {
+	std::array<uint64_t, 2 * 6 * GAME_BOARD_SIZE> pieces;
+	std::array<uint64_t, 4> castles;
+	std::array<uint64_t, GAME_WIDTH> en_passant;
+	uint64_t black_to_move;
+};
+
+static constexpr uint64_t splitmix64(uint64_t& state)
+{
+	uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+	return z ^ (z >> 31);
+}
+
+static constexpr ZobristKeys make_zobrist_keys()
+{
+	ZobristKeys keys{};
+	uint64_t state = 0x5A0B1257C4E55ull;
+	for (uint64_t& key : keys.pieces) key = splitmix64(state);
+	for (uint64_t& key : keys.castles) key = splitmix64(state);
+	for (uint64_t& key : keys.en_passant) key = splitmix64(state);
+	keys.black_to_move = splitmix64(state);
+	return keys;
+}
+
+static constexpr ZobristKeys ZOBRIST_KEYS = make_zobrist_keys();
+
+uint64_t zobrist_piece_key(bool white, Piece p, int bindex)
+{
+	const int piece_index = static_cast<int>(p) - 1 + (white ? 0 : 6);
+	return ZOBRIST_KEYS.pieces[piece_index * GAME_BOARD_SIZE + bindex];
+}
+
+uint64_t zobrist_black_to_move_key()
+{
+	return ZOBRIST_KEYS.black_to_move;
+}
+
+uint64_t zobrist_castle_key(int castle)
+{
+	return ZOBRIST_KEYS.castles[castle];
+}
+
+uint64_t zobrist_en_passant_key(int file)
+{
+	return ZOBRIST_KEYS.en_passant[file];
+}
+
+uint64_t packed_hash(const PackedBoard& board)
+{
+	std::array<uint64_t, sizeof(PackedBoard) / sizeof(uint64_t)> words;
+	std::memcpy(words.data(), &board, sizeof(PackedBoard));
+	uint64_t hash = 0;
+	for (const uint64_t word : words) {
+		uint64_t state = hash ^ word;
+		hash = splitmix64(state);
+	}
+	return hash;
+}
+
+PackedBoard pack_snapshot(const PositionSnapshot& snapshot)
+{
+	PackedBoard board{};
+	int n = 0;
+	for (int bindex = 0; bindex < GAME_BOARD_SIZE && n < GAME_MAX_ID; bindex++) {
+		const int nibble = (snapshot.board[bindex / 2] >> (4 * (bindex & 1))) & 0xF;
+		if (nibble == 0) continue;
+		board.occupancy |= uint64_t(1) << bindex;
+		board.pieces[n / 2] |= static_cast<uint8_t>(nibble << (4 * (n & 1)));
+		n++;
+	}
+	board.castles = snapshot.castles;
+	board.p2_index = snapshot.p2_index;
+	board.half_turns = snapshot.half_turns;
+	board.black_to_move = snapshot.black_to_move;
+	board.turn_number = snapshot.turn_number;
+	return board;
+}
+
+PositionSnapshot unpack_snapshot(const PackedBoard& board)
+{
+	PositionSnapshot snapshot{};
+	int n = 0;
+	for (uint64_t occupancy = board.occupancy; occupancy && n < GAME_MAX_ID; occupancy &= occupancy - 1, n++) {
+		const int bindex = std::countr_zero(occupancy);
+		const int nibble = (board.pieces[n / 2] >> (4 * (n & 1))) & 0xF;
+		snapshot.board[bindex / 2] |= static_cast<uint8_t>(nibble << (4 * (bindex & 1)));
+	}
+	snapshot.castles = board.castles;
+	snapshot.p2_index = board.p2_index;
+	snapshot.half_turns = board.half_turns;
+	snapshot.black_to_move = board.black_to_move;
+	snapshot.turn_number = board.turn_number;
+	return snapshot;
+}
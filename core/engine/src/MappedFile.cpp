@@ -0,0 +1,146 @@
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <utility>
+
+
+MappedFile::MappedFile() :
+	m_data(nullptr), m_size(0), m_open(false),
+#ifdef _WIN32
+	m_file_handle(nullptr), m_mapping_handle(nullptr)
+#else
+	m_fd(-1)
+#endif
+{
+}
+
+MappedFile::MappedFile(const std::string& path) : MappedFile()
+{
+	open(path);
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept : MappedFile()
+{
+	*this = std::move(other);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+{
+	if (this == &other) return *this;
+	close();
+	std::swap(m_data, other.m_data);
+	std::swap(m_size, other.m_size);
+	std::swap(m_open, other.m_open);
+#ifdef _WIN32
+	std::swap(m_file_handle, other.m_file_handle);
+	std::swap(m_mapping_handle, other.m_mapping_handle);
+#else
+	std::swap(m_fd, other.m_fd);
+#endif
+	return *this;
+}
+
+MappedFile::~MappedFile()
+{
+	close();
+}
+
+bool MappedFile::open(const std::string& path)
+{
+	close();
+#ifdef _WIN32
+	HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (file == INVALID_HANDLE_VALUE) return false;
+	LARGE_INTEGER file_size;
+	if (!GetFileSizeEx(file, &file_size)) {
+		CloseHandle(file);
+		return false;
+	}
+	m_file_handle = file;
+	m_size = static_cast<size_t>(file_size.QuadPart);
+	m_open = true;
+	if (m_size == 0) return true;
+
+	HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (mapping == nullptr) {
+		close();
+		return false;
+	}
+	m_mapping_handle = mapping;
+	m_data = static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+	if (m_data == nullptr) {
+		close();
+		return false;
+	}
+#else
+	m_fd = ::open(path.c_str(), O_RDONLY);
+	if (m_fd < 0) return false;
+	struct stat st;
+	if (fstat(m_fd, &st) != 0) {
+		::close(m_fd);
+		m_fd = -1;
+		return false;
+	}
+	m_size = static_cast<size_t>(st.st_size);
+	m_open = true;
+	if (m_size == 0) return true;
+
+	void* data = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, m_fd, 0);
+	if (data == MAP_FAILED) {
+		close();
+		return false;
+	}
+	madvise(data, m_size, MADV_SEQUENTIAL);
+	m_data = static_cast<const char*>(data);
+#endif
+	return true;
+}
+
+void MappedFile::close()
+{
+#ifdef _WIN32
+	if (m_data) UnmapViewOfFile(m_data);
+	if (m_mapping_handle) CloseHandle(m_mapping_handle);
+	if (m_file_handle) CloseHandle(m_file_handle);
+	m_mapping_handle = nullptr;
+	m_file_handle = nullptr;
+#else
+	if (m_data) munmap(const_cast<char*>(m_data), m_size);
+	if (m_fd >= 0) ::close(m_fd);
+	m_fd = -1;
+#endif
+	m_data = nullptr;
+	m_size = 0;
+	m_open = false;
+}
+
+bool MappedFile::is_open() const
+{
+	return m_open;
+}
+
+std::string_view MappedFile::view() const
+{
+	return m_data ? std::string_view(m_data, m_size) : std::string_view();
+}
+
+const unsigned char* MappedFile::data() const
+{
+	return reinterpret_cast<const unsigned char*>(m_data);
+}
+
+size_t MappedFile::size() const
+{
+	return m_size;
+}
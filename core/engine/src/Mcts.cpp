@@ -0,0 +1,272 @@
+#include "Mcts.h"
+
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+
+// xorshift64, cheap enough to call for every playout move
+static uint64_t next_random(uint64_t& state)
+{
+	state ^= state << 13;
+	state ^= state >> 7;
+	state ^= state << 17;
+	return state;
+}
+
+MctsSearch::MctsSearch(const MctsConfig& config) :
+	m_config(config),
+	m_nodes(new MctsNode[std::max(config.max_nodes, 1u)]),
+	m_size(0),
+	m_started(0),
+	m_playouts(0),
+	m_stop(false)
+{
+	m_config.max_nodes = std::max(config.max_nodes, 1u);
+}
+
+MctsResult MctsSearch::search(const Game& game, const PlayerLimits& limits)
+{
+	const auto start = std::chrono::steady_clock::now();
+	PlayerLimits search_limits = limits;
+	if (!search_limits.nodes && !search_limits.move_time_ms) search_limits.nodes = 10000;
+	const auto deadline = start + std::chrono::milliseconds(search_limits.move_time_ms);
+
+	MctsNode& root = m_nodes[0];
+	root.move = GameMoveInt();
+	root.child_count = 0;
+	root.first_child = MCTS_NO_NODE;
+	root.state.store(MctsNode::LEAF);
+	root.visits.store(0);
+	root.virtual_loss.store(0);
+	root.score.store(0);
+	m_size = 1;
+	m_started = 0;
+	m_playouts = 0;
+	m_stop = false;
+
+	MctsResult result;
+	if (game.get_game_has_ended()) return result;
+
+	// the root is expanded before the threads start, so that every thread can rely on its children
+	Game root_game(game);
+	if (!expand(root_game, 0)) return result;
+
+	const int threads = std::max(m_config.threads > 0 ? m_config.threads : static_cast<int>(std::thread::hardware_concurrency()), 1);
+	if (threads == 1) {
+		run(root_game, m_config.seed, search_limits, deadline);
+	}
+	else {
+		std::vector<std::thread> workers;
+		for (int i = 0; i < threads; i++) {
+			workers.emplace_back([&, i]() {
+				Game worker_game(root_game);
+				run(worker_game, m_config.seed + 0x9E3779B97F4A7C15ull * (i + 1), search_limits, deadline);
+			});
+		}
+		for (std::thread& worker : workers) worker.join();
+	}
+
+	result.playouts = m_playouts;
+	result.nodes = size();
+	result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	for (uint32_t i = 0; i < root.child_count; i++) {
+		const MctsNode& child = m_nodes[root.first_child + i];
+		const uint32_t visits = child.visits;
+		result.children.push_back({ gmi_to_gm(child.move), visits, visits ? child.score / (2.0 * visits) : 0.0 });
+	}
+	std::stable_sort(result.children.begin(), result.children.end(), [](const MctsRootChild& lhs, const MctsRootChild& rhs) { return lhs.visits > rhs.visits; });
+	result.best_move = result.children.front().move;
+	return result;
+}
+
+void MctsSearch::set_seed(uint64_t seed)
+{
+	m_config.seed = seed;
+}
+
+const MctsConfig& MctsSearch::get_config() const
+{
+	return m_config;
+}
+
+const MctsNode& MctsSearch::get_node(uint32_t id) const
+{
+	return m_nodes[id];
+}
+
+uint32_t MctsSearch::size() const
+{
+	return m_size.load();
+}
+
+/// <summary>
+/// search loop of one thread. game is the root position and is restored after every iteration
+/// </summary>
+void MctsSearch::run(Game& game, uint64_t seed, const PlayerLimits& limits, std::chrono::steady_clock::time_point deadline)
+{
+	// tree path and playout need history capacity, everything else is reserved by Game
+	game.m_gamedelta_list.reserve(game.m_gamedelta_list.size() + MCTS_MAX_TREE_DEPTH + m_config.max_playout_plies);
+	const bool white_at_root = game.get_active_color().IsWhite();
+	uint64_t rng = seed ? seed : 1;
+	std::array<uint32_t, MCTS_MAX_TREE_DEPTH + 1> path;
+
+	for (uint64_t iteration = 1; !m_stop.load(std::memory_order_relaxed); iteration++) {
+		if (limits.nodes && m_started.fetch_add(1, std::memory_order_relaxed) >= limits.nodes) break;
+		// the clock is only read every 64 iterations
+		if (limits.move_time_ms && (iteration & 63) == 0 && std::chrono::steady_clock::now() >= deadline) {
+			m_stop = true;
+			break;
+		}
+
+		// selection down to a leaf, which is expanded and entered through one of its moves
+		int depth = 0;
+		uint32_t id = 0;
+		path[0] = 0;
+		while (!game.get_game_has_ended()) {
+			const uint8_t state = m_nodes[id].state.load(std::memory_order_acquire);
+			const bool leaf = state != MctsNode::EXPANDED;
+			// leaves being expanded by another thread are played out directly
+			if (leaf && (state != MctsNode::LEAF || depth >= MCTS_MAX_TREE_DEPTH || !expand(game, id))) break;
+			id = select(id);
+			m_nodes[id].virtual_loss.fetch_add(1, std::memory_order_relaxed);
+			game.search_move(m_nodes[id].move);
+			path[++depth] = id;
+			if (leaf) break;
+		}
+
+		const int white_score = playout(game, rng);
+
+		// backup. the node at depth d was entered by the side to move at depth d - 1
+		for (int d = depth; d >= 0; d--) {
+			MctsNode& node = m_nodes[path[d]];
+			const bool white_moved = white_at_root == (d % 2 == 1);
+			node.score.fetch_add(white_moved ? white_score : 2 - white_score, std::memory_order_relaxed);
+			node.visits.fetch_add(1, std::memory_order_relaxed);
+			if (d > 0) node.virtual_loss.fetch_sub(1, std::memory_order_relaxed);
+		}
+		for (int d = 0; d < depth; d++) game.search_undo();
+		m_playouts.fetch_add(1, std::memory_order_relaxed);
+	}
+	game.update_legal_moves();
+}
+
+/// <summary>
+/// adds the legal moves of game as children of node id. Returns false if another thread expands it or the arena is full
+/// </summary>
+bool MctsSearch::expand(Game& game, uint32_t id)
+{
+	MctsNode& node = m_nodes[id];
+	uint8_t expected = MctsNode::LEAF;
+	if (!node.state.compare_exchange_strong(expected, MctsNode::EXPANDING, std::memory_order_acq_rel)) return false;
+
+	const uint32_t n = static_cast<uint32_t>(game.m_legal_moves.size());
+	// reserve the children only if they fit, so that m_size never grows past the arena
+	uint32_t first = m_size.load(std::memory_order_relaxed);
+	do {
+		if (n == 0 || first + n > m_config.max_nodes) {
+			node.state.store(MctsNode::LEAF, std::memory_order_release);
+			return false;
+		}
+	} while (!m_size.compare_exchange_weak(first, first + n, std::memory_order_relaxed));
+	for (uint32_t i = 0; i < n; i++) {
+		MctsNode& child = m_nodes[first + i];
+		child.move = game.m_legal_moves[i];
+		child.child_count = 0;
+		child.first_child = MCTS_NO_NODE;
+		child.state.store(MctsNode::LEAF, std::memory_order_relaxed);
+		child.visits.store(0, std::memory_order_relaxed);
+		child.virtual_loss.store(0, std::memory_order_relaxed);
+		child.score.store(0, std::memory_order_relaxed);
+	}
+	node.first_child = first;
+	node.child_count = static_cast<uint16_t>(n);
+	node.state.store(MctsNode::EXPANDED, std::memory_order_release);
+	return true;
+}
+
+/// <summary>
+/// child of an expanded node with the highest UCT value. Virtual losses count as visits without score
+/// </summary>
+uint32_t MctsSearch::select(uint32_t id) const
+{
+	const MctsNode& node = m_nodes[id];
+	const uint32_t parent_visits = node.visits.load(std::memory_order_relaxed) + node.virtual_loss.load(std::memory_order_relaxed);
+	const double log_visits = std::log(static_cast<double>(std::max(parent_visits, 1u)));
+
+	uint32_t best = node.first_child;
+	double best_value = -1.0;
+	for (uint32_t i = node.first_child; i < node.first_child + node.child_count; i++) {
+		const MctsNode& child = m_nodes[i];
+		const uint32_t visits = child.visits.load(std::memory_order_relaxed) + child.virtual_loss.load(std::memory_order_relaxed);
+		if (visits == 0) return i;
+		const double mean = child.score.load(std::memory_order_relaxed) / (2.0 * visits);
+		const double value = mean + m_config.exploration * std::sqrt(log_visits / visits);
+		if (value > best_value) {
+			best_value = value;
+			best = i;
+		}
+	}
+	return best;
+}
+
+/// <summary>
+/// plays random moves until the game ends and takes them back. Returns 2 for a white win, 1 for a draw and 0 for a black win
+/// </summary>
+int MctsSearch::playout(Game& game, uint64_t& rng) const
+{
+	const auto is_capture = [&game](const GameMoveInt& m) {
+		return m.is_promotion() || game.m_board.get_piece_from_bindex(m.get_to()) != Piece::EMPTY;
+	};
+
+	int plies = 0;
+	while (!game.get_game_has_ended() && plies < m_config.max_playout_plies) {
+		const uint64_t n = game.m_legal_moves.size();
+		GameMoveInt m = game.m_legal_moves[next_random(rng) % n];
+		if (m_config.capture_bias && !is_capture(m)) {
+			const GameMoveInt other = game.m_legal_moves[next_random(rng) % n];
+			if (is_capture(other)) m = other;
+		}
+		game.search_move(m);
+		plies++;
+	}
+
+	int white_score = 1;
+	if (game.get_game_has_ended()) {
+		const int state = static_cast<int>(game.get_ending_game_state());
+		if (state < static_cast<int>(GameEndState::BLACK_WIN_CM)) white_score = 2;
+		else if (state < static_cast<int>(GameEndState::END_DRAW_STALEMATE)) white_score = 0;
+	}
+	for (int i = 0; i < plies; i++) game.search_undo();
+	return white_score;
+}
+
+
+MctsPlayer::MctsPlayer(const MctsConfig& config) :
+	m_config(config),
+	m_search()
+{
+}
+
+std::unique_ptr<IGamePlayer> MctsPlayer::clone() const
+{
+	return std::make_unique<MctsPlayer>(m_config);
+}
+
+std::string MctsPlayer::get_name() const
+{
+	return "mcts";
+}
+
+void MctsPlayer::new_game(uint64_t seed)
+{
+	m_config.seed = seed;
+	if (m_search) m_search->set_seed(seed);
+}
+
+GameMove MctsPlayer::choose_move(Game& game, const PlayerLimits& limits)
+{
+	// the arena is allocated once per player and reused for every move
+	if (!m_search) m_search = std::make_unique<MctsSearch>(m_config);
+	return m_search->search(game, limits).best_move;
+}
@@ -0,0 +1,281 @@
+#include "Nnue.h"
+#include "GameSimd.h"
+
+#include <algorithm>
+#include <cstring>
+
+#define NNUE_HEADER_SIZE 16
+
+
+// accumulator[i] += weights[i]
+static void add_row(int16_t* accumulator, const int16_t* weights)
+{
+#if defined(GAME_SIMD_AVX2)
+	for (int i = 0; i < NNUE_L1; i += 16) {
+		const __m256i a = _mm256_load_si256(reinterpret_cast<const __m256i*>(accumulator + i));
+		const __m256i w = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(weights + i));
+		_mm256_store_si256(reinterpret_cast<__m256i*>(accumulator + i), _mm256_add_epi16(a, w));
+	}
+#elif defined(GAME_SIMD_SSE2)
+	for (int i = 0; i < NNUE_L1; i += 8) {
+		const __m128i a = _mm_load_si128(reinterpret_cast<const __m128i*>(accumulator + i));
+		const __m128i w = _mm_loadu_si128(reinterpret_cast<const __m128i*>(weights + i));
+		_mm_store_si128(reinterpret_cast<__m128i*>(accumulator + i), _mm_add_epi16(a, w));
+	}
+#else
+	for (int i = 0; i < NNUE_L1; i++) accumulator[i] = static_cast<int16_t>(accumulator[i] + weights[i]);
+#endif
+}
+
+// accumulator[i] -= weights[i]
+static void sub_row(int16_t* accumulator, const int16_t* weights)
+{
+#if defined(GAME_SIMD_AVX2)
+	for (int i = 0; i < NNUE_L1; i += 16) {
+		const __m256i a = _mm256_load_si256(reinterpret_cast<const __m256i*>(accumulator + i));
+		const __m256i w = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(weights + i));
+		_mm256_store_si256(reinterpret_cast<__m256i*>(accumulator + i), _mm256_sub_epi16(a, w));
+	}
+#elif defined(GAME_SIMD_SSE2)
+	for (int i = 0; i < NNUE_L1; i += 8) {
+		const __m128i a = _mm_load_si128(reinterpret_cast<const __m128i*>(accumulator + i));
+		const __m128i w = _mm_loadu_si128(reinterpret_cast<const __m128i*>(weights + i));
+		_mm_store_si128(reinterpret_cast<__m128i*>(accumulator + i), _mm_sub_epi16(a, w));
+	}
+#else
+	for (int i = 0; i < NNUE_L1; i++) accumulator[i] = static_cast<int16_t>(accumulator[i] - weights[i]);
+#endif
+}
+
+// out[i] = clamp(in[i], 0, 127) for NNUE_L1 values
+static void clip_row(uint8_t* out, const int16_t* in)
+{
+#if defined(GAME_SIMD_AVX2)
+	const __m256i max = _mm256_set1_epi16(127);
+	for (int i = 0; i < NNUE_L1; i += 32) {
+		const __m256i a = _mm256_min_epi16(_mm256_load_si256(reinterpret_cast<const __m256i*>(in + i)), max);
+		const __m256i b = _mm256_min_epi16(_mm256_load_si256(reinterpret_cast<const __m256i*>(in + i + 16)), max);
+		// packus works per 128 bit lane, the permute restores the order
+		const __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(a, b), 0xD8);
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), packed);
+	}
+#elif defined(GAME_SIMD_SSE2)
+	const __m128i max = _mm_set1_epi16(127);
+	for (int i = 0; i < NNUE_L1; i += 16) {
+		const __m128i a = _mm_min_epi16(_mm_load_si128(reinterpret_cast<const __m128i*>(in + i)), max);
+		const __m128i b = _mm_min_epi16(_mm_load_si128(reinterpret_cast<const __m128i*>(in + i + 8)), max);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_packus_epi16(a, b));
+	}
+#else
+	for (int i = 0; i < NNUE_L1; i++) out[i] = static_cast<uint8_t>(std::clamp<int>(in[i], 0, 127));
+#endif
+}
+
+// sum of a[i] * b[i] for n values, n is a multiple of 32. a is at most 127, so no 16 bit intermediate saturates
+static int32_t dot_u8_i8(const uint8_t* a, const int8_t* b, int n)
+{
+#if defined(GAME_SIMD_AVX2)
+	const __m256i ones = _mm256_set1_epi16(1);
+	__m256i sum = _mm256_setzero_si256();
+	for (int i = 0; i < n; i += 32) {
+		const __m256i va = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+		const __m256i vb = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i));
+		sum = _mm256_add_epi32(sum, _mm256_madd_epi16(_mm256_maddubs_epi16(va, vb), ones));
+	}
+	__m128i sum128 = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+	sum128 = _mm_add_epi32(sum128, _mm_shuffle_epi32(sum128, 0x4E));
+	sum128 = _mm_add_epi32(sum128, _mm_shuffle_epi32(sum128, 0xB1));
+	return _mm_cvtsi128_si32(sum128);
+#elif defined(GAME_SIMD_SSE2)
+	const __m128i zero = _mm_setzero_si128();
+	__m128i sum = _mm_setzero_si128();
+	for (int i = 0; i < n; i += 16) {
+		const __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+		const __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+		// zero extend a, sign extend b by duplicating the bytes and shifting arithmetically
+		const __m128i a_lo = _mm_unpacklo_epi8(va, zero);
+		const __m128i a_hi = _mm_unpackhi_epi8(va, zero);
+		const __m128i b_lo = _mm_srai_epi16(_mm_unpacklo_epi8(vb, vb), 8);
+		const __m128i b_hi = _mm_srai_epi16(_mm_unpackhi_epi8(vb, vb), 8);
+		sum = _mm_add_epi32(sum, _mm_add_epi32(_mm_madd_epi16(a_lo, b_lo), _mm_madd_epi16(a_hi, b_hi)));
+	}
+	sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0x4E));
+	sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0xB1));
+	return _mm_cvtsi128_si32(sum);
+#else
+	int32_t sum = 0;
+	for (int i = 0; i < n; i++) sum += static_cast<int32_t>(a[i]) * b[i];
+	return sum;
+#endif
+}
+
+
+NnueNetwork::NnueNetwork() :
+	m_file(),
+	m_feature_bias(nullptr),
+	m_feature_weights(nullptr),
+	m_hidden_weights(nullptr),
+	m_output_weights(nullptr),
+	m_hidden_bias{},
+	m_output_bias(0)
+{
+}
+
+bool NnueNetwork::load(const std::string& path)
+{
+	m_feature_bias = nullptr;
+	if (!m_file.open(path)) return false;
+
+	const size_t feature_bias_size = sizeof(int16_t) * NNUE_L1;
+	const size_t feature_weights_size = sizeof(int16_t) * NNUE_L1 * static_cast<size_t>(NNUE_FEATURES);
+	const size_t hidden_bias_size = sizeof(int32_t) * NNUE_L2;
+	const size_t hidden_weights_size = NNUE_L2 * 2 * NNUE_L1;
+	const size_t size = NNUE_HEADER_SIZE + feature_bias_size + feature_weights_size + hidden_bias_size + hidden_weights_size + sizeof(int32_t) + NNUE_L2;
+	const unsigned char* data = m_file.data();
+	if (m_file.size() != size || std::memcmp(data, NNUE_MAGIC, 4) != 0) {
+		m_file.close();
+		return false;
+	}
+	uint32_t version, features;
+	uint16_t l1, l2;
+	std::memcpy(&version, data + 4, 4);
+	std::memcpy(&features, data + 8, 4);
+	std::memcpy(&l1, data + 12, 2);
+	std::memcpy(&l2, data + 14, 2);
+	if (version != NNUE_VERSION || features != NNUE_FEATURES || l1 != NNUE_L1 || l2 != NNUE_L2) {
+		m_file.close();
+		return false;
+	}
+
+	// the large tables are used in place, the mapping is page aligned and every table starts at an even offset
+	const unsigned char* p = data + NNUE_HEADER_SIZE;
+	m_feature_bias = reinterpret_cast<const int16_t*>(p);
+	p += feature_bias_size;
+	m_feature_weights = reinterpret_cast<const int16_t*>(p);
+	p += feature_weights_size;
+	std::memcpy(m_hidden_bias.data(), p, hidden_bias_size);
+	p += hidden_bias_size;
+	m_hidden_weights = reinterpret_cast<const int8_t*>(p);
+	p += hidden_weights_size;
+	std::memcpy(&m_output_bias, p, sizeof(int32_t));
+	p += sizeof(int32_t);
+	m_output_weights = reinterpret_cast<const int8_t*>(p);
+	return true;
+}
+
+bool NnueNetwork::is_loaded() const
+{
+	return m_feature_bias != nullptr;
+}
+
+int NnueNetwork::feature(bool perspective_white, int king_bindex, Piece p, bool piece_white, int bindex)
+{
+	// black sees the board mirrored vertically, so both perspectives share the weights
+	const int flip = perspective_white ? 0 : GAME_BOARD_SIZE - GAME_WIDTH;
+	const int kind = (static_cast<int>(p) - static_cast<int>(Piece::QUEEN)) * 2 + (piece_white == perspective_white ? 0 : 1);
+	return ((king_bindex ^ flip) * 10 + kind) * GAME_BOARD_SIZE + (bindex ^ flip);
+}
+
+int NnueNetwork::evaluate(const NnueAccumulator& accumulator, bool white_to_move) const
+{
+	alignas(32) std::array<uint8_t, 2 * NNUE_L1> input;
+	clip_row(input.data(), accumulator.get_values(white_to_move).data());
+	clip_row(input.data() + NNUE_L1, accumulator.get_values(!white_to_move).data());
+
+	alignas(32) std::array<uint8_t, NNUE_L2> hidden;
+	for (int i = 0; i < NNUE_L2; i++) {
+		const int32_t sum = dot_u8_i8(input.data(), m_hidden_weights + i * 2 * NNUE_L1, 2 * NNUE_L1) + m_hidden_bias[i];
+		hidden[i] = static_cast<uint8_t>(std::clamp(sum >> NNUE_HIDDEN_SHIFT, 0, 127));
+	}
+	const int32_t output = dot_u8_i8(hidden.data(), m_output_weights, NNUE_L2) + m_output_bias;
+	return output / NNUE_OUTPUT_SCALE;
+}
+
+const int16_t* NnueNetwork::get_feature_bias() const
+{
+	return m_feature_bias;
+}
+
+const int16_t* NnueNetwork::get_feature_weights(int feature) const
+{
+	return m_feature_weights + static_cast<size_t>(feature) * NNUE_L1;
+}
+
+
+NnueAccumulator::NnueAccumulator(const NnueNetwork& network) :
+	m_network(network),
+	m_frames(1),
+	m_top(0)
+{
+	m_frames.reserve(128);
+}
+
+void NnueAccumulator::refresh(const ChessBoard& board)
+{
+	m_top = 0;
+	refresh_perspective(board, true, m_frames[0]);
+	refresh_perspective(board, false, m_frames[0]);
+}
+
+void NnueAccumulator::refresh_perspective(const ChessBoard& board, bool white_perspective, Frame& frame) const
+{
+	int16_t* values = frame.values[white_perspective ? 0 : 1].data();
+	std::memcpy(values, m_network.get_feature_bias(), sizeof(int16_t) * NNUE_L1);
+	const int king_bindex = board.get_bindex(white_perspective ? 0 : GAME_BLACK_ID_OFFSET);
+	for (int id = 0; id < GAME_MAX_ID; id++) {
+		const Piece p = board.get_piece_from_id(id);
+		if (p == Piece::EMPTY || p == Piece::KING) continue;
+		add_row(values, m_network.get_feature_weights(NnueNetwork::feature(white_perspective, king_bindex, p, id < GAME_BLACK_ID_OFFSET, board.get_bindex(id))));
+	}
+}
+
+void NnueAccumulator::push(const ChessBoard& board, const GameDelta& gd)
+{
+	if (m_top + 1 == static_cast<int>(m_frames.size())) m_frames.emplace_back();
+	Frame& frame = m_frames[m_top + 1];
+	frame = m_frames[m_top];
+	m_top++;
+
+	const UniquePiece moved = board.get_up(gd.move.to);
+	const bool white = moved.IsWhite();
+	const Piece before = gd.IsPromotion() ? Piece::PAWN : moved.p;
+	for (const bool perspective : { true, false }) {
+		// the king square is part of every feature of its perspective
+		if (moved.p == Piece::KING && perspective == white) {
+			refresh_perspective(board, perspective, frame);
+			continue;
+		}
+		int16_t* values = frame.values[perspective ? 0 : 1].data();
+		const int king_bindex = board.get_bindex(perspective ? 0 : GAME_BLACK_ID_OFFSET);
+		if (moved.p != Piece::KING) {
+			sub_row(values, m_network.get_feature_weights(NnueNetwork::feature(perspective, king_bindex, before, white, gd.move.from)));
+			add_row(values, m_network.get_feature_weights(NnueNetwork::feature(perspective, king_bindex, moved.p, white, gd.move.to)));
+		}
+		if (gd.IsCastle()) {
+			const int rook_bindex = gd.move.from + (gd.IsKSCastle() ? 3 : -4);
+			const int king_adjacent_bindex = gd.move.from + (gd.IsKSCastle() ? 1 : -1);
+			sub_row(values, m_network.get_feature_weights(NnueNetwork::feature(perspective, king_bindex, Piece::ROOK, white, rook_bindex)));
+			add_row(values, m_network.get_feature_weights(NnueNetwork::feature(perspective, king_bindex, Piece::ROOK, white, king_adjacent_bindex)));
+		}
+		if (gd.IsTakes()) {
+			const int takes_bindex = gd.IsEnPassant() ? gd.p2_index : gd.move.to;
+			sub_row(values, m_network.get_feature_weights(NnueNetwork::feature(perspective, king_bindex, gd.takes.p, !white, takes_bindex)));
+		}
+	}
+}
+
+void NnueAccumulator::pop(const ChessBoard& board)
+{
+	if (m_top > 0) m_top--;
+	else refresh(board);
+}
+
+const std::array<int16_t, NNUE_L1>& NnueAccumulator::get_values(bool white_perspective) const
+{
+	return m_frames[m_top].values[white_perspective ? 0 : 1];
+}
+
+int NnueAccumulator::get_depth() const
+{
+	return m_top;
+}
@@ -0,0 +1,367 @@
+#include "PgnReader.h"
+#include "GamePool.h"
+#include "MappedFile.h"
+
+#include <chrono>
+#include <mutex>
+#include <thread>
+
+
+static bool pgn_is_space(char c)
+{
+	return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+}
+
+static bool pgn_is_digit(char c)
+{
+	return c >= '0' && c <= '9';
+}
+
+static bool pgn_starts_with(std::string_view text, size_t pos, std::string_view prefix)
+{
+	return text.substr(pos, prefix.size()) == prefix;
+}
+
+std::string_view PgnGame::get_tag(std::string_view name) const
+{
+	for (int i = 0; i < tag_count; i++) {
+		if (tags[i].name == name) return tags[i].value;
+	}
+	return std::string_view();
+}
+
+double PgnStats::get_games_per_second() const
+{
+	return seconds > 0.0 ? double(games) / seconds : 0.0;
+}
+
+
+PgnMoveTokenizer::PgnMoveTokenizer(std::string_view movetext) :
+	m_text(movetext), m_pos(0), m_result()
+{
+}
+
+bool PgnMoveTokenizer::next(std::string_view& san)
+{
+	const size_t n = m_text.size();
+	while (m_pos < n) {
+		const char c = m_text[m_pos];
+		if (pgn_is_space(c) || c == '.' || c == ')') {
+			m_pos++;
+		}
+		else if (c == '{') {
+			const size_t end = m_text.find('}', m_pos);
+			m_pos = end == std::string_view::npos ? n : end + 1;
+		}
+		else if (c == ';') {
+			const size_t end = m_text.find('\n', m_pos);
+			m_pos = end == std::string_view::npos ? n : end + 1;
+		}
+		else if (c == '(') {
+			// skip recursive variation including nested variations and comments
+			int depth = 0;
+			while (m_pos < n) {
+				const char v = m_text[m_pos];
+				if (v == '(') depth++;
+				else if (v == ')') {
+					if (--depth == 0) {
+						m_pos++;
+						break;
+					}
+				}
+				else if (v == '{') {
+					const size_t end = m_text.find('}', m_pos);
+					if (end == std::string_view::npos) {
+						m_pos = n;
+						break;
+					}
+					m_pos = end;
+				}
+				else if (v == ';') {
+					const size_t end = m_text.find('\n', m_pos);
+					if (end == std::string_view::npos) {
+						m_pos = n;
+						break;
+					}
+					m_pos = end;
+				}
+				m_pos++;
+			}
+		}
+		else if (c == '$') {
+			m_pos++;
+			while (m_pos < n && pgn_is_digit(m_text[m_pos])) m_pos++;
+		}
+		else if (c == '*') {
+			m_result = m_text.substr(m_pos, 1);
+			m_pos = n;
+			return false;
+		}
+		else if (pgn_is_digit(c) && !pgn_starts_with(m_text, m_pos, "0-0")) {
+			for (const std::string_view result : { std::string_view("1-0"), std::string_view("0-1"), std::string_view("1/2-1/2") }) {
+				if (pgn_starts_with(m_text, m_pos, result)) {
+					m_result = m_text.substr(m_pos, result.size());
+					m_pos = n;
+					return false;
+				}
+			}
+			// move number, the dots are skipped above
+			while (m_pos < n && pgn_is_digit(m_text[m_pos])) m_pos++;
+		}
+		else {
+			const size_t begin = m_pos;
+			while (m_pos < n) {
+				const char t = m_text[m_pos];
+				if (pgn_is_space(t) || t == '{' || t == '(' || t == ')' || t == ';' || t == '$') break;
+				m_pos++;
+			}
+			san = m_text.substr(begin, m_pos - begin);
+			return true;
+		}
+	}
+	return false;
+}
+
+std::string_view PgnMoveTokenizer::get_result() const
+{
+	return m_result;
+}
+
+
+PgnReader::PgnReader(std::string_view text, uint64_t first_index) :
+	m_text(text), m_pos(0), m_index(first_index)
+{
+}
+
+bool PgnReader::next(PgnGame& game)
+{
+	skip_whitespace();
+	if (m_pos >= m_text.size()) return false;
+
+	const size_t begin = m_pos;
+	game.tag_count = 0;
+	game.index = m_index++;
+	while (m_pos < m_text.size() && m_text[m_pos] == '[') {
+		parse_tag(game);
+		skip_whitespace();
+	}
+
+	const size_t movetext_begin = m_pos;
+	skip_movetext();
+	size_t movetext_end = m_pos;
+	while (movetext_end > movetext_begin && pgn_is_space(m_text[movetext_end - 1])) movetext_end--;
+
+	game.movetext = m_text.substr(movetext_begin, movetext_end - movetext_begin);
+	game.text = m_text.substr(begin, movetext_end - begin);
+	return true;
+}
+
+size_t PgnReader::get_offset() const
+{
+	return m_pos;
+}
+
+void PgnReader::skip_whitespace()
+{
+	const size_t n = m_text.size();
+	while (m_pos < n) {
+		if (pgn_is_space(m_text[m_pos])) m_pos++;
+		else if (m_text[m_pos] == '%' && (m_pos == 0 || m_text[m_pos - 1] == '\n')) {
+			// escape line
+			const size_t end = m_text.find('\n', m_pos);
+			m_pos = end == std::string_view::npos ? n : end + 1;
+		}
+		else return;
+	}
+}
+
+void PgnReader::parse_tag(PgnGame& game)
+{
+	const size_t n = m_text.size();
+	size_t line_end = m_text.find('\n', m_pos);
+	if (line_end == std::string_view::npos) line_end = n;
+
+	m_pos++; // '['
+	while (m_pos < line_end && pgn_is_space(m_text[m_pos])) m_pos++;
+	const size_t name_begin = m_pos;
+	while (m_pos < line_end && !pgn_is_space(m_text[m_pos]) && m_text[m_pos] != '"' && m_text[m_pos] != ']') m_pos++;
+	const std::string_view name = m_text.substr(name_begin, m_pos - name_begin);
+
+	while (m_pos < line_end && m_text[m_pos] != '"') m_pos++;
+	if (m_pos < line_end) {
+		const size_t value_begin = ++m_pos;
+		while (m_pos < line_end && m_text[m_pos] != '"') {
+			if (m_text[m_pos] == '\\') m_pos++;
+			m_pos++;
+		}
+		const size_t value_end = std::min(m_pos, line_end);
+		if (game.tag_count < PGN_MAX_TAGS && !name.empty()) {
+			game.tags[game.tag_count++] = PgnTag{ name, m_text.substr(value_begin, value_end - value_begin) };
+		}
+	}
+	m_pos = line_end;
+}
+
+/// <summary>
+/// advances to the next line that starts with '[' outside of a comment
+/// </summary>
+void PgnReader::skip_movetext()
+{
+	const size_t n = m_text.size();
+	while (m_pos < n) {
+		const char c = m_text[m_pos];
+		if (c == '{') {
+			const size_t end = m_text.find('}', m_pos);
+			m_pos = end == std::string_view::npos ? n : end + 1;
+		}
+		else if (c == ';') {
+			const size_t end = m_text.find('\n', m_pos);
+			m_pos = end == std::string_view::npos ? n : end;
+		}
+		else if (c == '\n') {
+			m_pos++;
+			if (m_pos < n && m_text[m_pos] == '[') return;
+		}
+		else m_pos++;
+	}
+}
+
+
+PgnReplay pgn_replay(const PgnGame& pgn, Game& game)
+{
+	PgnReplay replay;
+	game.new_game(pgn.get_tag("FEN"));
+	if (!game.get_init_ok()) {
+		replay.ok = false;
+		return replay;
+	}
+
+	PgnMoveTokenizer tokenizer(pgn.movetext);
+	std::string_view san;
+	while (tokenizer.next(san)) {
+		if (game.move(san, GameMoveStrFmt::SAN) == GameState::INVALID_MOVE) {
+			replay.ok = false;
+			replay.failed_move = san;
+			return replay;
+		}
+		replay.plies++;
+	}
+	replay.result = tokenizer.get_result();
+	return replay;
+}
+
+/// <summary>
+/// returns the index of the first tag section at or after from.
+/// A '[' at the beginning of a line starts a game if the previous non blank line is not a tag.
+/// </summary>
+static size_t pgn_find_game_start(std::string_view text, size_t from)
+{
+	size_t pos = from;
+	while (true) {
+		const size_t nl = text.find("\n[", pos);
+		if (nl == std::string_view::npos) return text.size();
+		size_t prev_end = nl;
+		while (prev_end > 0 && pgn_is_space(text[prev_end - 1])) prev_end--;
+		if (prev_end == 0) return nl + 1;
+		const size_t prev_nl = text.rfind('\n', prev_end - 1);
+		const size_t prev_begin = prev_nl == std::string_view::npos ? 0 : prev_nl + 1;
+		if (text[prev_begin] != '[') return nl + 1;
+		pos = nl + 1;
+	}
+}
+
+std::vector<std::string_view> pgn_split(std::string_view text, int parts)
+{
+	std::vector<std::string_view> chunks;
+	size_t begin = 0;
+	for (int i = 1; i < parts; i++) {
+		const size_t target = text.size() / parts * i;
+		if (target <= begin) continue;
+		const size_t split = pgn_find_game_start(text, target);
+		if (split >= text.size()) break;
+		chunks.push_back(text.substr(begin, split - begin));
+		begin = split;
+	}
+	chunks.push_back(text.substr(begin));
+	return chunks;
+}
+
+static PgnStats pgn_read_chunk(std::string_view text, uint64_t first_index, const PgnVisitor& visitor)
+{
+	PgnStats stats;
+	GamePool::Handle game = GamePool::local().acquire();
+	PgnReader reader(text, first_index);
+	PgnGame pgn;
+	while (reader.next(pgn)) {
+		const PgnReplay replay = pgn_replay(pgn, *game);
+		stats.games++;
+		stats.plies += replay.plies;
+		if (!replay.ok) stats.errors++;
+		if (visitor) visitor(pgn, *game, replay);
+	}
+	return stats;
+}
+
+void pgn_for_each_chunk(std::string_view text, int threads, const PgnChunkVisitor& visitor)
+{
+	if (threads <= 1) {
+		visitor(text, 0);
+		return;
+	}
+	const std::vector<std::string_view> chunks = pgn_split(text, threads);
+	const int nchunks = static_cast<int>(chunks.size());
+
+	// count games per chunk first so that every game gets its index in the database
+	std::vector<uint64_t> first_index(nchunks, 0);
+	{
+		std::vector<std::thread> workers;
+		for (int i = 0; i < nchunks; i++) {
+			workers.emplace_back([&chunks, &first_index, i]() {
+				PgnReader reader(chunks[i]);
+				PgnGame pgn;
+				uint64_t count = 0;
+				while (reader.next(pgn)) count++;
+				first_index[i] = count;
+			});
+		}
+		for (std::thread& worker : workers) worker.join();
+	}
+	uint64_t games_before = 0;
+	for (uint64_t& index : first_index) {
+		const uint64_t count = index;
+		index = games_before;
+		games_before += count;
+	}
+
+	std::vector<std::thread> workers;
+	for (int i = 0; i < nchunks; i++) {
+		workers.emplace_back([&chunks, &first_index, &visitor, i]() {
+			visitor(chunks[i], first_index[i]);
+		});
+	}
+	for (std::thread& worker : workers) worker.join();
+}
+
+PgnStats pgn_read(std::string_view text, const PgnVisitor& visitor, int threads)
+{
+	const auto start = std::chrono::steady_clock::now();
+	std::mutex mutex;
+	PgnStats stats;
+	pgn_for_each_chunk(text, threads, [&](std::string_view chunk, uint64_t first_index) {
+		const PgnStats chunk_stats = pgn_read_chunk(chunk, first_index, visitor);
+		std::lock_guard<std::mutex> lock(mutex);
+		stats.games += chunk_stats.games;
+		stats.plies += chunk_stats.plies;
+		stats.errors += chunk_stats.errors;
+	});
+	stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	return stats;
+}
+
+bool pgn_read_file(const std::string& path, PgnStats& stats, const PgnVisitor& visitor, int threads)
+{
+	MappedFile file(path);
+	if (!file.is_open()) return false;
+	stats = pgn_read(file.view(), visitor, threads);
+	return true;
+}
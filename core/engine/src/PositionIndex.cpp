@@ -0,0 +1,244 @@
+#include "PositionIndex.h"
+#include "GamePool.h"
+#include "PgnReader.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <queue>
+
+#define POSITION_INDEX_HEADER_SIZE 16
+// postings read or written per io call while merging
+#define POSITION_INDEX_IO_POSTINGS 4096
+
+static_assert(sizeof(PositionPosting) == 16, "PositionPosting is stored as is");
+
+
+/// <summary>
+/// buffered sequential reader of a sorted run file
+/// </summary>
+class PositionRunReader
+{
+public:
+	PositionRunReader(const std::string& path) :
+		m_file(path, std::ios::binary), m_buffer(POSITION_INDEX_IO_POSTINGS), m_pos(0), m_size(0)
+	{
+	}
+	bool is_open() const { return m_file.is_open(); }
+	// returns false at the end of the run
+	bool next(PositionPosting& posting)
+	{
+		if (m_pos == m_size) {
+			m_file.read(reinterpret_cast<char*>(m_buffer.data()), m_buffer.size() * sizeof(PositionPosting));
+			m_size = static_cast<size_t>(m_file.gcount()) / sizeof(PositionPosting);
+			m_pos = 0;
+			if (m_size == 0) return false;
+		}
+		posting = m_buffer[m_pos++];
+		return true;
+	}
+private:
+	std::ifstream m_file;
+	std::vector<PositionPosting> m_buffer;
+	size_t m_pos;
+	size_t m_size;
+};
+
+
+PositionIndexBuilder::PositionIndexBuilder(std::string path, size_t run_postings) :
+	m_path(std::move(path)), m_run_postings(std::max<size_t>(run_postings, 1)), m_mutex(), m_run_paths(), m_run_sizes(), m_failed(false)
+{
+}
+
+PositionIndexBuilder::~PositionIndexBuilder()
+{
+	for (const std::string& run_path : m_run_paths) std::remove(run_path.c_str());
+}
+
+size_t PositionIndexBuilder::get_run_postings() const
+{
+	return m_run_postings;
+}
+
+bool PositionIndexBuilder::spill(std::vector<PositionPosting>& postings)
+{
+	if (postings.empty()) return true;
+	std::sort(postings.begin(), postings.end());
+
+	std::string run_path;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		run_path = m_path + ".run" + std::to_string(m_run_paths.size());
+		m_run_paths.push_back(run_path);
+		m_run_sizes.push_back(postings.size());
+	}
+	std::ofstream file(run_path, std::ios::binary | std::ios::trunc);
+	file.write(reinterpret_cast<const char*>(postings.data()), postings.size() * sizeof(PositionPosting));
+	file.close();
+	postings.clear();
+	if (file.fail()) {
+		m_failed = true;
+		return false;
+	}
+	return true;
+}
+
+bool PositionIndexBuilder::finish()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	if (m_failed) return false;
+
+	uint64_t count = 0;
+	for (const uint64_t run_size : m_run_sizes) count += run_size;
+
+	std::ofstream out(m_path, std::ios::binary | std::ios::trunc);
+	if (!out.is_open()) return false;
+	char header[POSITION_INDEX_HEADER_SIZE] = {};
+	std::memcpy(header, POSITION_INDEX_MAGIC, 4);
+	std::memcpy(header + 8, &count, sizeof(count));
+	out.write(header, POSITION_INDEX_HEADER_SIZE);
+
+	// k-way merge with a min heap of the current head of every run
+	std::vector<PositionRunReader> readers;
+	readers.reserve(m_run_paths.size());
+	typedef std::pair<PositionPosting, size_t> Head;
+	auto greater = [](const Head& lhs, const Head& rhs) { return rhs.first < lhs.first; };
+	std::priority_queue<Head, std::vector<Head>, decltype(greater)> heads(greater);
+	for (size_t i = 0; i < m_run_paths.size(); i++) {
+		readers.emplace_back(m_run_paths[i]);
+		if (!readers[i].is_open()) {
+			out.close();
+			std::remove(m_path.c_str());
+			return false;
+		}
+		PositionPosting posting;
+		if (readers[i].next(posting)) heads.emplace(posting, i);
+	}
+
+	std::vector<PositionPosting> buffer;
+	buffer.reserve(POSITION_INDEX_IO_POSTINGS);
+	uint64_t written = 0;
+	while (!heads.empty()) {
+		const Head head = heads.top();
+		heads.pop();
+		buffer.push_back(head.first);
+		if (buffer.size() == POSITION_INDEX_IO_POSTINGS) {
+			out.write(reinterpret_cast<const char*>(buffer.data()), buffer.size() * sizeof(PositionPosting));
+			written += buffer.size();
+			buffer.clear();
+		}
+		PositionPosting posting;
+		if (readers[head.second].next(posting)) heads.emplace(posting, head.second);
+	}
+	out.write(reinterpret_cast<const char*>(buffer.data()), buffer.size() * sizeof(PositionPosting));
+	written += buffer.size();
+	out.close();
+
+	readers.clear();
+	for (const std::string& run_path : m_run_paths) std::remove(run_path.c_str());
+	m_run_paths.clear();
+	m_run_sizes.clear();
+	// no truncated index is left behind
+	const bool ok = !out.fail() && written == count;
+	if (!ok) std::remove(m_path.c_str());
+	return ok;
+}
+
+
+PositionIndex::PositionIndex() :
+	m_file(), m_postings(nullptr), m_size(0)
+{
+}
+
+PositionIndex::PositionIndex(const std::string& path) :
+	PositionIndex()
+{
+	open(path);
+}
+
+bool PositionIndex::open(const std::string& path)
+{
+	m_postings = nullptr;
+	m_size = 0;
+	if (!m_file.open(path)) return false;
+
+	const std::string_view data = m_file.view();
+	uint64_t count = 0;
+	if (data.size() < POSITION_INDEX_HEADER_SIZE || data.substr(0, 4) != POSITION_INDEX_MAGIC) {
+		m_file.close();
+		return false;
+	}
+	std::memcpy(&count, data.data() + 8, sizeof(count));
+	if (count != (data.size() - POSITION_INDEX_HEADER_SIZE) / sizeof(PositionPosting)) {
+		m_file.close();
+		return false;
+	}
+	// the mapping is page aligned, so the postings after the 16 byte header are aligned too
+	m_postings = reinterpret_cast<const PositionPosting*>(data.data() + POSITION_INDEX_HEADER_SIZE);
+	m_size = static_cast<size_t>(count);
+	return true;
+}
+
+bool PositionIndex::is_open() const
+{
+	return m_file.is_open();
+}
+
+size_t PositionIndex::size() const
+{
+	return m_size;
+}
+
+std::span<const PositionPosting> PositionIndex::find(uint64_t key) const
+{
+	const PositionPosting* end = m_postings + m_size;
+	const PositionPosting* first = std::lower_bound(m_postings, end, key,
+		[](const PositionPosting& posting, uint64_t k) { return posting.key < k; });
+	const PositionPosting* last = std::upper_bound(first, end, key,
+		[](uint64_t k, const PositionPosting& posting) { return k < posting.key; });
+	return std::span<const PositionPosting>(first, last);
+}
+
+std::span<const PositionPosting> PositionIndex::get_postings() const
+{
+	return std::span<const PositionPosting>(m_postings, m_size);
+}
+
+
+bool build_position_index(std::string_view pgn, const std::string& index_path, int threads, size_t run_postings)
+{
+	PositionIndexBuilder builder(index_path, run_postings);
+	pgn_for_each_chunk(pgn, threads, [&builder](std::string_view chunk, uint64_t first_index) {
+		// a posting per ply and at least 3 characters per san with its separator
+		std::vector<PositionPosting> postings;
+		postings.reserve(std::min(builder.get_run_postings(), chunk.size() / 3 + 1));
+		GamePool::Handle game = GamePool::local().acquire();
+		PgnReader reader(chunk, first_index);
+		PgnGame pgn_game;
+		while (reader.next(pgn_game)) {
+			game->new_game(pgn_game.get_tag("FEN"));
+			if (!game->get_init_ok()) continue;
+			const uint32_t game_id = static_cast<uint32_t>(pgn_game.index);
+			uint32_t ply = 0;
+			postings.push_back(PositionPosting{ game->get_hash(), game_id, ply });
+
+			PgnMoveTokenizer tokenizer(pgn_game.movetext);
+			std::string_view san;
+			while (tokenizer.next(san)) {
+				if (game->move(san, GameMoveStrFmt::SAN) == GameState::INVALID_MOVE) break;
+				postings.push_back(PositionPosting{ game->get_hash(), game_id, ++ply });
+				if (postings.size() >= builder.get_run_postings()) builder.spill(postings);
+			}
+		}
+		builder.spill(postings);
+	});
+	return builder.finish();
+}
+
+bool build_position_index_file(const std::string& pgn_path, const std::string& index_path, int threads, size_t run_postings)
+{
+	MappedFile file(pgn_path);
+	if (!file.is_open()) return false;
+	return build_position_index(file.view(), index_path, threads, run_postings);
+}
@@ -0,0 +1,179 @@
+#include "Tournament.h"
+#include "GamePool.h"
+#include "GameSave.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <fstream>
+#include <mutex>
+#include <thread>
+
+
+double TournamentResult::score() const
+{
+	if (games() == 0) return 0.5;
+	return (wins + 0.5 * draws) / games();
+}
+
+static double score_to_elo(double score)
+{
+	if (score <= 0.0) return -1200.0;
+	if (score >= 1.0) return 1200.0;
+	return std::clamp(-400.0 * std::log10(1.0 / score - 1.0), -1200.0, 1200.0);
+}
+
+double TournamentResult::elo() const
+{
+	return score_to_elo(score());
+}
+
+double TournamentResult::elo_error() const
+{
+	const int n = games();
+	if (n == 0) return 0.0;
+	const double s = score();
+	// variance of a single game result around the mean score
+	const double variance = (wins * (1.0 - s) * (1.0 - s) + draws * (0.5 - s) * (0.5 - s) + losses * s * s) / n;
+	const double margin = 1.96 * std::sqrt(variance / n);
+	return (score_to_elo(std::min(s + margin, 1.0)) - score_to_elo(std::max(s - margin, 0.0))) / 2.0;
+}
+
+
+Tournament::Tournament(const IGamePlayer& first, const IGamePlayer& second, TournamentConfig config) :
+	m_first(first.clone()),
+	m_second(second.clone()),
+	m_config(std::move(config))
+{
+	if (m_config.openings.empty()) m_config.openings.push_back(GAME_DEFAULT_FEN);
+	m_config.games_per_opening = std::max(m_config.games_per_opening, 1);
+}
+
+int Tournament::get_game_count() const
+{
+	return static_cast<int>(m_config.openings.size()) * m_config.games_per_opening;
+}
+
+TournamentResult Tournament::run(const GameCallback& on_game)
+{
+	const int game_count = get_game_count();
+	int threads = m_config.threads > 0 ? m_config.threads : static_cast<int>(std::thread::hardware_concurrency());
+	threads = std::clamp(threads, 1, std::max(game_count, 1));
+
+	TournamentResult result;
+	std::mutex mutex;
+	std::atomic<int> next_index = 0;
+	auto worker = [&]() {
+		std::unique_ptr<IGamePlayer> first = m_first->clone();
+		std::unique_ptr<IGamePlayer> second = m_second->clone();
+		std::string pgn;
+		for (int index = next_index++; index < game_count; index = next_index++) {
+			const char* white_result = play(index, *first, *second, pgn);
+
+			std::lock_guard<std::mutex> lock(mutex);
+			if (!white_result) {
+				result.errors++;
+				continue;
+			}
+			const bool first_white = index % 2 == 0;
+			if (white_result[1] == '/') result.draws++;
+			else if ((white_result[0] == '1') == first_white) result.wins++;
+			else result.losses++;
+			if (on_game) on_game(index, pgn);
+		}
+	};
+
+	if (threads == 1) {
+		worker();
+		return result;
+	}
+	std::vector<std::thread> workers;
+	for (int i = 0; i < threads; i++) workers.emplace_back(worker);
+	for (std::thread& w : workers) w.join();
+	return result;
+}
+
+const char* Tournament::play(int index, IGamePlayer& first, IGamePlayer& second, std::string& pgn) const
+{
+	GamePool::Handle game = GamePool::local().acquire(m_config.openings[index / m_config.games_per_opening]);
+	if (!game->get_init_ok()) return nullptr;
+
+	const bool first_white = index % 2 == 0;
+	IGamePlayer& white = first_white ? first : second;
+	IGamePlayer& black = first_white ? second : first;
+	const uint64_t seed = m_config.seed * 0x9E3779B97F4A7C15ull + static_cast<uint64_t>(index);
+	white.new_game(seed);
+	black.new_game(~seed);
+
+	std::vector<uint64_t> hashes{ game->get_hash() };
+	while (!game->get_game_has_ended()) {
+		if (game->get_ply() >= m_config.max_plies) {
+			game->set_ending_game_state(GameEndState::END_DRAW_MAX_TURNS);
+			break;
+		}
+		const bool white_to_move = game->get_active_color().IsWhite();
+		const GameMove move = (white_to_move ? white : black).choose_move(*game, m_config.limits);
+		if (game->move(move) == GameState::INVALID_MOVE) {
+			game->set_ending_game_state(white_to_move ? GameEndState::BLACK_WIN_REP_INV_MOVE : GameEndState::WHITE_WIN_REP_INV_MOVE);
+			break;
+		}
+		const uint64_t hash = game->get_hash();
+		hashes.push_back(hash);
+		if (!game->get_game_has_ended() && std::count(hashes.begin(), hashes.end(), hash) >= 3) {
+			game->set_ending_game_state(GameEndState::END_DRAW_3FOLD);
+		}
+	}
+
+	const std::vector<GameTag> tags = {
+		{ "Event", m_config.event },
+		{ "Round", std::to_string(index + 1) },
+		{ "White", white.get_name() },
+		{ "Black", black.get_name() },
+	};
+	pgn = write_game_pgn(*game, tags);
+	return game_result_to_string(*game);
+}
+
+
+std::string opening_to_fen(std::string_view line)
+{
+	std::vector<std::string_view> fields;
+	size_t begin = line.find_first_not_of(" \t\r");
+	while (begin != std::string_view::npos && fields.size() < 6) {
+		const size_t end = std::min(line.find_first_of(" \t\r", begin), line.size());
+		fields.push_back(line.substr(begin, end - begin));
+		begin = line.find_first_not_of(" \t\r", end);
+	}
+	if (fields.size() < 4) return "";
+
+	std::string fen;
+	for (int i = 0; i < 4; i++) {
+		fen += fields[i];
+		fen += ' ';
+	}
+	// fen clocks, epd operations are replaced by default clocks
+	const auto is_number = [](std::string_view s) { return !s.empty() && std::all_of(s.begin(), s.end(), [](char c) { return c >= '0' && c <= '9'; }); };
+	if (fields.size() == 6 && is_number(fields[4]) && is_number(fields[5])) {
+		fen += fields[4];
+		fen += ' ';
+		fen += fields[5];
+	}
+	else {
+		fen += "0 1";
+	}
+	return fen;
+}
+
+bool read_openings(const std::string& path, std::vector<std::string>& openings)
+{
+	std::ifstream file(path);
+	if (!file) return false;
+	std::string line;
+	while (std::getline(file, line)) {
+		const size_t first = line.find_first_not_of(" \t\r");
+		if (first == std::string::npos || line[first] == '#') continue;
+		std::string fen = opening_to_fen(line);
+		if (!fen.empty()) openings.push_back(std::move(fen));
+	}
+	return true;
+}
@@ -0,0 +1,68 @@
+#include "BatchEval.h"
+#include "Game.h"
+
+#include "gtest/gtest.h"
+
+#include <random>
+
+
+TEST(BatchEval, StaticEvaluation) {
+	PositionBatch batch;
+	ASSERT_TRUE(batch.add(GAME_DEFAULT_FEN));
+	ASSERT_TRUE(batch.add("rnbqkbnr/pppppppp/8/8/4P3/8/PPPP1PPP/RNBQKBNR b KQkq e3 0 1"));
+	// white is a queen up, seen from both sides
+	ASSERT_TRUE(batch.add("4k3/8/8/8/8/8/8/3QK3 w - - 0 1"));
+	ASSERT_TRUE(batch.add("4k3/8/8/8/8/8/8/3QK3 b - - 0 1"));
+	EXPECT_FALSE(batch.add("4k3/8/8/8/8/8/8/3QK3"));
+	EXPECT_FALSE(batch.add("4k3/8/8/8/8/8/8/3QK3 x - - 0 1"));
+	EXPECT_FALSE(batch.add("4k3/8/8/8/8/8/8/3QKK2 w - - 0 1"));
+	ASSERT_EQ(batch.size(), 4);
+
+	std::vector<int> scores(batch.size());
+	evaluate_batch(batch, scores, 1);
+	// symmetric position
+	EXPECT_EQ(scores[0], 0);
+	EXPECT_EQ(scores[0], evaluate_static(Game().get_snapshot()));
+	// e4 gains piece square and mobility for white, bad for black to move
+	EXPECT_LT(scores[1], 0);
+	EXPECT_GT(scores[2], 800);
+	EXPECT_EQ(scores[3], -scores[2]);
+}
+
+TEST(BatchEval, MatchesScalar) {
+	const char* fens[] = {
+		GAME_DEFAULT_FEN,
+		"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+		"r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+		"8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+	};
+	// positions of random games, not a multiple of BATCH_LANES so the last block is partial
+	std::vector<PositionSnapshot> snapshots;
+	std::mt19937_64 rng(7);
+	for (const char* fen : fens) {
+		Game game(fen);
+		for (int ply = 0; ply < 101 && !game.get_game_has_ended(); ply++) {
+			snapshots.push_back(game.get_snapshot());
+			const std::vector<GameMove> moves = game.get_possible_moves();
+			game.move(moves[rng() % moves.size()]);
+		}
+	}
+	ASSERT_NE(snapshots.size() % BATCH_LANES, 0u);
+
+	PositionBatch batch;
+	batch.reserve(static_cast<int>(snapshots.size()));
+	for (const PositionSnapshot& snapshot : snapshots) batch.add(snapshot);
+	ASSERT_EQ(batch.size(), static_cast<int>(snapshots.size()));
+
+	for (const int threads : { 1, 3 }) {
+		std::vector<int> scores(snapshots.size(), INT32_MIN);
+		evaluate_batch(batch, scores, threads);
+		for (size_t i = 0; i < snapshots.size(); i++) {
+			ASSERT_EQ(scores[i], evaluate_static(snapshots[i])) << "position " << i << " threads " << threads;
+		}
+	}
+
+	batch.clear();
+	EXPECT_EQ(batch.size(), 0);
+	EXPECT_TRUE(batch.get_blocks().empty());
+}
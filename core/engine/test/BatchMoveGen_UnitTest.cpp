@@ -0,0 +1,82 @@
+#include "BatchMoveGen.h"
+#include "Game.h"
+
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <random>
+
+
+static std::vector<uint16_t> sorted_moves(std::span<const GameMoveInt> moves)
+{
+	std::vector<uint16_t> data;
+	for (const GameMoveInt& m : moves) data.push_back(m.get_data());
+	std::sort(data.begin(), data.end());
+	return data;
+}
+
+TEST(BatchMoveGen, PerftPositions) {
+	// perft depth 1 of the reference positions
+	const std::pair<const char*, int> positions[] = {
+		{ GAME_DEFAULT_FEN, 20 },
+		{ "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1", 48 },
+		{ "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1", 14 },
+		{ "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1", 6 },
+		{ "r2q1rk1/pP1p2pp/Q4n2/bbp1p3/Np6/1B3NBn/pPPP1PPP/R3K2R b KQ - 0 1", 6 },
+		{ "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8", 44 },
+		{ "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10", 46 },
+	};
+	PositionBatch batch;
+	for (const auto& [fen, nodes] : positions) ASSERT_TRUE(batch.add(fen)) << fen;
+
+	BatchMoveGen generator;
+	generator.generate(batch, false, 1);
+	ASSERT_EQ(generator.size(), batch.size());
+	uint64_t total = 0;
+	for (int i = 0; i < generator.size(); i++) {
+		EXPECT_EQ(generator.get_count(i), positions[i].second) << positions[i].first;
+		EXPECT_TRUE(generator.get_moves(i).empty());
+		total += positions[i].second;
+	}
+	EXPECT_EQ(generator.get_total_count(), total);
+}
+
+TEST(BatchMoveGen, MatchesGame) {
+	const char* fens[] = {
+		GAME_DEFAULT_FEN,
+		"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+		"r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+		"8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+		// en passant capture would uncover the king along the rank
+		"8/8/8/K2pP2r/8/8/8/4k3 w - d6 0 1",
+	};
+	// positions of random games (checks, pins, castles and en passant come up), last block partial
+	std::vector<PositionSnapshot> snapshots;
+	std::mt19937_64 rng(11);
+	for (int round = 0; round < 4; round++) {
+		for (const char* fen : fens) {
+			Game game(fen);
+			for (int ply = 0; ply < 150 && !game.get_game_has_ended(); ply++) {
+				snapshots.push_back(game.get_snapshot());
+				const std::vector<GameMove> moves = game.get_possible_moves();
+				game.move(moves[rng() % moves.size()]);
+			}
+			snapshots.push_back(game.get_snapshot());
+		}
+	}
+	PositionBatch batch;
+	for (const PositionSnapshot& snapshot : snapshots) batch.add(snapshot);
+
+	BatchMoveGen generator;
+	for (const int threads : { 1, 3 }) {
+		generator.generate(batch, true, threads);
+		ASSERT_EQ(generator.size(), static_cast<int>(snapshots.size()));
+		for (size_t i = 0; i < snapshots.size(); i++) {
+			const Game game(snapshots[i]);
+			std::vector<GameMoveInt> expected;
+			for (const GameMove& m : game.get_possible_moves()) expected.push_back(gm_to_gmi(m));
+			ASSERT_EQ(sorted_moves(generator.get_moves(static_cast<int>(i))), sorted_moves(expected)) << game.get_fen() << " threads " << threads;
+			ASSERT_EQ(generator.get_count(static_cast<int>(i)), static_cast<int>(expected.size()));
+		}
+	}
+}
@@ -51,4 +51,96 @@ TEST(GameInterface, PositionWrappers) {
 	//std::sort(vir_converted.begin(), vir_converted.end());
 	//std::sort(vpr.begin(), vpr.end());
 	EXPECT_EQ(vir_converted, vpr);
-}
\ No newline at end of file
+}
+TEST(GameInterface, SpanAccessors) {
+	std::unique_ptr<IGame> game = std::make_unique<Game>("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1");
+	game->move("e1g1");
+
+	std::array<GameMove, GAME_MAX_MOVES> moves;
+	const int n = game->get_possible_moves(moves);
+	EXPECT_EQ(std::vector<GameMove>(moves.begin(), moves.begin() + n), game->get_possible_moves());
+	// output is truncated to the buffer
+	EXPECT_EQ(game->get_possible_moves(std::span<GameMove>(moves.data(), 3)), 3);
+	EXPECT_EQ(game->get_possible_moves(std::span<GameMove>()), 0);
+
+	const int from = position_to_bindex({ 0, 7 });
+	const int n_from = game->get_possible_moves(from, moves);
+	EXPECT_EQ(std::vector<GameMove>(moves.begin(), moves.begin() + n_from), game->get_possible_moves(from));
+	std::array<int, GAME_MAX_MOVES> indices;
+	const int n_ind = game->get_possible_moves_ind(from, indices);
+	EXPECT_EQ(std::vector<int>(indices.begin(), indices.begin() + n_ind), game->get_possible_moves_ind(from));
+
+	std::array<TileI, GAME_MAX_PIECES> tiles;
+	EXPECT_EQ(game->get_all_tiles_ind(tiles), static_cast<int>(game->get_all_tiles_ind().size()));
+	std::array<TileP, GAME_MAX_CHANGED_TILES> new_tiles;
+	EXPECT_EQ(game->get_new_tiles_pos(new_tiles), 4);
+	EXPECT_EQ(std::vector<TileP>(new_tiles.begin(), new_tiles.end()), game->get_new_tiles_pos());
+	EXPECT_EQ(game->get_reverse_new_tiles_pos(new_tiles), 4);
+	EXPECT_EQ(std::vector<TileP>(new_tiles.begin(), new_tiles.end()), game->get_reverse_new_tiles_pos());
+
+	std::array<GameMove, 4> history;
+	ASSERT_EQ(game->get_all_moves(history), 1);
+	EXPECT_EQ(history[0], GameMove(4, 6));
+}
+
+class EventRecorder : public IBoardObserver
+{
+public:
+	void on_board_event(const BoardEvent& event) override { events.push_back(event); }
+	std::vector<BoardEvent> events;
+};
+
+static std::vector<TileI> event_tiles(const BoardEvent& event)
+{
+	return std::vector<TileI>(event.tiles.begin(), event.tiles.begin() + event.tile_count);
+}
+
+static bool operator==(const TileI& lhs, const TileI& rhs)
+{
+	return lhs.index == rhs.index && lhs.piece == rhs.piece && lhs.color.white == rhs.color.white;
+}
+
+TEST(GameInterface, BoardEvents) {
+	std::unique_ptr<IGame> game = std::make_unique<Game>("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1");
+	EventRecorder recorder;
+	game->add_observer(&recorder);
+	game->add_observer(&recorder);
+
+	ASSERT_EQ(game->move("e1g1"), GameState::VALID_MOVE);
+	ASSERT_EQ(recorder.events.size(), 1u);
+	const BoardEvent& castles = recorder.events.back();
+	EXPECT_EQ(castles.type, BoardEventType::MOVE);
+	EXPECT_EQ(castles.move, GameMove(4, 6));
+	EXPECT_EQ(castles.piece, Piece::KING);
+	EXPECT_EQ(castles.tile_count, 4);
+	EXPECT_EQ(event_tiles(castles), game->get_new_tiles_ind());
+
+	game->move("c7c5");
+	game->move("d5c6");
+	const BoardEvent& en_passant = recorder.events.back();
+	EXPECT_EQ(en_passant.captured, Piece::PAWN);
+	EXPECT_EQ(event_tiles(en_passant), game->get_new_tiles_ind());
+
+	const std::vector<TileI> reverse = game->get_reverse_new_tiles_ind();
+	game->undo();
+	EXPECT_EQ(recorder.events.back().type, BoardEventType::UNDO);
+	EXPECT_EQ(event_tiles(recorder.events.back()), reverse);
+
+	game->new_game();
+	EXPECT_EQ(recorder.events.back().type, BoardEventType::RESET);
+	EXPECT_EQ(recorder.events.back().tile_count, 0);
+
+	game->move("e2e4");
+	game->move("f7f6");
+	EXPECT_FALSE(recorder.events.back().check);
+	game->move("d1h5");
+	EXPECT_TRUE(recorder.events.back().check);
+
+	// clones do not inherit observers
+	std::unique_ptr<IGame> clone = game->clone();
+	const size_t count = recorder.events.size();
+	clone->move("g7g6");
+	game->remove_observer(&recorder);
+	game->move("g7g6");
+	EXPECT_EQ(recorder.events.size(), count);
+}
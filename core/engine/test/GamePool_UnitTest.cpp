@@ -0,0 +1,121 @@
+#include "GamePool.h"
+
+#include "gtest/gtest.h"
+
+#include <thread>
+
+
+TEST(GamePool, AcquireRelease) {
+	GamePool pool(2);
+	EXPECT_EQ(pool.size(), 2);
+	Game* raw = nullptr;
+	{
+		GamePool::Handle game = pool.acquire();
+		ASSERT_TRUE(game->get_init_ok());
+		EXPECT_EQ(pool.size(), 1);
+		raw = game.get();
+		game->move("e2e4");
+	}
+	EXPECT_EQ(pool.size(), 2);
+
+	// released game is handed out again and reset
+	GamePool::Handle game = pool.acquire();
+	EXPECT_EQ(game.get(), raw);
+	EXPECT_EQ(*game, Game());
+
+	// pool grows if empty
+	GamePool::Handle game2 = pool.acquire();
+	GamePool::Handle game3 = pool.acquire();
+	EXPECT_EQ(pool.size(), 0);
+}
+
+TEST(GamePool, GrowAndRelease) {
+	// games created on demand are all taken back
+	GamePool pool(1);
+	{
+		std::vector<GamePool::Handle> games;
+		for (int i = 0; i < 9; i++) games.push_back(pool.acquire());
+		EXPECT_EQ(pool.size(), 0);
+	}
+	EXPECT_EQ(pool.size(), 9);
+	pool.reserve(12);
+	EXPECT_EQ(pool.size(), 12);
+}
+
+TEST(GamePool, ResetToFen) {
+	const std::string fen = "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1";
+	GamePool pool(1);
+	{
+		GamePool::Handle game = pool.acquire();
+		game->move("d2d4");
+		game->move("d7d5");
+	}
+	GamePool::Handle game = pool.acquire(fen);
+	ASSERT_TRUE(game->get_init_ok());
+	EXPECT_EQ(*game, Game(fen));
+	EXPECT_EQ(game->get_fen(), fen);
+}
+
+TEST(GamePool, ReleaseResetsSettings) {
+	GamePool pool(1);
+	{
+		GamePool::Handle game = pool.acquire();
+		game->set_coverage_mode(CoverageMode::ON_DEMAND);
+		game->move("e2e4");
+	}
+	GamePool::Handle game = pool.acquire();
+	EXPECT_EQ(game->get_coverage_mode(), CoverageMode::INCREMENTAL);
+	EXPECT_EQ(*game, Game());
+}
+
+class EventCounter : public IBoardObserver
+{
+public:
+	void on_board_event(const BoardEvent&) override { count++; }
+	int count = 0;
+};
+
+TEST(GamePool, ReleaseDetachesObservers) {
+	GamePool pool(1);
+	EventCounter observer;
+	{
+		GamePool::Handle game = pool.acquire();
+		game->add_observer(&observer);
+		game->move("e2e4");
+	}
+	const int count = observer.count;
+	EXPECT_GT(count, 0);
+	GamePool::Handle game = pool.acquire();
+	game->move("e2e4");
+	EXPECT_EQ(observer.count, count);
+}
+
+TEST(GamePool, ThreadLocal) {
+	GamePool* main_pool = &GamePool::local();
+	GamePool* worker_pool = nullptr;
+	std::thread worker([&worker_pool]() {
+		worker_pool = &GamePool::local();
+		GamePool::Handle game = GamePool::local().acquire();
+		EXPECT_TRUE(game->get_init_ok());
+	});
+	worker.join();
+	EXPECT_NE(main_pool, worker_pool);
+}
+
+TEST(GamePool, ResetToSnapshot) {
+	Game source;
+	source.move("e2e4");
+	source.move("c7c5");
+	const PositionSnapshot snapshot = source.get_snapshot();
+
+	GamePool pool(1);
+	std::string fen;
+	std::thread worker([&pool, &fen, snapshot]() {
+		GamePool::Handle game = pool.acquire(snapshot);
+		ASSERT_TRUE(game->get_init_ok());
+		fen = game->get_fen();
+	});
+	worker.join();
+	EXPECT_EQ(fen, source.get_fen());
+	EXPECT_EQ(pool.size(), 1);
+}
@@ -0,0 +1,134 @@
+#include "GameSave.h"
+#include "Game.h"
+
+#include "gtest/gtest.h"
+
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+
+
+TEST(GameSave, BinaryRoundTrip) {
+	Game game{};
+	for (const char* uci : { "e2e4", "d7d5", "e4d5", "g8f6", "f1b5", "c7c6" }) game.move(uci);
+	const std::vector<GameTag> tags = { { "White", "Alice" }, { "Black", "Bob" } };
+
+	std::string data;
+	write_game_binary(game, tags, data);
+	EXPECT_EQ(data.size(), 4 + 6 + (1 + 5 + 2 + 5) + (1 + 5 + 2 + 3) + 2 * 6);
+
+	GameRecord record;
+	size_t consumed = 0;
+	ASSERT_TRUE(read_game_binary(data, record, &consumed));
+	EXPECT_EQ(consumed, data.size());
+	EXPECT_TRUE(record.start_fen.empty());
+	EXPECT_FALSE(record.has_result);
+	ASSERT_EQ(record.tags.size(), 2);
+	EXPECT_EQ(record.tags[1].value, "Bob");
+	EXPECT_EQ(record.moves, game.get_all_moves());
+
+	Game loaded{};
+	ASSERT_TRUE(load_game_record(record, loaded));
+	EXPECT_EQ(loaded, game);
+
+	// truncated and corrupt data
+	EXPECT_FALSE(read_game_binary(std::string_view(data).substr(0, data.size() - 1), record));
+	std::string bad_result = data;
+	bad_result[6] = 4;
+	EXPECT_FALSE(read_game_binary(bad_result, record));
+	bad_result[6] = static_cast<char>(GameEndState::END_DRAW_MAX_HALF_TURNS);
+	EXPECT_TRUE(read_game_binary(bad_result, record));
+	data[0] = 'X';
+	EXPECT_FALSE(read_game_binary(data, record));
+
+	// tags that do not fit are not cut
+	std::string unchanged;
+	EXPECT_FALSE(write_game_binary(game, { { "Annotator", std::string(0x10000, 'a') } }, unchanged));
+	EXPECT_FALSE(write_game_binary(game, std::vector<GameTag>(256, GameTag{ "Round", "1" }), unchanged));
+	EXPECT_TRUE(unchanged.empty());
+}
+
+TEST(GameSave, BinaryFenAndResult) {
+	const std::string fen = "7k/P7/8/8/8/8/8/K7 w - - 0 40";
+	Game game(fen);
+	game.move("a7a8q");
+	game.set_ending_game_state(GameEndState::WHITE_WIN_TIME);
+
+	std::string data;
+	write_game_binary(game, {}, data);
+	write_game_binary(Game(), {}, data);
+
+	GameRecord record;
+	size_t consumed = 0;
+	ASSERT_TRUE(read_game_binary(data, record, &consumed));
+	EXPECT_EQ(record.start_fen, fen);
+	ASSERT_TRUE(record.has_result);
+	EXPECT_EQ(record.result, GameEndState::WHITE_WIN_TIME);
+	ASSERT_EQ(record.moves.size(), 1);
+	EXPECT_EQ(record.moves[0].promotion, Piece::QUEEN);
+
+	Game loaded{};
+	ASSERT_TRUE(load_game_record(record, loaded));
+	EXPECT_EQ(loaded.get_fen(), game.get_fen());
+	EXPECT_EQ(loaded.get_ending_game_state(), GameEndState::WHITE_WIN_TIME);
+
+	// second game follows directly
+	ASSERT_TRUE(read_game_binary(std::string_view(data).substr(consumed), record));
+	EXPECT_TRUE(record.moves.empty());
+}
+
+TEST(GameSave, Pgn) {
+	Game game("4k3/8/8/8/8/8/8/R3K3 b Q - 0 7");
+	for (const char* uci : { "e8d7", "e1c1", "d7e6", "d1e1" }) game.move(uci);
+
+	const std::string pgn = write_game_pgn(game, { { "White", "A \"quoted\" name" }, { "Annotator", "me" } });
+	EXPECT_NE(pgn.find("[White \"A \\\"quoted\\\" name\"]\n"), std::string::npos);
+	EXPECT_NE(pgn.find("[Black \"?\"]\n"), std::string::npos);
+	EXPECT_NE(pgn.find("[Result \"*\"]\n"), std::string::npos);
+	EXPECT_NE(pgn.find("[FEN \"4k3/8/8/8/8/8/8/R3K3 b Q - 0 7\"]\n"), std::string::npos);
+	EXPECT_NE(pgn.find("[Annotator \"me\"]\n"), std::string::npos);
+	EXPECT_NE(pgn.find("\n\n7... Kd7 8. O-O-O+ Ke6 9. Re1+ *\n"), std::string::npos);
+
+	Game loaded{};
+	ASSERT_TRUE(load_game_pgn(pgn, loaded));
+	EXPECT_EQ(loaded.get_fen(), game.get_fen());
+
+	// long games are wrapped
+	Game long_game{};
+	for (int i = 0; i < 10; i++) {
+		for (const char* uci : { "g1f3", "g8f6", "f3g1", "f6g8" }) long_game.move(uci);
+	}
+	const std::string long_pgn = write_game_pgn(long_game);
+	size_t line_begin = long_pgn.find("\n\n") + 2;
+	while (line_begin < long_pgn.size()) {
+		const size_t line_end = long_pgn.find('\n', line_begin);
+		EXPECT_LT(line_end - line_begin, 80);
+		line_begin = line_end + 1;
+	}
+	ASSERT_TRUE(load_game_pgn(long_pgn, loaded));
+	EXPECT_EQ(loaded.get_all_moves(), long_game.get_all_moves());
+}
+
+TEST(GameSave, BackgroundWriter) {
+	const std::string path = "game_save_test.bin";
+	Game game{};
+	game.move("e2e4");
+	std::string data;
+	write_game_binary(game, {}, data);
+	{
+		GameSaveWriter writer;
+		writer.save(path, data);
+		writer.save("missing_directory/game.bin", data);
+		writer.flush();
+		const std::vector<GameSaveResult> results = writer.take_results();
+		ASSERT_EQ(results.size(), 2);
+		EXPECT_TRUE(results[0].ok);
+		EXPECT_FALSE(results[1].ok);
+		EXPECT_TRUE(writer.take_results().empty());
+	}
+	std::ifstream file(path, std::ios::binary);
+	const std::string written((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+	file.close();
+	EXPECT_EQ(written, data);
+	std::remove(path.c_str());
+}
@@ -0,0 +1,34 @@
+#include "Game.h"
+#include "GameStats.h"
+
+#include "gtest/gtest.h"
+
+
+TEST(GameStats, Counters) {
+	reset_game_stats();
+	Game game;
+	game.move("e2e4");
+	game.move("e7e5");
+	game.undo();
+	const GameStats stats = get_game_stats();
+
+	if (!game_stats_enabled()) {
+		// disabled builds report nothing
+		for (const GameStatCounter& counter : stats.counters) EXPECT_EQ(counter.calls, 0u);
+		return;
+	}
+	// constructor and two moves, undo restores from the cache
+	EXPECT_EQ(stats[GameStatId::FIND_LEGAL_MOVES].calls, 3u);
+	EXPECT_EQ(stats[GameStatId::FIND_PINNED_PIECES].calls, 3u);
+	EXPECT_EQ(stats.legal_states_restored, 1u);
+	EXPECT_EQ(stats[GameStatId::APPLY_GAMEDELTA].calls, 2u);
+	EXPECT_EQ(stats[GameStatId::UNDO_GAMEDELTA].calls, 1u);
+	EXPECT_EQ(stats[GameStatId::UPDATE_COVERAGE].calls, 3u);
+	EXPECT_GT(stats.coverage_ids_recomputed, 0u);
+	// e2e4 opens the rays of the f1 bishop and the d1 queen
+	EXPECT_GT(stats.coverage_rays_recomputed, 0u);
+	EXPECT_GT(stats[GameStatId::FIND_LEGAL_MOVES].cycles, 0u);
+
+	reset_game_stats();
+	EXPECT_EQ(get_game_stats()[GameStatId::FIND_LEGAL_MOVES].calls, 0u);
+}
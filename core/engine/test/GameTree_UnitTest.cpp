@@ -0,0 +1,95 @@
+#include "GameTree.h"
+
+#include "gtest/gtest.h"
+
+#include <string>
+
+
+static std::string fen_of(const Game& game)
+{
+	char fen[GAME_FEN_LEN_MAX];
+	game.to_fen(fen, GAME_FEN_LEN_MAX);
+	return fen;
+}
+
+TEST(GameTree, Variations) {
+	Game game;
+	GameTree tree(game);
+	EXPECT_EQ(tree.size(), 1);
+
+	const uint32_t e4 = tree.play("e2e4");
+	const uint32_t e5 = tree.play("e7e5");
+	const uint32_t nf3 = tree.play("g1f3");
+	ASSERT_NE(nf3, GAME_TREE_NO_NODE);
+	EXPECT_EQ(tree.play("e1e3"), GAME_TREE_NO_NODE);
+	EXPECT_EQ(tree.get_current(), nf3);
+
+	// sideline from the position after e4
+	ASSERT_TRUE(tree.go_to(e4));
+	const uint32_t c5 = tree.play("c7c5");
+	const uint32_t nf3_sicilian = tree.play("g1f3");
+	EXPECT_EQ(tree.size(), 6);
+	EXPECT_EQ(tree.get_node(e4).first_child, e5);
+	EXPECT_EQ(tree.get_node(e5).next_sibling, c5);
+	EXPECT_EQ(tree.get_node(nf3_sicilian).depth, 3u);
+
+	// switching lines only replays the differing moves
+	ASSERT_TRUE(tree.go_to(nf3));
+	Game main_line;
+	main_line.move("e2e4");
+	main_line.move("e7e5");
+	main_line.move("g1f3");
+	EXPECT_EQ(fen_of(game), fen_of(main_line));
+	EXPECT_EQ(game.get_possible_moves(), main_line.get_possible_moves());
+	EXPECT_EQ(game.get_all_moves(), main_line.get_all_moves());
+
+	// existing moves are followed instead of duplicated
+	ASSERT_TRUE(tree.go_to(e4));
+	EXPECT_EQ(tree.play("c7c5"), c5);
+	EXPECT_EQ(tree.size(), 6);
+	EXPECT_EQ(fen_of(game), "rnbqkbnr/pp1ppppp/8/2p5/4P3/8/PPPP1PPP/RNBQKBNR w KQkq c6 0 2");
+
+	tree.promote(c5);
+	EXPECT_EQ(tree.get_node(e4).first_child, c5);
+	EXPECT_EQ(tree.get_node(c5).next_sibling, e5);
+	EXPECT_EQ(tree.get_node(e5).next_sibling, GAME_TREE_NO_NODE);
+
+	ASSERT_TRUE(tree.go_to(tree.get_root()));
+	EXPECT_EQ(game, Game());
+	EXPECT_FALSE(tree.go_to(100));
+}
+
+TEST(GameTree, ReplayMatchesGame) {
+	// two long lines that split early, walking between their leaves has to rebuild the exact game
+	Game game;
+	GameTree tree(game);
+	Game a;
+	Game b;
+	const uint32_t d4 = tree.play("d2d4");
+	a.move("d2d4");
+	b.move("d2d4");
+	const char* line_a[] = { "d7d5", "c2c4", "d5c4", "e2e4", "b7b5", "a2a4", "c7c6", "a4b5", "c6b5", "b2b3", "c4b3", "d1b3" };
+	const char* line_b[] = { "g8f6", "c2c4", "e7e6", "b1c3", "f8b4", "e2e3", "e8g8", "f1d3", "d7d5", "g1f3", "c7c5", "e1g1" };
+
+	uint32_t leaf_a = GAME_TREE_NO_NODE;
+	for (const char* m : line_a) {
+		leaf_a = tree.play(m);
+		ASSERT_NE(leaf_a, GAME_TREE_NO_NODE) << m;
+		a.move(m);
+	}
+	ASSERT_TRUE(tree.go_to(d4));
+	uint32_t leaf_b = GAME_TREE_NO_NODE;
+	for (const char* m : line_b) {
+		leaf_b = tree.play(m);
+		ASSERT_NE(leaf_b, GAME_TREE_NO_NODE) << m;
+		b.move(m);
+	}
+	EXPECT_EQ(game, b);
+	ASSERT_TRUE(tree.go_to(leaf_a));
+	EXPECT_EQ(game, a);
+	EXPECT_EQ(game.get_hash(), a.get_hash());
+	ASSERT_TRUE(tree.go_to(leaf_b));
+	EXPECT_EQ(game, b);
+	EXPECT_EQ(tree.get_move(d4), tree.get_move(tree.find_child(tree.get_root(), GameMove(11, 27))));
+	EXPECT_EQ(tree.size(), 2 + 12 + 12);
+}
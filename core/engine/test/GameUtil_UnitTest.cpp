@@ -125,4 +125,51 @@ TEST(GameUtil, ChessBoardApplyUndoInvariance) {
 	board2.apply_gamedelta(gd);
 	board2.undo_gamedelta(gd);
 	EXPECT_EQ(board, board2);
-}
\ No newline at end of file
+}
+TEST(GameUtil, ChessBoardIncrementalCoverage) {
+	ChessBoard board;
+	// e4 d5 Bc4 Qd6 Qf3: opens and closes bishop and queen rays
+	const std::vector<GameDelta> deltas = {
+		GameDelta(GameMove{ 12,28 }), GameDelta(GameMove{ 51,35 }), GameDelta(GameMove{ 5,26 }),
+		GameDelta(GameMove{ 59,43 }), GameDelta(GameMove{ 3,21 }),
+	};
+	for (const GameDelta& gd : deltas) {
+		board.apply_gamedelta(gd);
+		ChessBoard fresh;
+		fresh.set_placement(board.get_placement());
+		EXPECT_EQ(board, fresh);
+	}
+	for (auto it = deltas.rbegin(); it != deltas.rend(); ++it) board.undo_gamedelta(*it);
+	EXPECT_EQ(board, ChessBoard());
+}
+
+TEST(GameUtil, ChessBoardOnDemandCoverage) {
+	const char* fens[] = {
+		"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR",
+		"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R",
+		// sliders see through the king of the other color
+		"3rk3/8/8/1b6/8/8/4K3/8",
+	};
+	for (const char* fen : fens) {
+		ChessBoard incremental;
+		ASSERT_TRUE(incremental.new_board(fen).ok()) << fen;
+		ChessBoard on_demand = incremental;
+		on_demand.set_coverage_mode(CoverageMode::ON_DEMAND);
+		EXPECT_EQ(on_demand.get_coverage_mode(), CoverageMode::ON_DEMAND);
+		for (int index = 0; index < GAME_BOARD_SIZE; index++) {
+			EXPECT_EQ(on_demand.is_covered(index), incremental.is_covered(index)) << fen << " " << index;
+			EXPECT_EQ(on_demand.get_cover_count(index), incremental.get_cover_count(index)) << fen << " " << index;
+			EXPECT_EQ(on_demand.get_first_cover_id(index), incremental.get_first_cover_id(index)) << fen << " " << index;
+			for (const int color_off : { 0, GAME_BLACK_ID_OFFSET }) {
+				EXPECT_EQ(on_demand.is_covered_color(index, color_off), incremental.is_covered_color(index, color_off));
+				EXPECT_EQ(on_demand.get_cover_count_color(index, color_off), incremental.get_cover_count_color(index, color_off));
+				EXPECT_EQ(on_demand.get_first_cover_id_color(index, color_off), incremental.get_first_cover_id_color(index, color_off));
+			}
+		}
+		// back to incremental after moves without coverage updates
+		on_demand.apply_gamedelta(GameDelta(GameMove{ 12,20 }));
+		incremental.apply_gamedelta(GameDelta(GameMove{ 12,20 }));
+		on_demand.set_coverage_mode(CoverageMode::INCREMENTAL);
+		EXPECT_EQ(on_demand, incremental) << fen;
+	}
+}
@@ -6,6 +6,8 @@
 #include <vector>
 #include <string>
 #include <algorithm>
+#include <random>
+#include <unordered_set>
 
 
 TEST(GameTest, DefaultConstructor) {
@@ -128,6 +130,125 @@ TEST(GameTest, MoveArgument) {
 	EXPECT_EQ(game.move("a1b9"), GameState::INVALID_MOVE);
 }
 
+TEST(GameTest, SanMoves) {
+	Game game{};
+	for (const char* san : { "e4", "e5", "Nf3", "Nc6", "Bb5", "a6", "Bxc6", "dxc6", "O-O", "Bg4" }) {
+		ASSERT_EQ(game.move(san, GameMoveStrFmt::SAN), GameState::VALID_MOVE) << san;
+	}
+	EXPECT_EQ(game.get_fen(), "r2qkbnr/1pp2ppp/p1p5/4p3/4P1b1/5N2/PPPP1PPP/RNBQ1RK1 w kq - 2 6");
+	EXPECT_EQ(game.move("Qh5", GameMoveStrFmt::SAN), GameState::INVALID_MOVE);
+	EXPECT_EQ(game.move("Nxe5", GameMoveStrFmt::SAN), GameState::VALID_MOVE);
+
+	// disambiguation by file, rank and square
+	const std::string rooks = "4k3/8/8/8/R7/8/4K3/R6R w - - 0 1";
+	for (const char* san : { "Rb1", "Ra2", "Rxb1", "Rz1", "R9a2", "a1" }) {
+		Game ambiguous(rooks);
+		EXPECT_EQ(ambiguous.move(san, GameMoveStrFmt::SAN), GameState::INVALID_MOVE) << san;
+	}
+	for (const char* san : { "Rab1", "Rhb1", "R1a2", "R4a2", "Ra1a2", "Rh1-h5+", "Ra4a8+!" }) {
+		Game unambiguous(rooks);
+		EXPECT_EQ(unambiguous.move(san, GameMoveStrFmt::SAN), GameState::VALID_MOVE) << san;
+	}
+
+	// promotion with and without '=' and annotation glyphs
+	const std::string promotion = "8/P3k3/8/8/8/8/4K3/8 w - - 0 1";
+	for (const char* san : { "a8", "a8=K", "a8=P", "b8=Q" }) {
+		Game invalid(promotion);
+		EXPECT_EQ(invalid.move(san, GameMoveStrFmt::SAN), GameState::INVALID_MOVE) << san;
+	}
+	Game queen(promotion);
+	EXPECT_EQ(queen.move("a8=Q!?", GameMoveStrFmt::SAN), GameState::VALID_MOVE);
+	EXPECT_EQ(queen.get_fen(), "Q7/4k3/8/8/8/8/4K3/8 b - - 0 1");
+	Game knight(promotion);
+	EXPECT_EQ(knight.move("a8N", GameMoveStrFmt::SAN), GameState::VALID_MOVE);
+	EXPECT_EQ(knight.get_fen(), "N7/4k3/8/8/8/8/4K3/8 b - - 0 1");
+
+	// castles in both notations
+	Game castles("r3k2r/8/8/8/8/8/8/R3K2R w KQkq - 0 1");
+	EXPECT_EQ(castles.move("O-O-O", GameMoveStrFmt::SAN), GameState::VALID_MOVE);
+	EXPECT_EQ(castles.move("0-0+", GameMoveStrFmt::SAN), GameState::VALID_MOVE);
+	EXPECT_EQ(castles.get_fen(), "r4rk1/8/8/8/8/8/8/2KR3R w - - 2 2");
+	EXPECT_EQ(castles.move("O-O", GameMoveStrFmt::SAN), GameState::INVALID_MOVE);
+
+	// en passant
+	Game ep("4k3/8/8/3pP3/8/8/8/4K3 w - d6 0 2");
+	EXPECT_EQ(ep.move("exd6", GameMoveStrFmt::SAN), GameState::VALID_MOVE);
+	EXPECT_EQ(ep.get_fen(), "4k3/8/3P4/8/8/8/8/4K3 b - - 0 2");
+}
+
+static std::vector<std::string> possible_moves_str(const Game& game, GameMoveStrFmt fmt)
+{
+	std::array<MoveStr, GAME_MAX_MOVES> moves;
+	const int number_of_moves = game.get_possible_moves_str(moves, fmt);
+	std::vector<std::string> vret;
+	for (int i = 0; i < number_of_moves; i++) vret.emplace_back(moves[i].data());
+	return vret;
+}
+
+static bool contains(const std::vector<std::string>& moves, const std::string& move)
+{
+	return std::find(moves.begin(), moves.end(), move) != moves.end();
+}
+
+TEST(GameTest, MoveNotation) {
+	const std::vector<std::string> start = possible_moves_str(Game(), GameMoveStrFmt::SAN);
+	EXPECT_EQ(start.size(), 20);
+	EXPECT_TRUE(contains(start, "e4"));
+	EXPECT_TRUE(contains(start, "Na3"));
+
+	// disambiguation by file, rank and square
+	const std::vector<std::string> rooks = possible_moves_str(Game("4k3/8/8/8/R7/8/4K3/R6R w - - 0 1"), GameMoveStrFmt::SAN);
+	for (const char* san : { "Rab1", "Rhb1", "R1a2", "R4a2", "Ra8+", "Rh8+" }) EXPECT_TRUE(contains(rooks, san)) << san;
+	const std::vector<std::string> queens = possible_moves_str(Game("4k3/8/8/8/8/Q7/8/Q1Q1K3 w - - 0 1"), GameMoveStrFmt::SAN);
+	for (const char* san : { "Qa1b2", "Q3b2", "Qcb2", "Qd2" }) EXPECT_TRUE(contains(queens, san)) << san;
+
+	// direct, discovered, castle and promotion checks
+	const std::vector<std::string> discovered = possible_moves_str(Game("4k3/8/8/8/4N3/8/8/4R1K1 w - - 0 1"), GameMoveStrFmt::SAN);
+	for (const char* san : { "Nc3+", "Nf6+", "Nd6+", "Kh1" }) EXPECT_TRUE(contains(discovered, san)) << san;
+	EXPECT_TRUE(contains(possible_moves_str(Game("5k2/8/8/8/8/8/8/4K2R w K - 0 1"), GameMoveStrFmt::SAN), "O-O+"));
+	const std::vector<std::string> promotion = possible_moves_str(Game("7k/P7/8/8/8/8/8/K7 w - - 0 1"), GameMoveStrFmt::LAN);
+	for (const char* lan : { "a7-a8=Q+", "a7-a8=R+", "a7-a8=B", "a7-a8=N", "Ka1-b2" }) EXPECT_TRUE(contains(promotion, lan)) << lan;
+
+	// history
+	Game game{};
+	for (const char* san : { "f3", "e5", "g4", "Qh4" }) game.move(san, GameMoveStrFmt::SAN);
+	EXPECT_EQ(game.get_all_moves_str(GameMoveStrFmt::SAN), (std::vector<std::string>{ "f3", "e5", "g4", "Qh4#" }));
+	EXPECT_EQ(game.get_all_moves_str(GameMoveStrFmt::LAN), (std::vector<std::string>{ "f2-f3", "e7-e5", "g2-g4", "Qd8-h4#" }));
+	EXPECT_EQ(game.get_last_move_str(GameMoveStrFmt::UCI), "d8h4");
+	char movetext[64];
+	EXPECT_EQ(game.to_movetext(movetext, sizeof(movetext), GameMoveStrFmt::SAN), 19);
+	EXPECT_STREQ(movetext, "1. f3 e5 2. g4 Qh4#");
+	EXPECT_EQ(game.to_movetext(movetext, 19, GameMoveStrFmt::SAN), 0);
+
+	Game black("rnbqkbnr/pppppppp/8/8/4P3/8/PPPP1PPP/RNBQKBNR b KQkq e3 0 5");
+	black.move("e7e5");
+	black.move("g1f3");
+	EXPECT_EQ(black.to_movetext(movetext, sizeof(movetext), GameMoveStrFmt::SAN), 14);
+	EXPECT_STREQ(movetext, "5... e5 6. Nf3");
+}
+
+TEST(GameTest, MoveNotationRoundTrip) {
+	for (const char* fen : {
+		"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+		"8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+		"r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+		"rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+		"4k3/8/8/2pP4/8/8/8/4K3 w - c6 0 2" }) {
+		const Game game(fen);
+		const std::vector<std::string> uci = possible_moves_str(game, GameMoveStrFmt::UCI);
+		for (GameMoveStrFmt fmt : { GameMoveStrFmt::SAN, GameMoveStrFmt::LAN }) {
+			const std::vector<std::string> moves = possible_moves_str(game, fmt);
+			ASSERT_EQ(moves.size(), uci.size());
+			for (size_t i = 0; i < moves.size(); i++) {
+				Game copy(game);
+				ASSERT_NE(copy.move(moves[i], fmt), GameState::INVALID_MOVE) << fen << " " << moves[i];
+				EXPECT_EQ(copy.get_last_move_str(GameMoveStrFmt::UCI), uci[i]) << fen << " " << moves[i];
+				EXPECT_EQ(copy.get_is_check(), moves[i].back() == '+') << fen << " " << moves[i];
+			}
+		}
+	}
+}
+
 TEST(GameTest, MoveUndoInvariance) {
 	std::ifstream dataset("test/legal_data.csv");
 	ASSERT_TRUE(dataset.is_open());
@@ -230,3 +351,357 @@ TEST(GameTest, Perft) {
 	EXPECT_EQ(game6.perft(4), 3894594ULL);
 	//EXPECT_EQ(game6.perft(5), 164075551ULL);
 }
+
+TEST(GameTest, CoverageModes) {
+	const char* fens[] = {
+		"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+		"8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+		"r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+	};
+	for (const char* fen : fens) {
+		Game incremental(fen);
+		Game on_demand(fen);
+		on_demand.set_coverage_mode(CoverageMode::ON_DEMAND);
+		EXPECT_EQ(on_demand.perft(3), incremental.perft(3)) << fen;
+
+		// apply and undo leave no coverage behind
+		Game fresh(fen);
+		fresh.set_coverage_mode(CoverageMode::ON_DEMAND);
+		for (const GameMove& m : fresh.get_possible_moves()) {
+			on_demand.move(m);
+			on_demand.undo();
+			EXPECT_EQ(on_demand, fresh) << fen << " " << m.from << " " << m.to;
+		}
+	}
+	// the mode survives copies and new games
+	Game game;
+	game.set_coverage_mode(CoverageMode::ON_DEMAND);
+	game.move("e2e4");
+	game.new_game();
+	EXPECT_EQ(Game(game).get_coverage_mode(), CoverageMode::ON_DEMAND);
+	EXPECT_EQ(game.perft(3), 8902ULL);
+}
+
+TEST(GameTest, FenRoundTrip) {
+	const std::vector<std::string> fens = {
+		"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+		"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+		"8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+		"r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+		"rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+		"rnbqkbnr/pppppppp/8/8/4P3/8/PPPP1PPP/RNBQKBNR b KQkq e3 0 1",
+		"7k/8/8/1PpP4/1K6/8/8/8 w - c6 0 300",
+	};
+	for (const std::string& fen : fens) {
+		Game game(fen);
+		ASSERT_TRUE(game.get_init_ok()) << fen;
+		EXPECT_EQ(game.get_fen(), fen);
+	}
+
+	// fen after a move matches the fen of the reached position
+	Game game{};
+	game.move("e2e4");
+	EXPECT_EQ(game.get_fen(), "rnbqkbnr/pppppppp/8/8/4P3/8/PPPP1PPP/RNBQKBNR b KQkq e3 0 1");
+	Game game_from_fen(game.get_fen());
+	EXPECT_EQ(game.get_possible_moves(), game_from_fen.get_possible_moves());
+
+	// buffer too small
+	char buffer[8];
+	EXPECT_EQ(game.to_fen(buffer, sizeof(buffer)), 0);
+}
+
+TEST(GameTest, FenErrors) {
+	struct FenCase { std::string fen; FenError error; int offset; };
+	const std::vector<FenCase> cases = {
+		{ "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0", FenError::MISSING_SECTION, 54 },
+		{ "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1 ", FenError::TRAILING_CHARACTERS, 56 },
+		{ "rnbqkbnr/ppppxppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", FenError::BOARD_INVALID_CHAR, 13 },
+		{ "rnbqkbnr/ppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", FenError::BOARD_RANK_SIZE, 16 },
+		{ "rnbqkbnr/pppppppp/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", FenError::BOARD_RANK_COUNT, 41 },
+		{ "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQ1BNR w KQkq - 0 1", FenError::BOARD_KING_COUNT, 43 },
+		{ "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQQBNR w KQkq - 0 1", FenError::BOARD_PIECE_COUNT, 42 },
+		{ "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR x KQkq - 0 1", FenError::ACTIVE_COLOR, 44 },
+		{ "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkx - 0 1", FenError::CASTLES, 46 },
+		{ "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq e4 0 1", FenError::EN_PASSANT, 51 },
+		{ "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 256 1", FenError::HALF_TURNS, 53 },
+		{ "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 a", FenError::TURN_NUMBER, 55 },
+		{ "8/8/8/8/8/8/8/Kk6 w - - 0 1", FenError::KINGS_ADJACENT, 0 },
+	};
+	for (const FenCase& c : cases) {
+		Game game(c.fen);
+		EXPECT_FALSE(game.get_init_ok()) << c.fen;
+		EXPECT_EQ(game.get_fen_result().error, c.error) << c.fen;
+		EXPECT_EQ(game.get_fen_result().offset, c.offset) << c.fen;
+	}
+
+	Game game{};
+	game.new_game("8/8/8/8/8/8/8/Kk6 w - - 0 1");
+	EXPECT_FALSE(game.get_init_ok());
+	game.new_game();
+	EXPECT_TRUE(game.get_init_ok());
+}
+
+TEST(GameTest, SeekAndRedo) {
+	// deterministic pseudo random game that is long enough for several checkpoints
+	Game game;
+	std::vector<std::string> fens;
+	std::vector<GameMove> moves;
+	char fen[GAME_FEN_LEN_MAX];
+	uint32_t rng = 12345;
+	for (int ply = 0; ply < 150; ply++) {
+		game.to_fen(fen, GAME_FEN_LEN_MAX);
+		fens.push_back(fen);
+		const std::vector<GameMove> legal = game.get_possible_moves();
+		if (legal.empty()) break;
+		rng = rng * 1664525u + 1013904223u;
+		moves.push_back(legal[(rng >> 16) % legal.size()]);
+		if (game.move(moves.back()) == GameState::GAME_HAS_ENDED) break;
+	}
+	const int plies = static_cast<int>(moves.size());
+	if (static_cast<int>(fens.size()) == plies) {
+		game.to_fen(fen, GAME_FEN_LEN_MAX);
+		fens.push_back(fen);
+	}
+	ASSERT_GT(plies, 3 * GAME_CHECKPOINT_INTERVAL);
+	EXPECT_EQ(game.get_ply(), plies);
+
+	EXPECT_FALSE(game.seek(-1));
+	EXPECT_FALSE(game.seek(plies + 1));
+	EXPECT_EQ(game.redo(), GameState::INVALID_MOVE);
+
+	for (const int target : { 0, plies, 37, 36, 1, plies - 5, 2 * GAME_CHECKPOINT_INTERVAL, 17, plies / 2 }) {
+		ASSERT_TRUE(game.seek(target));
+		EXPECT_EQ(game.get_ply(), target);
+		EXPECT_EQ(game.get_ply_count(), plies);
+		game.to_fen(fen, GAME_FEN_LEN_MAX);
+		EXPECT_EQ(std::string(fen), fens[target]) << "seek " << target;
+
+		Game replay;
+		for (int i = 0; i < target; i++) replay.move(moves[i]);
+		EXPECT_EQ(game, replay) << "seek " << target;
+		EXPECT_EQ(game.get_hash(), replay.get_hash()) << "seek " << target;
+	}
+
+	// undo and redo walk along the same line
+	ASSERT_TRUE(game.seek(20));
+	game.undo();
+	game.undo();
+	EXPECT_EQ(game.get_ply(), 18);
+	EXPECT_NE(game.redo(), GameState::INVALID_MOVE);
+	EXPECT_EQ(game.get_ply(), 19);
+	game.to_fen(fen, GAME_FEN_LEN_MAX);
+	EXPECT_EQ(std::string(fen), fens[19]);
+
+	// replaying the next move keeps the line, a different move drops it
+	EXPECT_NE(game.move(moves[19]), GameState::INVALID_MOVE);
+	EXPECT_EQ(game.get_ply_count(), plies);
+	const std::vector<GameMove> legal = game.get_possible_moves();
+	const auto other = std::find_if(legal.begin(), legal.end(), [&](const GameMove& m) { return !(m == moves[20]); });
+	ASSERT_NE(other, legal.end());
+	EXPECT_NE(game.move(*other), GameState::INVALID_MOVE);
+	EXPECT_EQ(game.get_ply_count(), 21);
+	EXPECT_EQ(game.redo(), GameState::INVALID_MOVE);
+
+	// checkpoints of the dropped line are not reused
+	ASSERT_TRUE(game.seek(0));
+	ASSERT_TRUE(game.seek(21));
+	Game replay;
+	for (int i = 0; i < 20; i++) replay.move(moves[i]);
+	replay.move(*other);
+	EXPECT_EQ(game, replay);
+
+	// new games start without history
+	game.new_game();
+	EXPECT_EQ(game.get_ply_count(), 0);
+	EXPECT_TRUE(game.seek(0));
+	EXPECT_FALSE(game.seek(1));
+}
+
+TEST(GameTest, LegalStateStack) {
+	// undo restores the cached legal moves and pins, they have to match a game that generated them by replaying the line
+	std::mt19937_64 rng(7);
+	Game game;
+	std::vector<GameMove> line;
+	for (int step = 0; step < 400; step++) {
+		const uint64_t action = rng() % 8;
+		if (action < 2 && game.get_ply() > 0) {
+			game.undo();
+			line.pop_back();
+		}
+		else if (action == 2 && game.get_ply_count() > game.get_ply()) {
+			ASSERT_NE(game.redo(), GameState::INVALID_MOVE);
+			line.push_back(game.get_last_move());
+		}
+		else if (action == 3) {
+			const int target = static_cast<int>(rng() % (game.get_ply() + 1));
+			ASSERT_TRUE(game.seek(target));
+			line.resize(target);
+		}
+		else if (!game.get_game_has_ended()) {
+			const std::vector<GameMove> legal = game.get_possible_moves();
+			line.push_back(legal[rng() % legal.size()]);
+			ASSERT_NE(game.move(line.back()), GameState::INVALID_MOVE);
+		}
+
+		Game replay;
+		for (const GameMove& m : line) replay.move(m);
+		ASSERT_EQ(game, replay) << "step " << step;
+	}
+}
+
+TEST(GameTest, Snapshot) {
+	std::ifstream dataset("test/legal_data.csv");
+	ASSERT_TRUE(dataset.is_open());
+	std::string line;
+	while (std::getline(dataset, line)) {
+		const size_t fen_begin = line.find(',') + 1;
+		const std::string fen = line.substr(fen_begin, line.find(',', fen_begin) - fen_begin);
+		Game game(fen);
+		ASSERT_TRUE(game.get_init_ok()) << fen;
+
+		const PositionSnapshot snapshot = game.get_snapshot();
+		const Game copy(snapshot);
+		ASSERT_TRUE(copy.get_init_ok()) << fen;
+		EXPECT_EQ(copy.get_fen(), fen);
+		EXPECT_EQ(copy.get_hash(), game.get_hash()) << fen;
+		std::vector<std::string> expected = game.get_possible_moves_str();
+		std::vector<std::string> actual = copy.get_possible_moves_str();
+		std::sort(expected.begin(), expected.end());
+		std::sort(actual.begin(), actual.end());
+		EXPECT_EQ(actual, expected) << fen;
+	}
+
+	// en passant and clocks survive, the history does not
+	Game game;
+	game.move("e2e4");
+	game.move("g8f6");
+	game.move("e4e5");
+	game.move("d7d5");
+	Game copy(game.get_snapshot());
+	EXPECT_EQ(copy.get_fen(), game.get_fen());
+	EXPECT_NE(copy.move("e5d6"), GameState::INVALID_MOVE);
+	EXPECT_EQ(copy.get_all_moves().size(), 1u);
+
+	copy.new_game(Game().get_snapshot());
+	EXPECT_EQ(copy, Game());
+
+	PositionSnapshot no_king = Game().get_snapshot();
+	no_king.board[2] = 0;
+	EXPECT_FALSE(Game(no_king).get_init_ok());
+	EXPECT_EQ(Game(no_king).get_fen_result().error, FenError::BOARD_KING_COUNT);
+
+	// the en passant pawn has to be a pawn of the passive color that just advanced two squares
+	const PositionSnapshot after_e4 = Game("rnbqkbnr/pppppppp/8/8/4P3/8/PPPP1PPP/RNBQKBNR b KQkq e3 0 1").get_snapshot();
+	EXPECT_TRUE(Game(after_e4).get_init_ok());
+	for (const int p2_index : { 100, -2, 20, 12, 27, 36, 52 }) {
+		PositionSnapshot bad_p2 = after_e4;
+		bad_p2.p2_index = static_cast<int8_t>(p2_index);
+		EXPECT_FALSE(Game(bad_p2).get_init_ok()) << p2_index;
+		EXPECT_EQ(Game(bad_p2).get_fen_result().error, FenError::EN_PASSANT) << p2_index;
+	}
+	PositionSnapshot white_to_move = after_e4;
+	white_to_move.black_to_move = 0;
+	EXPECT_FALSE(Game(white_to_move).get_init_ok());
+}
+
+TEST(GameTest, PackedBoard) {
+	std::ifstream dataset("test/legal_data.csv");
+	ASSERT_TRUE(dataset.is_open());
+	std::unordered_set<PackedBoard, PackedBoardHash> positions;
+	std::string line;
+	int count = 0;
+	while (std::getline(dataset, line)) {
+		const size_t fen_begin = line.find(',') + 1;
+		const std::string fen = line.substr(fen_begin, line.find(',', fen_begin) - fen_begin);
+		const Game game(fen);
+		ASSERT_TRUE(game.get_init_ok()) << fen;
+
+		const PackedBoard packed = game.get_packed();
+		const Game copy(packed);
+		ASSERT_TRUE(copy.get_init_ok()) << fen;
+		EXPECT_EQ(copy.get_fen(), fen);
+		EXPECT_EQ(copy.get_hash(), game.get_hash()) << fen;
+		EXPECT_EQ(copy.get_packed(), packed);
+		EXPECT_EQ(pack_snapshot(game.get_snapshot()), packed) << fen;
+		const PositionSnapshot snapshot = unpack_snapshot(packed);
+		EXPECT_EQ(snapshot.board, game.get_snapshot().board) << fen;
+		positions.insert(packed);
+		count++;
+	}
+	EXPECT_EQ(positions.size(), static_cast<size_t>(count));
+
+	// transpositions pack and hash alike, the side to move does not
+	Game a;
+	Game b;
+	for (const char* move : { "g1f3", "g8f6", "b1c3" }) a.move(move);
+	for (const char* move : { "b1c3", "g8f6", "g1f3" }) b.move(move);
+	EXPECT_EQ(a.get_packed(), b.get_packed());
+	EXPECT_EQ(packed_hash(a.get_packed()), packed_hash(b.get_packed()));
+	b.move("f6g8");
+	EXPECT_NE(a.get_packed(), b.get_packed());
+	Game reset;
+	reset.new_game(a.get_packed());
+	EXPECT_EQ(reset.get_fen(), a.get_fen());
+
+	// empty code on the occupied e1 (fifth occupied square)
+	PackedBoard broken = Game().get_packed();
+	broken.pieces[2] &= 0xF0;
+	EXPECT_FALSE(Game(broken).get_init_ok());
+	EXPECT_EQ(Game(broken).get_fen_result().error, FenError::BOARD_INVALID_CHAR);
+
+	// en passant index off the board or on a square without a pawn that just advanced two squares
+	const PackedBoard after_e4 = Game("rnbqkbnr/pppppppp/8/8/4P3/8/PPPP1PPP/RNBQKBNR b KQkq e3 0 1").get_packed();
+	EXPECT_TRUE(Game(after_e4).get_init_ok());
+	for (const int p2_index : { 100, 20, 36 }) {
+		PackedBoard bad_p2 = after_e4;
+		bad_p2.p2_index = static_cast<int8_t>(p2_index);
+		EXPECT_FALSE(Game(bad_p2).get_init_ok()) << p2_index;
+		Game pooled;
+		pooled.new_game(bad_p2);
+		EXPECT_FALSE(pooled.get_init_ok()) << p2_index;
+		EXPECT_EQ(pooled.get_fen_result().error, FenError::EN_PASSANT) << p2_index;
+	}
+}
+
+TEST(GameTest, StaticExchange) {
+	struct SeeCase { const char* fen; GameMove move; int value; };
+	const SeeCase cases[] = {
+		// undefended pawn
+		{ "1k1r4/1pp4p/p7/4p3/8/P5P1/1PP4P/2K1R3 w - - 0 1", GameMove(4, 36), 100 },
+		// knight for pawn, x-rays of both queens
+		{ "1k1r3q/1ppn3p/p4b2/4p3/8/P2N2P1/1PP1R1BP/2K1Q3 w - - 0 1", GameMove(19, 36), -220 },
+		// doubled rooks on both sides
+		{ "3rk3/3r4/8/3p4/8/8/3R4/3RK3 w - - 0 1", GameMove(11, 35), -400 },
+		// quiet move into a pawn
+		{ "4k3/8/8/3p4/8/8/8/4K2Q w - - 0 1", GameMove(7, 28), -900 },
+		// the king recaptures only if the square is not defended any more
+		{ "3rk3/8/8/8/8/8/3q4/3RK3 w - - 0 1", GameMove(3, 11), 900 },
+		{ "3rk3/8/8/b7/8/8/3q4/3RK3 w - - 0 1", GameMove(3, 11), 400 },
+		{ "4k3/8/8/3pP3/8/8/8/4K3 w - d6 0 1", GameMove(36, 43), 100 },
+	};
+	for (const SeeCase& c : cases) {
+		Game game(c.fen);
+		ASSERT_TRUE(game.get_init_ok()) << c.fen;
+		EXPECT_EQ(game.see(c.move), c.value) << c.fen;
+		EXPECT_TRUE(game.see_ge(c.move, c.value)) << c.fen;
+		EXPECT_FALSE(game.see_ge(c.move, c.value + 1)) << c.fen;
+		game.set_coverage_mode(CoverageMode::ON_DEMAND);
+		EXPECT_EQ(game.see(c.move), c.value) << c.fen;
+	}
+	// not legal
+	EXPECT_EQ(Game().see(GameMove(12, 36)), 0);
+	EXPECT_FALSE(Game().see_ge(GameMove(12, 36), 1));
+
+	// see_ge agrees with see for every legal move of random games
+	std::mt19937_64 rng(3);
+	Game game("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1");
+	for (int ply = 0; ply < 200 && !game.get_game_has_ended(); ply++) {
+		const std::vector<GameMove> moves = game.get_possible_moves();
+		for (const GameMove& m : moves) {
+			const int value = game.see(m);
+			ASSERT_TRUE(game.see_ge(m, value)) << game.get_fen() << " " << m.from << " " << m.to;
+			ASSERT_FALSE(game.see_ge(m, value + 1)) << game.get_fen() << " " << m.from << " " << m.to;
+		}
+		game.move(moves[rng() % moves.size()]);
+	}
+}
@@ -0,0 +1,105 @@
+#include "Mcts.h"
+
+#include "gtest/gtest.h"
+
+
+TEST(Mcts, Search) {
+	Game game;
+	MctsConfig config;
+	config.max_nodes = 1 << 14;
+	config.max_playout_plies = 40;
+	MctsSearch search(config);
+	PlayerLimits limits;
+	limits.nodes = 2000;
+	const MctsResult result = search.search(game, limits);
+
+	EXPECT_EQ(result.playouts, 2000u);
+	EXPECT_EQ(search.get_node(0).visits, 2000u);
+	EXPECT_EQ(result.children.size(), 20u);
+	EXPECT_GT(result.nodes, 20u);
+	EXPECT_GT(result.playouts_per_sec(), 0.0);
+	uint32_t visits = 0;
+	for (const MctsRootChild& child : result.children) {
+		visits += child.visits;
+		EXPECT_GE(child.score, 0.0);
+		EXPECT_LE(child.score, 1.0);
+	}
+	EXPECT_EQ(visits, 2000u);
+	EXPECT_TRUE(result.best_move == result.children.front().move);
+
+	// the searched game is not touched
+	EXPECT_EQ(game, Game());
+
+	// arena reuse: the next search starts from an empty tree
+	const MctsResult again = search.search(game, limits);
+	EXPECT_EQ(search.get_node(0).visits, 2000u);
+	EXPECT_EQ(again.playouts, 2000u);
+}
+
+TEST(Mcts, FullArena) {
+	// leaves stop being expanded once the arena is full, the node count stays within it
+	Game game;
+	MctsConfig config;
+	config.max_nodes = 100;
+	config.max_playout_plies = 20;
+	MctsSearch search(config);
+	PlayerLimits limits;
+	limits.nodes = 3000;
+	const MctsResult result = search.search(game, limits);
+	EXPECT_EQ(result.playouts, 3000u);
+	EXPECT_LE(search.size(), config.max_nodes);
+	EXPECT_LE(result.nodes, config.max_nodes);
+	EXPECT_GT(result.nodes, 20u);
+}
+
+TEST(Mcts, FindsMate) {
+	// back rank mate, every other move loses the rook or lets black escape
+	Game game("6k1/5ppp/8/8/8/8/5PPP/R5K1 w - - 0 1");
+	MctsSearch search;
+	PlayerLimits limits;
+	limits.nodes = 5000;
+	EXPECT_TRUE(search.search(game, limits).best_move == GameMove(Position{ 0, 0 }, Position{ 0, 7 }));
+
+	// no moves to search after the game has ended
+	game.move("a1a8");
+	const MctsResult result = search.search(game, limits);
+	EXPECT_EQ(result.playouts, 0u);
+	EXPECT_TRUE(result.children.empty());
+}
+
+TEST(Mcts, TreeParallel) {
+	Game game("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1");
+	const Game copy(game);
+	MctsConfig config;
+	config.threads = 4;
+	config.max_nodes = 1 << 16;
+	config.max_playout_plies = 40;
+	MctsSearch search(config);
+	PlayerLimits limits;
+	limits.nodes = 4000;
+	const MctsResult result = search.search(game, limits);
+
+	// every started playout is backed up exactly once and no virtual loss is left behind
+	EXPECT_EQ(result.playouts, 4000u);
+	EXPECT_EQ(search.get_node(0).visits, 4000u);
+	EXPECT_EQ(result.children.size(), 48u);
+	for (uint32_t id = 0; id < search.size(); id++) EXPECT_EQ(search.get_node(id).virtual_loss, 0u);
+	EXPECT_EQ(game, copy);
+
+	// a time limit alone stops the search
+	PlayerLimits time;
+	time.move_time_ms = 20;
+	EXPECT_GT(search.search(game, time).playouts, 0u);
+}
+
+TEST(Mcts, Player) {
+	std::unique_ptr<IGamePlayer> player = make_player("mcts");
+	ASSERT_TRUE(player);
+	player->new_game(7);
+	Game game;
+	PlayerLimits limits;
+	limits.nodes = 100;
+	for (int i = 0; i < 6; i++) {
+		EXPECT_NE(game.move(player->choose_move(game, limits)), GameState::INVALID_MOVE);
+	}
+}
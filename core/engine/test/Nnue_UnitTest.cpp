@@ -0,0 +1,133 @@
+#include "Nnue.h"
+#include "Game.h"
+
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <random>
+
+
+// writes a network with random weights in the NnueNetwork file layout
+static std::string write_random_network(uint64_t seed)
+{
+	const std::string path = (std::filesystem::temp_directory_path() / ("nnue_test_" + std::to_string(seed) + ".bin")).string();
+	std::mt19937_64 rng(seed);
+	std::uniform_int_distribution<int> small(-32, 32);
+	std::uniform_int_distribution<int> int8(-128, 127);
+
+	std::string data(NNUE_MAGIC, 4);
+	const auto append = [&data](const auto& value) { data.append(reinterpret_cast<const char*>(&value), sizeof(value)); };
+	append(uint32_t(NNUE_VERSION));
+	append(uint32_t(NNUE_FEATURES));
+	append(uint16_t(NNUE_L1));
+	append(uint16_t(NNUE_L2));
+	for (int i = 0; i < NNUE_L1; i++) append(int16_t(small(rng) * 4));
+	for (int i = 0; i < NNUE_FEATURES * NNUE_L1; i++) append(int16_t(small(rng)));
+	for (int i = 0; i < NNUE_L2; i++) append(int32_t(small(rng) * 64));
+	for (int i = 0; i < NNUE_L2 * 2 * NNUE_L1; i++) append(int8_t(int8(rng)));
+	append(int32_t(100));
+	for (int i = 0; i < NNUE_L2; i++) append(int8_t(int8(rng)));
+
+	std::ofstream(path, std::ios::binary).write(data.data(), data.size());
+	return path;
+}
+
+// plain reimplementation of the evaluation to check the kernels
+static int reference_evaluate(const std::string& data, const NnueAccumulator& accumulator, bool white_to_move)
+{
+	const auto read_i32 = [&data](size_t at) { int32_t v; std::memcpy(&v, data.data() + at, 4); return v; };
+
+	std::vector<int> input;
+	for (const bool perspective : { white_to_move, !white_to_move }) {
+		for (const int16_t v : accumulator.get_values(perspective)) input.push_back(std::clamp<int>(v, 0, 127));
+	}
+	const size_t hidden_bias = 16 + sizeof(int16_t) * NNUE_L1 * (1 + static_cast<size_t>(NNUE_FEATURES));
+	const size_t hidden_weights = hidden_bias + 4 * NNUE_L2;
+	const size_t output_bias = hidden_weights + NNUE_L2 * 2 * NNUE_L1;
+	int output = read_i32(output_bias);
+	for (int i = 0; i < NNUE_L2; i++) {
+		int sum = read_i32(hidden_bias + 4 * i);
+		for (int j = 0; j < 2 * NNUE_L1; j++) sum += input[j] * static_cast<int8_t>(data[hidden_weights + i * 2 * NNUE_L1 + j]);
+		output += std::clamp(sum >> NNUE_HIDDEN_SHIFT, 0, 127) * static_cast<int8_t>(data[output_bias + 4 + i]);
+	}
+	return output / NNUE_OUTPUT_SCALE;
+}
+
+// accumulator of the same position built from scratch
+static bool matches_refresh(const NnueNetwork& network, const NnueAccumulator& accumulator, const Game& game)
+{
+	char fen[GAME_FEN_LEN_MAX];
+	game.to_fen(fen, GAME_FEN_LEN_MAX);
+	Game fresh(fen);
+	NnueAccumulator expected(network);
+	fresh.set_accumulator(&expected);
+	return accumulator.get_values(true) == expected.get_values(true) && accumulator.get_values(false) == expected.get_values(false);
+}
+
+TEST(Nnue, Load) {
+	const std::string path = write_random_network(1);
+	NnueNetwork network;
+	EXPECT_FALSE(network.load(path + ".missing"));
+	EXPECT_FALSE(network.is_loaded());
+	ASSERT_TRUE(network.load(path));
+	EXPECT_TRUE(network.is_loaded());
+
+	// truncated file
+	const std::string truncated = path + ".truncated";
+	std::filesystem::copy_file(path, truncated, std::filesystem::copy_options::overwrite_existing);
+	std::filesystem::resize_file(truncated, std::filesystem::file_size(path) - 1);
+	NnueNetwork broken;
+	EXPECT_FALSE(broken.load(truncated));
+	std::filesystem::remove(truncated);
+
+	// features mirror between the perspectives
+	EXPECT_EQ(NnueNetwork::feature(true, 4, Piece::PAWN, true, 12), NnueNetwork::feature(false, 60, Piece::PAWN, false, 52));
+	EXPECT_NE(NnueNetwork::feature(true, 4, Piece::PAWN, true, 12), NnueNetwork::feature(true, 4, Piece::PAWN, false, 12));
+	EXPECT_EQ(NnueNetwork::feature(true, 63, Piece::PAWN, false, 63), NNUE_FEATURES - 1);
+}
+
+TEST(Nnue, IncrementalUpdates) {
+	const std::string path = write_random_network(2);
+	NnueNetwork network;
+	ASSERT_TRUE(network.load(path));
+	std::ifstream file(path, std::ios::binary);
+	const std::string data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+	// castles, en passant and promotions with captures appear in random games from these positions
+	const char* fens[] = {
+		GAME_DEFAULT_FEN,
+		"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+		"r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+		"8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+	};
+	std::mt19937_64 rng(3);
+	for (const char* fen : fens) {
+		Game game(fen);
+		NnueAccumulator accumulator(network);
+		game.set_accumulator(&accumulator);
+		ASSERT_TRUE(matches_refresh(network, accumulator, game));
+
+		for (int ply = 0; ply < 80 && !game.get_game_has_ended(); ply++) {
+			const std::vector<GameMove> moves = game.get_possible_moves();
+			game.move(moves[rng() % moves.size()]);
+			ASSERT_TRUE(matches_refresh(network, accumulator, game)) << fen << " ply " << ply;
+			ASSERT_EQ(accumulator.get_depth(), ply + 1);
+			const bool white = game.get_active_color().IsWhite();
+			ASSERT_EQ(network.evaluate(accumulator, white), reference_evaluate(data, accumulator, white));
+		}
+		// undo pops the frames, seek restores a checkpoint and refreshes
+		game.undo();
+		game.undo();
+		EXPECT_TRUE(matches_refresh(network, accumulator, game));
+		game.seek(3);
+		EXPECT_TRUE(matches_refresh(network, accumulator, game));
+		game.new_game();
+		EXPECT_TRUE(matches_refresh(network, accumulator, game));
+		EXPECT_EQ(accumulator.get_depth(), 0);
+	}
+	file.close();
+	std::filesystem::remove(path);
+}
@@ -0,0 +1,157 @@
+#include "PgnReader.h"
+#include "MappedFile.h"
+
+#include "gtest/gtest.h"
+
+#include <cstdio>
+#include <fstream>
+#include <mutex>
+#include <vector>
+
+
+static const char* PGN_TWO_GAMES =
+	"[Event \"Casual\"]\n"
+	"[White \"A \\\"B\\\" C\"]\n"
+	"[Result \"1-0\"]\n"
+	"\n"
+	"1. e4 {best by test} e5 2.Nf3 (2. f4 exf4 (2... d5) 3. Nf3) 2... Nc6 $1 ; line comment\n"
+	"3. Bb5 a6 1-0\n"
+	"\n"
+	"[Event \"Second\"]\n"
+	"[FEN \"4k3/8/8/8/8/8/8/4K2R w K - 0 1\"]\n"
+	"\n"
+	"1. O-O Kd7 *\n";
+
+static std::vector<std::string_view> tokens(std::string_view movetext, std::string_view* result = nullptr)
+{
+	std::vector<std::string_view> out;
+	PgnMoveTokenizer tokenizer(movetext);
+	std::string_view san;
+	while (tokenizer.next(san)) out.push_back(san);
+	if (result) *result = tokenizer.get_result();
+	return out;
+}
+
+TEST(PgnReader, Tokenizer) {
+	std::string_view result;
+	EXPECT_EQ(tokens("1. e4 {best by test} e5 2.Nf3 (2. f4 exf4 (2... d5) 3. Nf3) 2... Nc6 $1 ; comment\n3. Bb5 a6 1-0", &result),
+		(std::vector<std::string_view>{ "e4", "e5", "Nf3", "Nc6", "Bb5", "a6" }));
+	EXPECT_EQ(result, "1-0");
+
+	EXPECT_EQ(tokens("1. 0-0 0-0-0 0-1", &result), (std::vector<std::string_view>{ "0-0", "0-0-0" }));
+	EXPECT_EQ(result, "0-1");
+
+	EXPECT_EQ(tokens("12... exd8=Q+ 13. Qxd8#! 1/2-1/2", &result), (std::vector<std::string_view>{ "exd8=Q+", "Qxd8#!" }));
+	EXPECT_EQ(result, "1/2-1/2");
+
+	EXPECT_EQ(tokens("1. d4 d5", &result), (std::vector<std::string_view>{ "d4", "d5" }));
+	EXPECT_EQ(result, "");
+}
+
+TEST(PgnReader, Games) {
+	PgnReader reader(PGN_TWO_GAMES);
+	PgnGame game;
+
+	ASSERT_TRUE(reader.next(game));
+	EXPECT_EQ(game.index, 0);
+	EXPECT_EQ(game.tag_count, 3);
+	EXPECT_EQ(game.get_tag("Event"), "Casual");
+	EXPECT_EQ(game.get_tag("White"), "A \\\"B\\\" C");
+	EXPECT_EQ(game.get_tag("Result"), "1-0");
+	EXPECT_EQ(game.get_tag("FEN"), "");
+	EXPECT_EQ(game.movetext.substr(0, 5), "1. e4");
+	EXPECT_EQ(game.movetext.substr(game.movetext.size() - 3), "1-0");
+
+	ASSERT_TRUE(reader.next(game));
+	EXPECT_EQ(game.index, 1);
+	EXPECT_EQ(game.tag_count, 2);
+	EXPECT_EQ(game.get_tag("FEN"), "4k3/8/8/8/8/8/8/4K2R w K - 0 1");
+	EXPECT_EQ(game.movetext, "1. O-O Kd7 *");
+
+	EXPECT_FALSE(reader.next(game));
+}
+
+TEST(PgnReader, Replay) {
+	PgnReader reader(PGN_TWO_GAMES);
+	PgnGame pgn;
+	Game game;
+
+	ASSERT_TRUE(reader.next(pgn));
+	PgnReplay replay = pgn_replay(pgn, game);
+	EXPECT_TRUE(replay.ok);
+	EXPECT_EQ(replay.plies, 6);
+	EXPECT_EQ(replay.result, "1-0");
+	EXPECT_EQ(game.get_fen(), "r1bqkbnr/1ppp1ppp/p1n5/1B2p3/4P3/5N2/PPPP1PPP/RNBQK2R w KQkq - 0 4");
+
+	ASSERT_TRUE(reader.next(pgn));
+	replay = pgn_replay(pgn, game);
+	EXPECT_TRUE(replay.ok);
+	EXPECT_EQ(replay.plies, 2);
+	EXPECT_EQ(replay.result, "*");
+	EXPECT_EQ(game.get_fen(), "8/3k4/8/8/8/8/8/5RK1 w - - 2 2");
+
+	PgnReader broken("[Event \"?\"]\n\n1. e4 e5 2. Ke3 Nf6 *\n");
+	ASSERT_TRUE(broken.next(pgn));
+	replay = pgn_replay(pgn, game);
+	EXPECT_FALSE(replay.ok);
+	EXPECT_EQ(replay.plies, 2);
+	EXPECT_EQ(replay.failed_move, "Ke3");
+}
+
+TEST(PgnReader, Split) {
+	std::string text;
+	for (int i = 0; i < 50; i++) {
+		text += "[Event \"" + std::to_string(i) + "\"]\n[Site \"?\"]\n\n1. e4 { [not a tag] } e5 *\n\n";
+	}
+	for (int parts : { 1, 2, 3, 7, 64 }) {
+		const std::vector<std::string_view> chunks = pgn_split(text, parts);
+		EXPECT_LE(static_cast<int>(chunks.size()), parts);
+		size_t total = 0;
+		int games = 0;
+		for (std::string_view chunk : chunks) {
+			EXPECT_EQ(chunk.substr(0, 7), "[Event ");
+			total += chunk.size();
+			PgnReader reader(chunk);
+			PgnGame game;
+			while (reader.next(game)) {
+				EXPECT_EQ(game.get_tag("Event"), std::to_string(games));
+				games++;
+			}
+		}
+		EXPECT_EQ(total, text.size());
+		EXPECT_EQ(games, 50);
+	}
+}
+
+TEST(PgnReader, ParallelIndices) {
+	std::string text;
+	for (int i = 0; i < 40; i++) {
+		text += "[Event \"" + std::to_string(i) + "\"]\n\n*\n\n";
+	}
+	std::mutex mutex;
+	std::vector<int> seen(40, 0);
+	const PgnStats stats = pgn_read(text, [&](const PgnGame& pgn, const Game&, const PgnReplay& replay) {
+		std::lock_guard<std::mutex> lock(mutex);
+		EXPECT_EQ(pgn.get_tag("Event"), std::to_string(pgn.index));
+		EXPECT_TRUE(replay.ok);
+		seen[pgn.index]++;
+	}, 4);
+	EXPECT_EQ(stats.games, 40);
+	EXPECT_EQ(stats.errors, 0);
+	for (int count : seen) EXPECT_EQ(count, 1);
+}
+
+TEST(PgnReader, MappedFile) {
+	const std::string path = "pgn_reader_test.pgn";
+	{
+		std::ofstream out(path, std::ios::binary);
+		out << PGN_TWO_GAMES;
+	}
+	{
+		MappedFile file(path);
+		ASSERT_TRUE(file.is_open());
+		EXPECT_EQ(file.view(), PGN_TWO_GAMES);
+	}
+	std::remove(path.c_str());
+	EXPECT_FALSE(MappedFile("does_not_exist.pgn").is_open());
+}
@@ -0,0 +1,89 @@
+#include "PositionIndex.h"
+#include "Game.h"
+
+#include "gtest/gtest.h"
+
+#include <cstdio>
+#include <string>
+
+
+TEST(PositionIndex, ZobristIncremental) {
+	// castles, captures, en passant and promotion; the incremental key must match a fresh parse
+	Game game("r3k2r/6P1/8/8/3p4/8/4P3/R3K2R w KQkq - 0 1");
+	const uint64_t start_hash = game.get_hash();
+	for (const char* uci : { "e2e4", "d4e3", "e1g1", "e8c8", "g7g8q", "h8g8", "g1h1", "d8d1", "f1d1" }) {
+		ASSERT_NE(game.move(uci), GameState::INVALID_MOVE) << uci;
+		EXPECT_EQ(game.get_hash(), Game(game.get_fen()).get_hash()) << uci;
+	}
+	for (int i = 0; i < 9; i++) game.undo();
+	EXPECT_EQ(game.get_hash(), start_hash);
+
+	// transpositions hash equal, side to move and castle rights do not
+	Game a{}, b{};
+	for (const char* uci : { "g1f3", "g8f6", "b1c3" }) a.move(uci);
+	for (const char* uci : { "b1c3", "g8f6", "g1f3" }) b.move(uci);
+	EXPECT_EQ(a.get_hash(), b.get_hash());
+	EXPECT_NE(Game().get_hash(), Game("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR b KQkq - 0 1").get_hash());
+	EXPECT_NE(Game().get_hash(), Game("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w Kkq - 0 1").get_hash());
+	// an en passant square only counts if it can be captured
+	EXPECT_EQ(Game("4k3/8/8/8/4P3/8/8/4K3 b - e3 0 1").get_hash(), Game("4k3/8/8/8/4P3/8/8/4K3 b - - 0 1").get_hash());
+	EXPECT_NE(Game("4k3/8/8/8/3pP3/8/8/4K3 b - e3 0 1").get_hash(), Game("4k3/8/8/8/3pP3/8/8/4K3 b - - 0 1").get_hash());
+}
+
+TEST(PositionIndex, BuildAndFind) {
+	std::string pgn;
+	const char* games[] = { "1. e4 e5 2. Nf3 Nc6 *", "1. Nf3 Nc6 2. e4 e5 *", "1. d4 d5 *", "1. e4 c5 2. Nf3 *" };
+	int postings = 0;
+	for (int i = 0; i < 40; i++) {
+		pgn += "[Event \"" + std::to_string(i) + "\"]\n\n" + games[i % 4] + "\n\n";
+		postings += i % 4 == 2 ? 3 : (i % 4 == 3 ? 4 : 5);
+	}
+	const std::string path = "position_index_test.idx";
+
+	for (int threads : { 1, 3 }) {
+		// small runs to force external merging
+		ASSERT_TRUE(build_position_index(pgn, path, threads, 7));
+		PositionIndex index(path);
+		ASSERT_TRUE(index.is_open());
+		EXPECT_EQ(index.size(), postings);
+		EXPECT_TRUE(std::is_sorted(index.get_postings().begin(), index.get_postings().end()));
+
+		EXPECT_EQ(index.find(Game().get_hash()).size(), 40);
+
+		Game e4{};
+		e4.move("e2e4");
+		const std::span<const PositionPosting> e4_postings = index.find(e4.get_hash());
+		EXPECT_EQ(e4_postings.size(), 20);
+		for (const PositionPosting& posting : e4_postings) {
+			EXPECT_TRUE(posting.game % 4 == 0 || posting.game % 4 == 3);
+			EXPECT_EQ(posting.ply, 1);
+		}
+
+		// transposition reached at ply 4 in both orders
+		Game open{};
+		for (const char* uci : { "e2e4", "e7e5", "g1f3", "b8c6" }) open.move(uci);
+		const std::span<const PositionPosting> open_postings = index.find(open.get_hash());
+		ASSERT_EQ(open_postings.size(), 20);
+		EXPECT_EQ(open_postings[0].game, 0);
+		EXPECT_EQ(open_postings[1].game, 1);
+
+		EXPECT_TRUE(index.find(0).empty());
+	}
+	std::remove(path.c_str());
+	EXPECT_FALSE(PositionIndex("position_index_missing.idx").is_open());
+
+	// a run that can not be read fails the build without leaving a partial index
+	{
+		PositionIndexBuilder builder(path, 2);
+		std::vector<PositionPosting> run = { { 1, 0, 0 }, { 2, 0, 1 } };
+		ASSERT_TRUE(builder.spill(run));
+		run = { { 3, 1, 0 } };
+		ASSERT_TRUE(builder.spill(run));
+		std::remove((path + ".run1").c_str());
+		EXPECT_FALSE(builder.finish());
+	}
+	EXPECT_FALSE(PositionIndex(path).is_open());
+	std::FILE* index_file = std::fopen(path.c_str(), "rb");
+	EXPECT_EQ(index_file, nullptr);
+	if (index_file) std::fclose(index_file);
+}
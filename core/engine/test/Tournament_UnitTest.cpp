@@ -0,0 +1,80 @@
+#include "Tournament.h"
+
+#include "gtest/gtest.h"
+
+#include <set>
+
+
+TEST(Tournament, OpeningToFen) {
+	EXPECT_EQ(opening_to_fen("rnbqkbnr/pppppppp/8/8/4P3/8/PPPP1PPP/RNBQKBNR b KQkq e3 0 1"),
+		"rnbqkbnr/pppppppp/8/8/4P3/8/PPPP1PPP/RNBQKBNR b KQkq e3 0 1");
+	EXPECT_EQ(opening_to_fen("r3k2r/8/8/8/8/8/8/R3K2R w KQkq - bm O-O; id \"castles\";"), "r3k2r/8/8/8/8/8/8/R3K2R w KQkq - 0 1");
+	EXPECT_EQ(opening_to_fen("  8/8/8/8/8/8/8/K6k w - -\r"), "8/8/8/8/8/8/8/K6k w - - 0 1");
+	EXPECT_EQ(opening_to_fen("8/8/8/8 w -"), "");
+}
+
+TEST(Tournament, MaterialPlayer) {
+	// takes the hanging queen
+	Game game("4k3/8/8/3q4/8/8/8/3RK3 w - - 0 1");
+	MaterialPlayer player(1);
+	EXPECT_TRUE(player.choose_move(game, PlayerLimits()) == GameMove(Position{ 3, 0 }, Position{ 3, 4 }));
+	EXPECT_EQ(game.get_ply(), 0);
+
+	// finds the back rank mate instead of the material
+	Game mate("6k1/5ppp/8/8/8/8/1q3PPP/R5K1 w - - 0 1");
+	MaterialPlayer player2(2);
+	EXPECT_TRUE(player2.choose_move(mate, PlayerLimits()) == GameMove(Position{ 0, 0 }, Position{ 0, 7 }));
+
+	// node limited search still returns a legal move
+	PlayerLimits limits;
+	limits.nodes = 10;
+	MaterialPlayer player3(4);
+	EXPECT_NE(game.move(player3.choose_move(game, limits)), GameState::INVALID_MOVE);
+
+	EXPECT_TRUE(make_player("material:3"));
+	EXPECT_TRUE(make_player("random"));
+	EXPECT_FALSE(make_player("material:x"));
+	EXPECT_FALSE(make_player("alphazero"));
+}
+
+TEST(Tournament, Run) {
+	TournamentConfig config;
+	config.openings = { GAME_DEFAULT_FEN, "4k3/8/8/8/8/8/4P3/4K3 w - - 0 1", "invalid" };
+	config.games_per_opening = 4;
+	config.threads = 4;
+	config.max_plies = 60;
+	Tournament tournament(MaterialPlayer(1), RandomPlayer(), config);
+	EXPECT_EQ(tournament.get_game_count(), 12);
+
+	std::set<int> indices;
+	const TournamentResult result = tournament.run([&](int index, const std::string& pgn) {
+		EXPECT_TRUE(indices.insert(index).second);
+		EXPECT_NE(pgn.find("[Round \"" + std::to_string(index + 1) + "\"]"), std::string::npos);
+		EXPECT_EQ(pgn.find("[Result \"*\"]"), std::string::npos);
+	});
+	EXPECT_EQ(result.games(), 8);
+	EXPECT_EQ(result.errors, 4);
+	EXPECT_EQ(indices.size(), 8u);
+
+	// same seed, same games
+	Tournament again(MaterialPlayer(1), RandomPlayer(), config);
+	const TournamentResult result2 = again.run();
+	EXPECT_EQ(result.wins, result2.wins);
+	EXPECT_EQ(result.draws, result2.draws);
+}
+
+TEST(Tournament, Elo) {
+	TournamentResult even;
+	even.wins = 10;
+	even.losses = 10;
+	EXPECT_NEAR(even.elo(), 0.0, 1e-9);
+	EXPECT_GT(even.elo_error(), 0.0);
+
+	TournamentResult better;
+	better.wins = 3;
+	better.draws = 0;
+	better.losses = 1;
+	EXPECT_NEAR(better.elo(), 190.85, 0.01);
+	better.losses = 0;
+	EXPECT_EQ(better.elo(), 1200.0);
+}
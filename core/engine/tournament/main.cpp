@@ -0,0 +1,95 @@
+#include "Tournament.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <string>
+
+
+static void print_usage()
+{
+	std::printf(
+		"usage: ChessTournament [options]\n"
+		"  --first=<player>     first player (default material:2)\n"
+		"  --second=<player>    second player (default random)\n"
+		"                       players: random, material[:depth], mcts\n"
+		"  --openings=<path>    epd/fen file with one start position per line (default start position)\n"
+		"  --games=<n>          games per opening, colors alternate (default 2)\n"
+		"  --threads=<n>        worker threads (default one per core)\n"
+		"  --nodes=<n>          node limit per move (default none)\n"
+		"  --movetime=<ms>      time limit per move (default none)\n"
+		"  --max-plies=<n>      adjudicate longer games as draw (default 400)\n"
+		"  --seed=<n>           seed of the random choices (default 1)\n"
+		"  --pgn=<path>         append finished games to path\n");
+}
+
+static bool parse_option(const char* arg, const char* name, std::string& value)
+{
+	const size_t n = std::strlen(name);
+	if (std::strncmp(arg, name, n) != 0 || arg[n] != '=') return false;
+	value = arg + n + 1;
+	return true;
+}
+
+int main(int argc, char** argv)
+{
+	std::string first_name = "material:2";
+	std::string second_name = "random";
+	std::string openings_path;
+	std::string pgn_path;
+	TournamentConfig config;
+
+	for (int i = 1; i < argc; i++) {
+		std::string value;
+		if (parse_option(argv[i], "--first", value)) first_name = value;
+		else if (parse_option(argv[i], "--second", value)) second_name = value;
+		else if (parse_option(argv[i], "--openings", value)) openings_path = value;
+		else if (parse_option(argv[i], "--games", value)) config.games_per_opening = std::atoi(value.c_str());
+		else if (parse_option(argv[i], "--threads", value)) config.threads = std::atoi(value.c_str());
+		else if (parse_option(argv[i], "--nodes", value)) config.limits.nodes = std::strtoull(value.c_str(), nullptr, 10);
+		else if (parse_option(argv[i], "--movetime", value)) config.limits.move_time_ms = std::atoi(value.c_str());
+		else if (parse_option(argv[i], "--max-plies", value)) config.max_plies = std::atoi(value.c_str());
+		else if (parse_option(argv[i], "--seed", value)) config.seed = std::strtoull(value.c_str(), nullptr, 10);
+		else if (parse_option(argv[i], "--pgn", value)) pgn_path = value;
+		else {
+			print_usage();
+			return 1;
+		}
+	}
+
+	const std::unique_ptr<IGamePlayer> first = make_player(first_name);
+	const std::unique_ptr<IGamePlayer> second = make_player(second_name);
+	if (!first || !second) {
+		std::printf("unknown player %s\n", first ? second_name.c_str() : first_name.c_str());
+		return 1;
+	}
+	if (!openings_path.empty() && !read_openings(openings_path, config.openings)) {
+		std::printf("could not read %s\n", openings_path.c_str());
+		return 1;
+	}
+	std::ofstream pgn_file;
+	if (!pgn_path.empty()) {
+		pgn_file.open(pgn_path, std::ios::app);
+		if (!pgn_file) {
+			std::printf("could not open %s\n", pgn_path.c_str());
+			return 1;
+		}
+	}
+
+	Tournament tournament(*first, *second, config);
+	std::printf("%s vs %s, %d games\n", first->get_name().c_str(), second->get_name().c_str(), tournament.get_game_count());
+	int finished = 0;
+	const auto start = std::chrono::steady_clock::now();
+	const TournamentResult result = tournament.run([&](int /*index*/, const std::string& pgn) {
+		if (pgn_file) pgn_file << pgn << '\n' << std::flush;
+		if (++finished % 100 == 0) std::printf("%d games\n", finished);
+	});
+	const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	std::printf("+%d =%d -%d (%d errors), score %.1f%%\n", result.wins, result.draws, result.losses, result.errors, result.score() * 100.0);
+	std::printf("elo %+.1f +- %.1f\n", result.elo(), result.elo_error());
+	std::printf("%.2f s, %.1f games/sec\n", seconds, seconds > 0.0 ? result.games() / seconds : 0.0);
+	return 0;
+}
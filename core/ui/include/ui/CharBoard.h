@@ -5,6 +5,7 @@
 
 #include <memory>
 #include <vector>
+#include <span>
 #include <array>
 #include <filesystem>
 
@@ -28,7 +29,7 @@ public:
 	CharBoard(int x, int y, BoardSize b, std::filesystem::path path_to_res, bool hlines = true, bool vlines = true, bool description = true);
 
 	void draw(CharDisplay* display, const std::vector<TileP>& all_tiles) const;
-	void draw_delta(CharDisplay* display, const std::vector<TileP>& delta_tiles) const;
+	void draw_delta(CharDisplay* display, std::span<const TileP> delta_tiles) const;
 	
 	void set_size(BoardSize s);
 	void set_grid(bool horizontal, bool vertical);
@@ -47,8 +48,8 @@ private:
 	void draw_board(CharDisplay* display) const;
 	void draw_board_full(CharDisplay* display) const;
 	void draw_board_partial(CharDisplay* display) const;
-	void draw_pieces(CharDisplay* display, const std::vector<TileP>& v) const;
-	void draw_pieces_partial(CharDisplay* display,const std::vector<TileP>& pieces) const;
+	void draw_pieces(CharDisplay* display, std::span<const TileP> v) const;
+	void draw_pieces_partial(CharDisplay* display, std::span<const TileP> pieces) const;
 	bool load_textures(const std::filesystem::path& path_to_dir);
 	bool load_texture(const std::filesystem::path& path_to_file);
 private:
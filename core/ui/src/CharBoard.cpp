@@ -53,7 +53,7 @@ void CharBoard::draw(CharDisplay* display, const std::vector<TileP>& all_tiles)
 	}
 }
 
-void CharBoard::draw_delta(CharDisplay* display, const std::vector<TileP>& delta_tiles) const
+void CharBoard::draw_delta(CharDisplay* display, std::span<const TileP> delta_tiles) const
 {
 	const int cdw = display->get_width();
 	const int cdh = display->get_height();
@@ -148,7 +148,7 @@ void CharBoard::draw_board_partial(CharDisplay* cd) const
 	return;
 }
 
-void CharBoard::draw_pieces(CharDisplay* cd, const std::vector<TileP>& v) const
+void CharBoard::draw_pieces(CharDisplay* cd, std::span<const TileP> v) const
 {
 	for (const TileP& tile : v) {
 		const MaskedTexture& ptex = get_piece_tex(tile.piece,tile.color);
@@ -166,7 +166,7 @@ void CharBoard::draw_pieces(CharDisplay* cd, const std::vector<TileP>& v) const
 	}
 }
 
-void CharBoard::draw_pieces_partial(CharDisplay* display, const std::vector<TileP>& pieces) const
+void CharBoard::draw_pieces_partial(CharDisplay* display, std::span<const TileP> pieces) const
 {
 	for (const TileP& tile : pieces) {
 		const MaskedTexture& ptex = get_piece_tex(tile.piece, tile.color);